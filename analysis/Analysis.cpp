@@ -0,0 +1,81 @@
+#include "Deviation.hpp"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+// Compares the panels' interpolation methods over many orientation pairs
+// instead of the one on screen. Needs no window, runs on every core.
+//
+//   InterpolationAnalysis [--pairs n | --grid n] [--samples n] [--seed n]
+//                         [--threads n] [--out summary.json]
+//                         [--csv histograms.csv]
+//
+// Random pairs are uniform over all orientations, --grid n takes every pair
+// of n^3 Euler angle triples instead, n is at most 20. The JSON goes to stdout without --out.
+
+namespace {
+void write(const std::string &path, const std::string &contents) {
+  std::ofstream out(path, std::ios::trunc);
+  if (!(out << contents))
+    throw std::runtime_error("Failed to write " + path);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  DeviationOptions options;
+  std::string outPath, csvPath;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (i + 1 == argc)
+        throw std::invalid_argument(arg);
+      std::string value = argv[++i];
+      if (arg == "--pairs")
+        options.pairs = std::stoull(value);
+      else if (arg == "--grid")
+        options.grid = std::stoi(value);
+      else if (arg == "--samples")
+        options.samples = std::stoi(value);
+      else if (arg == "--seed")
+        options.seed = std::stoull(value);
+      else if (arg == "--threads")
+        options.threads = static_cast<unsigned>(std::stoul(value));
+      else if (arg == "--out")
+        outPath = value;
+      else if (arg == "--csv")
+        csvPath = value;
+      else
+        throw std::invalid_argument(arg);
+    }
+  } catch (const std::logic_error &) {
+    std::cerr << "usage: " << argv[0]
+              << " [--pairs n | --grid n] [--samples n] [--seed n] [--threads n]"
+                 " [--out summary.json] [--csv histograms.csv]\n"
+                 "--grid takes at most "
+              << DeviationOptions::c_maxGrid << " steps per axis\n";
+    return 1;
+  }
+
+  try {
+    DeviationReport report = analyzeDeviation(options);
+    std::cerr << report.pairs << " pairs on " << report.threads << " threads in "
+              << report.seconds << " s\n";
+    std::ostringstream json;
+    writeDeviationJson(json, report);
+    if (outPath.empty())
+      std::cout << json.str();
+    else
+      write(outPath, json.str());
+    if (!csvPath.empty()) {
+      std::ostringstream csv;
+      writeDeviationCsv(csv, report);
+      write(csvPath, csv.str());
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,351 @@
+#include "Deviation.hpp"
+#include "Random.hpp"
+#include "Rotation.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+// fewest pairs in a block handed to a worker
+constexpr size_t c_grain = 1024;
+// partial results kept at once, plenty of blocks to balance any pool
+constexpr size_t c_maxBlocks = 4096;
+constexpr float c_pi = static_cast<float>(M_PI);
+
+constexpr const char *c_metricNames[DEVIATION_METRIC_COUNT] = {
+    "linear_time_deviation", "euler_time_deviation", "euler_mean_deviation",
+    "euler_path_deviation",  "linear_length_ratio",  "euler_length_ratio",
+    "gimbal_clearance"};
+
+struct Pair {
+  math137::Vector3f startEuler, endEuler;
+  math137::Quaternion startQuat, endQuat;
+};
+
+float unit(uint64_t &state) {
+  return static_cast<float>(Random::splitMix(state) >> 40) * 0x1.0p-24f;
+}
+
+// Shoemake, "Uniform Random Rotations", Graphics Gems III
+math137::Quaternion randomQuaternion(uint64_t &state) {
+  float u1 = unit(state), u2 = unit(state), u3 = unit(state);
+  float r1 = sqrtf(1.0f - u1), r2 = sqrtf(u1);
+  return {r2 * cosf(2.0f * c_pi * u3), r1 * sinf(2.0f * c_pi * u2),
+          r1 * cosf(2.0f * c_pi * u2), r2 * sinf(2.0f * c_pi * u3)};
+}
+
+math137::Vector3f gridAngles(int n, size_t index) {
+  int roll = static_cast<int>(index % n);
+  int pitch = static_cast<int>(index / n % n);
+  int yaw = static_cast<int>(index / n / n);
+  float step = 2.0f * c_pi / static_cast<float>(n);
+  float pitchStep = n > 1 ? c_pi / static_cast<float>(n - 1) : 0.0f;
+  return {-c_pi + step * roll, -0.5f * c_pi + pitchStep * pitch, -c_pi + step * yaw};
+}
+
+// every pair depends on its index alone, so results do not change with the
+// thread count or the chunking
+Pair makePair(const DeviationOptions &options, size_t index) {
+  Pair pair;
+  if (options.grid > 0) {
+    size_t orientations = static_cast<size_t>(options.grid) * options.grid * options.grid;
+    pair.startEuler = gridAngles(options.grid, index / orientations);
+    pair.endEuler = gridAngles(options.grid, index % orientations);
+    pair.startQuat = Rotation::eulerToQuaternion(pair.startEuler);
+    pair.endQuat = Rotation::eulerToQuaternion(pair.endEuler);
+  } else {
+    uint64_t state = options.seed ^ (index * 0xd1b54a32d192ed03ull);
+    pair.startQuat = randomQuaternion(state);
+    pair.endQuat = randomQuaternion(state);
+    pair.startEuler = Rotation::quaternionToEuler(pair.startQuat);
+    pair.endEuler = Rotation::quaternionToEuler(pair.endQuat);
+  }
+  return pair;
+}
+
+float dot(const float *a, const float *b) {
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+}
+
+// rotation angle between two unit quaternions, from the chord on both sides
+// so small angles keep their precision
+float angleBetween(const float *a, const float *b) {
+  float sign = dot(a, b) < 0.0f ? -1.0f : 1.0f;
+  float minus = 0.0f, plus = 0.0f;
+  for (int i = 0; i < 4; ++i) {
+    float d = a[i] - sign * b[i], s = a[i] + sign * b[i];
+    minus += d * d;
+    plus += s * s;
+  }
+  return 4.0f * atan2f(sqrtf(minus), sqrtf(plus));
+}
+
+void store(const math137::Vector3f &v, float *out) {
+  out[0] = v.x();
+  out[1] = v.y();
+  out[2] = v.z();
+}
+
+void store(const math137::Quaternion &q, float *out) {
+  out[0] = q.a;
+  out[1] = q.b;
+  out[2] = q.c;
+  out[3] = q.d;
+}
+
+using Metrics = std::array<DeviationMetric, DEVIATION_METRIC_COUNT>;
+
+Metrics emptyMetrics() {
+  Metrics metrics;
+  auto range = [&metrics](DeviationMetricId id, double low, double high) {
+    metrics[id].low = low;
+    metrics[id].high = high;
+  };
+  range(LINEAR_TIME_DEVIATION, 0.0, 0.25);
+  range(EULER_TIME_DEVIATION, 0.0, M_PI);
+  range(EULER_MEAN_DEVIATION, 0.0, M_PI);
+  range(EULER_PATH_DEVIATION, 0.0, M_PI);
+  range(LINEAR_LENGTH_RATIO, 0.99, 1.01);
+  range(EULER_LENGTH_RATIO, 1.0, 8.0);
+  range(GIMBAL_CLEARANCE, 0.0, M_PI_2);
+  return metrics;
+}
+
+// pairs interpolated together, one batch call per alpha covers all of them
+constexpr size_t c_lanes = 64;
+
+// working buffers of one chunk, sized for the sample count. The paths are
+// sample major, sample k of lane p at k * lanes + p.
+struct Paths {
+  std::vector<float> alphas, startEuler, endEuler, startQuat, endQuat;
+  std::vector<float> angles, euler, linear, spherical;
+
+  explicit Paths(int samples)
+      : alphas(samples), startEuler(c_lanes * 3), endEuler(c_lanes * 3),
+        startQuat(c_lanes * 4), endQuat(c_lanes * 4), angles(samples * c_lanes * 3),
+        euler(samples * c_lanes * 4), linear(samples * c_lanes * 4),
+        spherical(samples * c_lanes * 4) {
+    for (int k = 0; k < samples; ++k)
+      alphas[k] = static_cast<float>(k) / static_cast<float>(samples - 1);
+  }
+};
+
+void analyzePair(const Pair &pair, size_t index, const Paths &paths, size_t lane,
+                 size_t lanes, Metrics &metrics) {
+  int samples = static_cast<int>(paths.alphas.size());
+
+  // the great circle through both ends, spanned by the start and the part of
+  // the end orthogonal to it
+  float start[4], end[4], across[4];
+  store(pair.startQuat, start);
+  store(pair.endQuat, end);
+  float geodesic = angleBetween(start, end);
+  float along = dot(start, end), acrossLength = 0.0f;
+  for (int i = 0; i < 4; ++i) {
+    across[i] = end[i] - start[i] * along;
+    acrossLength += across[i] * across[i];
+  }
+  acrossLength = sqrtf(acrossLength);
+  for (float &v : across)
+    v = acrossLength > 1e-6f ? v / acrossLength : 0.0f;
+
+  size_t stride = lanes * 4;
+  float linearTime = 0.0f, eulerTime = 0.0f, eulerSum = 0.0f, eulerPath = 0.0f;
+  float linearLength = 0.0f, eulerLength = 0.0f, clearance = c_pi;
+  for (int k = 0; k < samples; ++k) {
+    size_t at = (k * lanes + lane) * 4;
+    const float *e = &paths.euler[at];
+    const float *n = &paths.linear[at];
+    const float *s = &paths.spherical[at];
+    linearTime = std::max(linearTime, angleBetween(n, s));
+    float deviation = angleBetween(e, s);
+    eulerTime = std::max(eulerTime, deviation);
+    eulerSum += deviation;
+
+    float u = dot(e, start), v = dot(e, across), off = 0.0f;
+    for (int i = 0; i < 4; ++i) {
+      float d = e[i] - u * start[i] - v * across[i];
+      off += d * d;
+    }
+    eulerPath = std::max(eulerPath, 2.0f * atan2f(sqrtf(off), sqrtf(u * u + v * v)));
+
+    if (k > 0) {
+      linearLength += angleBetween(n, n - stride);
+      eulerLength += angleBetween(e, e - stride);
+    }
+    float pitch = std::remainder(paths.angles[(k * lanes + lane) * 3 + 1], 2.0f * c_pi);
+    clearance = std::min(clearance, std::abs(std::abs(pitch) - 0.5f * c_pi));
+  }
+
+  metrics[LINEAR_TIME_DEVIATION].add(linearTime, index);
+  metrics[EULER_TIME_DEVIATION].add(eulerTime, index);
+  metrics[EULER_MEAN_DEVIATION].add(eulerSum / static_cast<float>(samples), index);
+  metrics[EULER_PATH_DEVIATION].add(eulerPath, index);
+  if (geodesic >= c_minGeodesic) {
+    metrics[LINEAR_LENGTH_RATIO].add(linearLength / geodesic, index);
+    metrics[EULER_LENGTH_RATIO].add(eulerLength / geodesic, index);
+  }
+  metrics[GIMBAL_CLEARANCE].add(clearance, index);
+}
+
+// up to c_lanes pairs from first on, their paths interpolated a whole alpha
+// at a time through the batch API and then measured one pair at a time
+void analyzePairs(const DeviationOptions &options, size_t first, size_t count, Paths &paths,
+                  Metrics &metrics) {
+  Pair pairs[c_lanes];
+  for (size_t p = 0; p < count; ++p) {
+    pairs[p] = makePair(options, first + p);
+    const Pair &pair = pairs[p];
+    store(pair.startEuler, &paths.startEuler[p * 3]);
+    store(pair.endEuler, &paths.endEuler[p * 3]);
+    store(pair.startQuat, &paths.startQuat[p * 4]);
+    store(pair.endQuat, &paths.endQuat[p * 4]);
+  }
+
+  std::span<const float> startEuler(paths.startEuler.data(), count * 3);
+  std::span<const float> endEuler(paths.endEuler.data(), count * 3);
+  std::span<const float> startQuat(paths.startQuat.data(), count * 4);
+  std::span<const float> endQuat(paths.endQuat.data(), count * 4);
+  size_t samples = paths.alphas.size();
+  for (size_t k = 0; k < samples; ++k) {
+    float alpha = paths.alphas[k];
+    Rotation::eulerLerp(startEuler, endEuler, alpha, {&paths.angles[k * count * 3], count * 3});
+    Rotation::nlerp(startQuat, endQuat, alpha, {&paths.linear[k * count * 4], count * 4});
+    Rotation::slerp(startQuat, endQuat, alpha, {&paths.spherical[k * count * 4], count * 4});
+  }
+  // the Euler panel's rotations, every sample of every lane in one call
+  Rotation::eulerToQuaternion({paths.angles.data(), samples * count * 3},
+                              {paths.euler.data(), samples * count * 4});
+
+  for (size_t p = 0; p < count; ++p)
+    analyzePair(pairs[p], first + p, paths, p, count, metrics);
+}
+
+void writeAngles(std::ostream &out, const math137::Vector3f &angles) {
+  out << "[" << angles.x() << ", " << angles.y() << ", " << angles.z() << "]";
+}
+} // namespace
+
+void DeviationMetric::add(double value, size_t pair) {
+  if (count == 0 || value < min)
+    min = value;
+  if (count == 0 || value > max) {
+    max = value;
+    worstPair = pair;
+  }
+  ++count;
+  sum += value;
+  double position = (value - low) / (high - low) * c_bins;
+  int bin = std::clamp(static_cast<int>(std::floor(position)), 0, c_bins - 1);
+  ++bins[bin];
+}
+
+void DeviationMetric::merge(const DeviationMetric &other) {
+  if (other.count == 0)
+    return;
+  if (count == 0 || other.min < min)
+    min = other.min;
+  // ties keep the lower pair, chunks merge in index order
+  if (count == 0 || other.max > max) {
+    max = other.max;
+    worstPair = other.worstPair;
+  }
+  count += other.count;
+  sum += other.sum;
+  for (int i = 0; i < c_bins; ++i)
+    bins[i] += other.bins[i];
+}
+
+DeviationReport analyzeDeviation(const DeviationOptions &options) {
+  if (options.samples < 2)
+    throw std::invalid_argument("a path needs at least 2 samples");
+  if (options.grid < 0 || options.grid > DeviationOptions::c_maxGrid)
+    throw std::invalid_argument("the grid is limited to " +
+                                std::to_string(DeviationOptions::c_maxGrid) +
+                                " steps per axis");
+
+  DeviationReport report;
+  report.options = options;
+  if (options.grid > 0) {
+    size_t orientations = static_cast<size_t>(options.grid) * options.grid * options.grid;
+    report.pairs = orientations * orientations;
+  } else {
+    report.pairs = options.pairs;
+  }
+
+  std::unique_ptr<ThreadPool> ownPool;
+  if (options.threads > 0)
+    ownPool = std::make_unique<ThreadPool>(options.threads - 1);
+  ThreadPool &pool = ownPool ? *ownPool : ThreadPool::shared();
+  report.threads = pool.getThreadCount();
+
+  // one set of metrics per block of pairs, merged in order afterwards so
+  // the sums come out the same on any number of threads. The block count
+  // is bounded, larger runs get longer blocks instead of more of them.
+  size_t blockSize = std::max(c_grain, (report.pairs + c_maxBlocks - 1) / c_maxBlocks);
+  size_t blocks = (report.pairs + blockSize - 1) / blockSize;
+  std::vector<Metrics> partial(blocks, emptyMetrics());
+  auto from = std::chrono::steady_clock::now();
+  pool.parallelFor(blocks, 1, [&](size_t block, size_t) {
+    Paths paths(options.samples);
+    Metrics &metrics = partial[block];
+    size_t last = std::min(report.pairs, (block + 1) * blockSize);
+    for (size_t i = block * blockSize; i < last; i += c_lanes)
+      analyzePairs(options, i, std::min(c_lanes, last - i), paths, metrics);
+  });
+  report.metrics = emptyMetrics();
+  for (const Metrics &metrics : partial)
+    for (int m = 0; m < DEVIATION_METRIC_COUNT; ++m)
+      report.metrics[m].merge(metrics[m]);
+  report.seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - from).count();
+  return report;
+}
+
+void writeDeviationJson(std::ostream &out, const DeviationReport &report) {
+  const DeviationOptions &options = report.options;
+  out << "{\n";
+  out << "  \"sampling\": \"" << (options.grid > 0 ? "grid" : "random") << "\", \"grid\": "
+      << options.grid << ", \"seed\": " << options.seed << ", \"pairs\": " << report.pairs
+      << ", \"samples\": " << options.samples << ",\n";
+  out << "  \"threads\": " << report.threads << ", \"seconds\": " << report.seconds
+      << ", \"pairs_per_s\": " << static_cast<double>(report.pairs) / report.seconds << ",\n";
+  out << "  \"metrics\": {\n";
+  for (int m = 0; m < DEVIATION_METRIC_COUNT; ++m) {
+    const DeviationMetric &metric = report.metrics[m];
+    out << "    \"" << c_metricNames[m] << "\": {\"count\": " << metric.count
+        << ", \"mean\": " << (metric.count ? metric.sum / metric.count : 0.0)
+        << ", \"min\": " << metric.min << ", \"max\": " << metric.max;
+    if (metric.count) {
+      Pair worst = makePair(options, metric.worstPair);
+      out << ",\n      \"worst_pair\": {\"index\": " << metric.worstPair << ", \"start_euler\": ";
+      writeAngles(out, worst.startEuler);
+      out << ", \"end_euler\": ";
+      writeAngles(out, worst.endEuler);
+      out << "}";
+    }
+    out << ",\n      \"histogram\": {\"low\": " << metric.low << ", \"high\": " << metric.high
+        << ", \"bins\": [";
+    for (int i = 0; i < DeviationMetric::c_bins; ++i)
+      out << (i ? ", " : "") << metric.bins[i];
+    out << "]}}" << (m + 1 < DEVIATION_METRIC_COUNT ? "," : "") << "\n";
+  }
+  out << "  }\n}\n";
+}
+
+void writeDeviationCsv(std::ostream &out, const DeviationReport &report) {
+  out << "metric,bin_low,bin_high,count\n";
+  for (int m = 0; m < DEVIATION_METRIC_COUNT; ++m) {
+    const DeviationMetric &metric = report.metrics[m];
+    double width = (metric.high - metric.low) / DeviationMetric::c_bins;
+    for (int i = 0; i < DeviationMetric::c_bins; ++i)
+      out << c_metricNames[m] << "," << metric.low + width * i << ","
+          << metric.low + width * (i + 1) << "," << metric.bins[i] << "\n";
+  }
+}
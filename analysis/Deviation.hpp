@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// How far the nlerp and Euler panels stray from slerp, the geodesic between
+// two orientations, measured over many start/end pairs. Angles are in
+// radians and measure whole rotations, not quaternion arcs.
+struct DeviationOptions {
+  // n^6 pairs, 64M at the cap, some 15 minutes on one core
+  static constexpr int c_maxGrid = 20;
+
+  // random pairs, uniform over all orientations
+  size_t pairs{1 << 20};
+  // above zero, every pair of an n x n x n grid of XYZ Euler angles instead,
+  // the pitch steps include both gimbal locks
+  int grid{0};
+  // points along every path, both ends included
+  int samples{33};
+  uint64_t seed{137};
+  // threads including the caller, 0 uses the shared pool
+  unsigned threads{0};
+};
+
+enum DeviationMetricId {
+  // largest angle between the method and slerp at the same alpha
+  LINEAR_TIME_DEVIATION,
+  EULER_TIME_DEVIATION,
+  // the same, averaged along the path
+  EULER_MEAN_DEVIATION,
+  // largest angle between the Euler path and the great circle through both
+  // ends, independent of timing
+  EULER_PATH_DEVIATION,
+  // path length over the geodesic angle, pairs closer than c_minGeodesic
+  // are left out
+  LINEAR_LENGTH_RATIO,
+  EULER_LENGTH_RATIO,
+  // closest the Euler path gets to a pitch of +-90 degrees
+  GIMBAL_CLEARANCE,
+  DEVIATION_METRIC_COUNT
+};
+
+struct DeviationMetric {
+  static constexpr int c_bins = 64;
+  // histogram range, values outside count towards the outer bins
+  double low{0.0};
+  double high{1.0};
+  uint64_t count{0};
+  double sum{0.0};
+  double min{0.0};
+  double max{0.0};
+  // the pair behind max
+  size_t worstPair{0};
+  std::array<uint64_t, c_bins> bins{};
+
+  void add(double value, size_t pair);
+  void merge(const DeviationMetric &other);
+};
+
+struct DeviationReport {
+  DeviationOptions options;
+  size_t pairs{0};
+  unsigned threads{0};
+  double seconds{0.0};
+  std::array<DeviationMetric, DEVIATION_METRIC_COUNT> metrics;
+};
+
+constexpr float c_minGeodesic = 1e-3f;
+
+DeviationReport analyzeDeviation(const DeviationOptions &options);
+// summary, histograms and the worst pair of every metric
+void writeDeviationJson(std::ostream &out, const DeviationReport &report);
+// the histograms, one row per bin
+void writeDeviationCsv(std::ostream &out, const DeviationReport &report);
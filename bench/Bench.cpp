@@ -0,0 +1,514 @@
+#include "AllocationCounter.hpp"
+#include "Camera.hpp"
+#include "CursorBatch.hpp"
+#include "FormatCheck.hpp"
+#include "Ground.hpp"
+#include "MeshPool.hpp"
+#include "PickCheck.hpp"
+#include "Renderer.hpp"
+#include "RotationCheck.hpp"
+#include "Scenario.hpp"
+#include "SimdCheck.hpp"
+#include "SkeletonCheck.hpp"
+#include "Simulation.hpp"
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Runs the app's simulation and render passes through scripted scenarios in
+// a hidden window and reports frame and pass timings as JSON. Time advances
+// on a fixed virtual clock, so the same scenario produces the same frames
+// on every run and only the measured times differ between builds.
+//
+//   InterpolationBench [--out results.json] [--checks-only]
+//                      [--expect-zero-allocations] [scenario script...]
+//
+// The rotation, picking, formats, simd and skeleton sections check the
+// conversion kernels, the picking hierarchy, the packed GPU formats, the
+// matrix and quaternion kernels and the rig's parallel instance packing
+// against scalar code, the last on every pool size up to the core count.
+// They need no GL, so --checks-only skips the scenarios and the window. A
+// mismatch, or an error above the tolerance of its report, fails the run
+// after the results are written.
+// --expect-zero-allocations fails the run when a measured frame of any
+// scenario reached the heap, warmup frames may still fill caches.
+
+namespace {
+constexpr double c_frameStep = 1.0 / 60.0;
+constexpr const char *c_defaultScript = "scenarios/default.txt";
+
+enum Pass { SIMULATE, SUBMIT, CURSORS, GROUND, FINISH, PASS_COUNT };
+constexpr const char *c_passNames[PASS_COUNT] = {"simulate", "submit",
+                                                 "cursors", "ground", "finish"};
+constexpr const char *c_lodNames[] = {"off", "cpu", "gpu"};
+
+using Clock = std::chrono::steady_clock;
+
+double milliseconds(Clock::time_point from, Clock::time_point to) {
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+struct Summary {
+  double mean, p50, p95, p99, max;
+};
+
+Summary summarize(std::vector<double> values) {
+  if (values.empty())
+    return {};
+  std::sort(values.begin(), values.end());
+  // nearest rank
+  auto rank = [&values](double p) {
+    size_t index = static_cast<size_t>(std::ceil(p * values.size()));
+    return values[std::clamp<size_t>(index, 1, values.size()) - 1];
+  };
+  double sum = 0.0;
+  for (double value : values)
+    sum += value;
+  return {sum / values.size(), rank(0.50), rank(0.95), rank(0.99), values.back()};
+}
+
+std::string escape(const std::string &text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '"' || c == '\\')
+      escaped += '\\';
+    if (static_cast<unsigned char>(c) >= 0x20)
+      escaped += c;
+  }
+  return escaped;
+}
+
+void writeSummary(std::ostream &out, const Summary &summary) {
+  out << "{\"mean\": " << summary.mean << ", \"p50\": " << summary.p50
+      << ", \"p95\": " << summary.p95 << ", \"p99\": " << summary.p99
+      << ", \"max\": " << summary.max << "}";
+}
+
+// The benchmark renders into its own target, a hidden window's default
+// framebuffer may not own its pixels.
+class Target {
+public:
+  Target(int width, int height) {
+    glCreateRenderbuffers(2, m_renderbuffers);
+    glNamedRenderbufferStorage(m_renderbuffers[0], GL_RGBA8, width, height);
+    glNamedRenderbufferStorage(m_renderbuffers[1], GL_DEPTH24_STENCIL8, width,
+                               height);
+    glCreateFramebuffers(1, &m_fbo);
+    glNamedFramebufferRenderbuffer(m_fbo, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER,
+                                   m_renderbuffers[0]);
+    glNamedFramebufferRenderbuffer(m_fbo, GL_DEPTH_STENCIL_ATTACHMENT,
+                                   GL_RENDERBUFFER, m_renderbuffers[1]);
+  }
+  ~Target() {
+    glDeleteFramebuffers(1, &m_fbo);
+    glDeleteRenderbuffers(2, m_renderbuffers);
+  }
+  Target(const Target &) = delete;
+  Target &operator=(const Target &) = delete;
+
+  void bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+  }
+
+private:
+  GLuint m_fbo{0};
+  GLuint m_renderbuffers[2]{};
+};
+
+// GPU time per pass from timestamp pairs, read back after the frame's
+// glFinish so no query is ever waited on.
+class PassTimer {
+public:
+  ~PassTimer() {
+    if (!m_queries.empty())
+      glDeleteQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+  }
+
+  void begin(Pass pass) {
+    m_current = pass;
+    glQueryCounter(query(m_used++), GL_TIMESTAMP);
+  }
+  void end() {
+    glQueryCounter(query(m_used++), GL_TIMESTAMP);
+    m_passes[(m_used - 1) / 2] = m_current;
+  }
+  // sums the pairs of the finished frame into gpu and starts the next one
+  void collect(std::array<double, PASS_COUNT> &gpu) {
+    gpu.fill(0.0);
+    for (size_t i = 0; i + 1 < m_used; i += 2) {
+      GLuint64 start = 0, stop = 0;
+      glGetQueryObjectui64v(m_queries[i], GL_QUERY_RESULT, &start);
+      glGetQueryObjectui64v(m_queries[i + 1], GL_QUERY_RESULT, &stop);
+      gpu[m_passes[i / 2]] += (stop - start) / 1.0e6;
+    }
+    m_used = 0;
+  }
+
+private:
+  GLuint query(size_t index) {
+    // grows during warm-up only, measured frames reuse the queries
+    if (index >= m_queries.size()) {
+      size_t old = m_queries.size();
+      m_queries.resize(std::max<size_t>(64, old * 2));
+      m_passes.resize(m_queries.size() / 2);
+      glGenQueries(static_cast<GLsizei>(m_queries.size() - old),
+                   m_queries.data() + old);
+    }
+    return m_queries[index];
+  }
+
+  std::vector<GLuint> m_queries;
+  std::vector<Pass> m_passes;
+  size_t m_used{0};
+  Pass m_current{SIMULATE};
+};
+
+struct Result {
+  Scenario scenario;
+  std::vector<double> frames;
+  std::array<std::vector<double>, PASS_COUNT> cpu;
+  std::array<std::vector<double>, PASS_COUNT> gpu;
+  uint64_t drawCalls{0};
+  uint64_t instancesDrawn{0};
+  uint64_t uploadedBytes{0};
+  AllocationCount allocations{};
+};
+
+Result run(const Scenario &scenario, const std::unique_ptr<Renderer> &renderer,
+           CursorBatch &cursorBatch, Ground &ground) {
+  Result result{scenario};
+  result.frames.reserve(scenario.frames);
+  for (int pass = 0; pass < PASS_COUNT; ++pass) {
+    result.cpu[pass].reserve(scenario.frames);
+    result.gpu[pass].reserve(scenario.frames);
+  }
+
+  Target target(scenario.width, scenario.height);
+  PassTimer passTimer;
+  cursorBatch.setLodMode(scenario.lod);
+  cursorBatch.setCulling(scenario.culling);
+  Camera camera(5.0f, {0.0f, 0.0f, 0.0f});
+
+  // every panel plays the same sweep for the whole run, so poses keep moving
+  int totalFrames = scenario.warmupFrames + scenario.frames;
+  Simulation simulation(240.0f, false);
+  const InterpolationMethod methods[] = {InterpolationMethod::LINEAR,
+                                         InterpolationMethod::SPHERICAL,
+                                         InterpolationMethod::EULER};
+  for (int i = 0; i < scenario.panels; ++i)
+    simulation.addPanel(methods[i % 3]);
+  simulation.setTrack({{-2.0f, 0.5f, 0.0f},
+                       {2.0f, 0.5f, 0.0f},
+                       {0.0f, 0.0f, 0.0f},
+                       {0.0f, 2.0f, 0.0f},
+                       {1.0f, 0.0f, 0.0f, 0.0f},
+                       {cosf(1.0f), 0.0f, sinf(1.0f), 0.0f},
+                       static_cast<float>(totalFrames * c_frameStep)});
+  simulation.setGhostFrames(scenario.ghosts > 0, scenario.ghosts);
+  simulation.setGhostSpacing(scenario.spacing);
+  simulation.setConstantSpeed(scenario.constantSpeed);
+  simulation.setSkeleton(static_cast<size_t>(scenario.skeleton));
+
+  std::vector<Viewport> viewports;
+  viewports.reserve(scenario.panels);
+  std::array<double, PASS_COUNT> cpu{};
+  std::array<double, PASS_COUNT> gpu{};
+  size_t groupSize = renderer->getMaxViewports();
+
+  for (int frame = 0; frame < totalFrames; ++frame) {
+    AllocationCount allocationsBefore = allocationCount();
+    cpu.fill(0.0);
+    Clock::time_point frameStart = Clock::now();
+
+    simulation.advance(c_frameStep);
+    const SimulationSnapshot &snapshot = simulation.acquire();
+    camera.applyInput(scenario.orbit, 0.0f, 0.0f);
+    Clock::time_point now = Clock::now();
+    cpu[SIMULATE] += milliseconds(frameStart, now);
+
+    // mirrors the panel loop of Window::draw with every pass timed
+    target.bind();
+    renderer->setView(camera.getView());
+    renderer->setCamerPos(camera.getPosition());
+    cursorBatch.resetStats();
+    Renderer::tileViewports(snapshot.panels.size(), scenario.width,
+                            scenario.height, viewports);
+    uint32_t groundDraws = 0;
+    for (size_t first = 0; first < snapshot.panels.size(); first += groupSize) {
+      size_t count = std::min(groupSize, snapshot.panels.size() - first);
+
+      Clock::time_point start = Clock::now();
+      passTimer.begin(SUBMIT);
+      renderer->setViewports({viewports.data() + first, count});
+      for (size_t i = 0; i < count; ++i) {
+        const PanelSnapshot &panel = snapshot.panels[first + i];
+        if (panel.ghosts) {
+          Frustum frustum(viewports[first + i].projection * renderer->getView());
+          if (!cursorBatch.getCulling() || frustum.isVisible(panel.track))
+            cursorBatch.addInstances(panel.ghosts->instances, i);
+        }
+        cursorBatch.add(panel.model, i);
+        if (!panel.skeleton.empty())
+          cursorBatch.addInstances(panel.skeleton, i);
+      }
+      passTimer.end();
+      now = Clock::now();
+      cpu[SUBMIT] += milliseconds(start, now);
+
+      start = now;
+      passTimer.begin(CURSORS);
+      cursorBatch.flush(renderer);
+      passTimer.end();
+      now = Clock::now();
+      cpu[CURSORS] += milliseconds(start, now);
+
+      start = now;
+      passTimer.begin(GROUND);
+      ground.render(renderer);
+      passTimer.end();
+      ++groundDraws;
+      now = Clock::now();
+      cpu[GROUND] += milliseconds(start, now);
+    }
+
+    Clock::time_point start = Clock::now();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glFinish();
+    Clock::time_point frameEnd = Clock::now();
+    cpu[FINISH] = milliseconds(start, frameEnd);
+    passTimer.collect(gpu);
+
+    if (frame < scenario.warmupFrames)
+      continue;
+    AllocationCount allocationsAfter = allocationCount();
+    result.frames.push_back(milliseconds(frameStart, frameEnd));
+    for (int pass = 0; pass < PASS_COUNT; ++pass) {
+      result.cpu[pass].push_back(cpu[pass]);
+      result.gpu[pass].push_back(gpu[pass]);
+    }
+    const CursorBatch::Stats &stats = cursorBatch.getStats();
+    result.drawCalls += stats.drawCalls + groundDraws;
+    result.instancesDrawn += stats.drawn;
+    result.uploadedBytes += stats.uploadedBytes;
+    result.allocations.count += allocationsAfter.count - allocationsBefore.count;
+    result.allocations.bytes += allocationsAfter.bytes - allocationsBefore.bytes;
+  }
+  return result;
+}
+
+void writeResult(std::ostream &out, const Result &result) {
+  const Scenario &scenario = result.scenario;
+  double frames = static_cast<double>(result.frames.size());
+  out << "    {\n";
+  out << "      \"name\": \"" << escape(scenario.name) << "\",\n";
+  out << "      \"panels\": " << scenario.panels
+      << ", \"ghosts\": " << scenario.ghosts << ", \"spacing\": \""
+      << (scenario.spacing == GhostSpacing::ARC_LENGTH ? "arc_length" : "time")
+      << "\", \"constant_speed\": " << (scenario.constantSpeed ? "true" : "false")
+      << ", \"skeleton\": " << scenario.skeleton << ", \"orbit\": " << scenario.orbit
+      << ", \"lod\": \"" << c_lodNames[static_cast<int>(scenario.lod)]
+      << "\", \"culling\": " << (scenario.culling ? "true" : "false")
+      << ", \"width\": " << scenario.width << ", \"height\": " << scenario.height
+      << ", \"warmup\": " << scenario.warmupFrames
+      << ", \"frames\": " << scenario.frames << ",\n";
+  out << "      \"frame_ms\": ";
+  writeSummary(out, summarize(result.frames));
+  out << ",\n      \"passes\": {\n";
+  for (int pass = 0; pass < PASS_COUNT; ++pass) {
+    out << "        \"" << c_passNames[pass] << "\": {\"cpu_ms\": ";
+    writeSummary(out, summarize(result.cpu[pass]));
+    out << ", \"gpu_ms\": ";
+    writeSummary(out, summarize(result.gpu[pass]));
+    out << "}" << (pass + 1 < PASS_COUNT ? "," : "") << "\n";
+  }
+  out << "      },\n";
+  out << "      \"draw_calls_per_frame\": " << result.drawCalls / frames << ",\n";
+  out << "      \"instances_drawn_per_frame\": " << result.instancesDrawn / frames
+      << ",\n";
+  out << "      \"instance_bytes_per_frame\": " << result.uploadedBytes / frames << ",\n";
+  out << "      \"allocations_per_frame\": " << result.allocations.count / frames
+      << ",\n";
+  out << "      \"allocated_bytes_per_frame\": "
+      << result.allocations.bytes / frames << "\n";
+  out << "    }";
+}
+
+// runs the scenarios in a hidden window and writes their part of the report
+std::vector<Result> writeScenarios(const std::vector<Scenario> &scenarios,
+                                   std::ostream &json) {
+  if (!glfwInit())
+    throw std::runtime_error("Failed to initialize GLFW");
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  // no offscreen context in GLFW, a window that is never shown is the
+  // closest portable thing
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+  GLFWwindow *window = glfwCreateWindow(64, 64, "bench", nullptr, nullptr);
+  if (!window) {
+    glfwTerminate();
+    throw std::runtime_error("Failed to create GLFW window");
+  }
+  glfwMakeContextCurrent(window);
+  glewInit();
+  glfwSwapInterval(0);
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_STENCIL_TEST);
+
+  std::vector<Result> results;
+  {
+    // shared by every scenario, like the window shares them across frames
+    auto renderer = std::make_unique<Renderer>();
+    MeshPool meshPool;
+    CursorBatch cursorBatch(meshPool);
+    Ground ground(meshPool);
+    for (const Scenario &scenario : scenarios) {
+      std::cerr << "running " << scenario.name << "\n";
+      results.push_back(run(scenario, renderer, cursorBatch, ground));
+    }
+  }
+
+  json << "  \"gl_renderer\": \""
+       << escape(reinterpret_cast<const char *>(glGetString(GL_RENDERER)))
+       << "\",\n";
+  json << "  \"gl_version\": \""
+       << escape(reinterpret_cast<const char *>(glGetString(GL_VERSION)))
+       << "\",\n";
+  json << "  \"frame_step_ms\": " << c_frameStep * 1000.0 << ",\n";
+  json << "  \"scenarios\": [\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    writeResult(json, results[i]);
+    json << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  json << "  ]";
+
+  glfwDestroyWindow(window);
+  glfwTerminate();
+  return results;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string outPath;
+  std::vector<std::string> scripts;
+  bool checksOnly = false;
+  bool expectZeroAllocations = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--out" && i + 1 < argc)
+      outPath = argv[++i];
+    else if (arg == "--checks-only")
+      checksOnly = true;
+    else if (arg == "--expect-zero-allocations")
+      expectZeroAllocations = true;
+    else if (arg.starts_with("--")) {
+      std::cerr << "usage: " << argv[0]
+                << " [--out results.json] [--checks-only]"
+                   " [--expect-zero-allocations] [script...]\n";
+      return 1;
+    } else
+      scripts.push_back(arg);
+  }
+  if (scripts.empty())
+    scripts.push_back(c_defaultScript);
+
+  try {
+    std::ostringstream json;
+    json << "{\n";
+    std::vector<Result> results;
+    if (!checksOnly) {
+      std::vector<Scenario> scenarios;
+      for (const std::string &script : scripts) {
+        std::vector<Scenario> loaded = loadScenarios(script);
+        scenarios.insert(scenarios.end(), loaded.begin(), loaded.end());
+      }
+      results = writeScenarios(scenarios, json);
+      json << ",\n";
+    }
+    std::cerr << "measuring rotations\n";
+    json << "  \"rotation\": ";
+    RotationReport rotation = measureRotations();
+    writeRotationReport(json, rotation);
+    std::cerr << "measuring picking\n";
+    json << ",\n  \"picking\": ";
+    PickReport picking = measurePicking();
+    writePickReport(json, picking);
+    std::cerr << "measuring formats\n";
+    json << ",\n  \"formats\": ";
+    FormatReport formats = measureFormats();
+    writeFormatReport(json, formats);
+    std::cerr << "measuring simd\n";
+    json << ",\n  \"simd\": ";
+    SimdReport simd = measureSimd();
+    writeSimdReport(json, simd);
+    std::cerr << "measuring skeleton\n";
+    json << ",\n  \"skeleton\": ";
+    SkeletonReport skeleton = measureSkeleton();
+    writeSkeletonReport(json, skeleton);
+    json << "\n}\n";
+
+    if (outPath.empty()) {
+      std::cout << json.str();
+    } else {
+      std::ofstream out(outPath, std::ios::trunc);
+      if (!(out << json.str()))
+        throw std::runtime_error("Failed to write " + outPath);
+    }
+
+    if (rotation.eulerLerpMismatches > 0) {
+      std::cerr << rotation.eulerLerpMismatches
+                << " Euler lerps differ from the per-angle fmodf wrap\n";
+      return 1;
+    }
+    if (skeleton.mismatches > 0) {
+      std::cerr << skeleton.mismatches
+                << " rig instances differ from the per-joint packing\n";
+      return 1;
+    }
+    for (const PickReport::Size &size : picking.sizes)
+      if (size.mismatches > 0) {
+        std::cerr << size.objects << " objects: " << size.mismatches
+                  << " picks differ from a linear scan\n";
+        return 1;
+      }
+    if (formats.instanceError > FormatReport::c_instanceTolerance) {
+      std::cerr << "packed instances place vertices " << formats.instanceError
+                << " off the float matrices\n";
+      return 1;
+    }
+    for (const SimdReport::Case &c : simd.cases)
+      if (c.maxError > SimdReport::c_tolerance) {
+        std::cerr << c.name << ": " << simd.backend << " kernels differ from the scalar code by "
+                  << c.maxError << "\n";
+        return 1;
+      }
+
+    if (expectZeroAllocations) {
+      bool allocated = false;
+      for (const Result &result : results) {
+        if (result.allocations.count == 0)
+          continue;
+        std::cerr << result.scenario.name << ": " << result.allocations.count
+                  << " heap allocations (" << result.allocations.bytes
+                  << " bytes) in " << result.frames.size() << " measured frames\n";
+        allocated = true;
+      }
+      if (allocated)
+        return 1;
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
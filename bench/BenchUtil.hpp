@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// What the GL-free checks share: a best-of-runs timer, a sink for results
+// the timed loops would otherwise drop, and the seeded inputs they start
+// from, so every run and every check sees the same numbers.
+namespace BenchUtil {
+// a dense scene, far more cursors than the caches hold
+constexpr size_t c_denseCount = 100000;
+constexpr int c_runs = 5;
+constexpr uint32_t c_seed = 137;
+
+using Clock = std::chrono::steady_clock;
+
+inline double elapsed(Clock::time_point from) {
+  return std::chrono::duration<double>(Clock::now() - from).count();
+}
+
+// the fastest of c_runs calls of body, in seconds
+template <typename Body> double bestOf(Body body) {
+  double best = INFINITY;
+  for (int run = 0; run < c_runs; ++run) {
+    auto from = Clock::now();
+    body();
+    best = std::min(best, elapsed(from));
+  }
+  return best;
+}
+
+// million elements per second
+template <typename Body> double throughput(size_t count, Body body) {
+  return static_cast<double>(count) / bestOf(body) * 1e-6;
+}
+
+// nanoseconds per element
+template <typename Body> double timePerElement(size_t count, Body body) {
+  return bestOf(body) * 1e9 / static_cast<double>(count);
+}
+
+// keeps the timed loops from being optimized away
+inline volatile double g_sink;
+
+template <typename T> void keep(T value) { g_sink = static_cast<double>(value); }
+
+inline std::mt19937 seededRng() { return std::mt19937(c_seed); }
+
+// count triples uniform in [-pi, pi)
+inline std::vector<float> randomAngles(size_t count, std::mt19937 &rng) {
+  std::uniform_real_distribution<float> angle(-static_cast<float>(M_PI),
+                                              static_cast<float>(M_PI));
+  std::vector<float> angles(count * 3);
+  for (float &a : angles)
+    a = angle(rng);
+  return angles;
+}
+
+// count points uniform in a cube of the given half side
+inline std::vector<float> randomPositions(size_t count, float halfSide, std::mt19937 &rng) {
+  std::uniform_real_distribution<float> position(-halfSide, halfSide);
+  std::vector<float> positions(count * 3);
+  for (float &p : positions)
+    p = position(rng);
+  return positions;
+}
+} // namespace BenchUtil
@@ -0,0 +1,157 @@
+#include "FormatCheck.hpp"
+#include "BenchUtil.hpp"
+#include "Cursor.hpp"
+#include "MeshPool.hpp"
+#include "Packing.hpp"
+#include "Rotation.hpp"
+#include <MatrixUtils.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+constexpr size_t c_accuracyCursors = 1 << 12;
+constexpr size_t c_cursors = BenchUtil::c_denseCount;
+
+// the axis instance before it was packed
+struct LegacyInstance {
+  float model[16];
+  float color[4];
+  int32_t viewport;
+  int32_t padding[3];
+};
+
+const math137::Matrix4f &axisRotation(int axis) {
+  static const math137::Matrix4f rotations[3] = {
+      math137::MatrixUtils::Identity(),
+      math137::MatrixUtils::RotateX(-static_cast<float>(M_PI_2)),
+      math137::MatrixUtils::RotateY(static_cast<float>(M_PI_2))};
+  return rotations[axis];
+}
+
+// what Cursor::appendInstances wrote before
+void appendLegacy(const math137::Matrix4f &model, int viewport,
+                  std::vector<LegacyInstance> &instances) {
+  static const float colors[3][4] = {{0, 0, 1, 1}, {0, 1, 0, 1}, {1, 0, 0, 1}};
+  for (int axis = 0; axis < 3; ++axis) {
+    math137::Matrix4f m = model * axisRotation(axis);
+    LegacyInstance &instance = instances.emplace_back();
+    for (int r = 0; r < 4; ++r)
+      for (int c = 0; c < 4; ++c)
+        instance.model[c * 4 + r] = m.getValue(r, c);
+    std::copy_n(colors[axis], 4, instance.color);
+    instance.viewport = viewport;
+  }
+}
+
+std::vector<math137::Matrix4f> randomModels(size_t count) {
+  std::mt19937 rng = BenchUtil::seededRng();
+  std::vector<float> angles = BenchUtil::randomAngles(count, rng);
+  std::vector<float> positions = BenchUtil::randomPositions(count, 10.0f, rng);
+  std::vector<math137::Matrix4f> models(count);
+  for (size_t i = 0; i < count; ++i) {
+    const float *a = &angles[i * 3];
+    models[i] = Rotation::eulerToMatrix({a[0], a[1], a[2]});
+    for (int r = 0; r < 3; ++r)
+      models[i].setValue(r, 3, positions[i * 3 + r]);
+  }
+  return models;
+}
+
+// instanced.vs: the half vertex turned by the SNORM quaternion
+void placePacked(const CursorInstance &instance, const float *vertex, float *out) {
+  float q[4];
+  for (int i = 0; i < 4; ++i)
+    q[i] = Packing::fromSnorm16(instance.rotation[i]);
+  float length = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+  for (float &c : q)
+    c /= length;
+  float t[3] = {2.0f * (q[1] * vertex[2] - q[2] * vertex[1]),
+                2.0f * (q[2] * vertex[0] - q[0] * vertex[2]),
+                2.0f * (q[0] * vertex[1] - q[1] * vertex[0])};
+  float cross[3] = {q[1] * t[2] - q[2] * t[1], q[2] * t[0] - q[0] * t[2],
+                    q[0] * t[1] - q[1] * t[0]};
+  for (int i = 0; i < 3; ++i)
+    out[i] = vertex[i] + q[3] * t[i] + cross[i] + instance.translation[i];
+}
+
+double distance(const float *a, const double *b) {
+  double dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+  return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+} // namespace
+
+using BenchUtil::throughput;
+
+FormatReport measureFormats() {
+  FormatReport report;
+  report.legacyInstanceBytes = sizeof(LegacyInstance);
+  report.instanceBytes = sizeof(CursorInstance);
+  report.legacyVertexBytes = sizeof(math137::Vector3f);
+  report.vertexBytes = sizeof(PackedVertex);
+  report.legacyBufferBytes = 3 * c_cursors * sizeof(LegacyInstance);
+  report.bufferBytes = 3 * c_cursors * sizeof(CursorInstance);
+
+  std::vector<math137::Vector3f> mesh = Cursor::generateVertices();
+  std::vector<std::array<float, 3>> halves(mesh.size());
+  for (size_t v = 0; v < mesh.size(); ++v) {
+    const float exact[3] = {mesh[v].x(), mesh[v].y(), mesh[v].z()};
+    for (int i = 0; i < 3; ++i) {
+      halves[v][i] = Packing::fromHalf(Packing::toHalf(exact[i]));
+      report.halfVertexError =
+          std::max(report.halfVertexError, std::abs(double(halves[v][i]) - exact[i]));
+    }
+  }
+
+  // every vertex of every axis, placed in double precision from the float
+  // matrices and by the shader's arithmetic from the packed instance
+  std::vector<math137::Matrix4f> models = randomModels(c_accuracyCursors);
+  std::vector<CursorInstance> instances;
+  for (const math137::Matrix4f &model : models) {
+    instances.clear();
+    Cursor::appendInstances(model, 0, instances);
+    for (int axis = 0; axis < 3; ++axis) {
+      math137::Matrix4f m = model * axisRotation(axis);
+      for (size_t v = 0; v < mesh.size(); ++v) {
+        const double vertex[3] = {mesh[v].x(), mesh[v].y(), mesh[v].z()};
+        double expected[3];
+        for (int r = 0; r < 3; ++r)
+          expected[r] = m.getValue(r, 0) * vertex[0] + m.getValue(r, 1) * vertex[1] +
+                        m.getValue(r, 2) * vertex[2] + m.getValue(r, 3);
+        float placed[3];
+        placePacked(instances[axis], halves[v].data(), placed);
+        report.instanceError = std::max(report.instanceError, distance(placed, expected));
+      }
+    }
+  }
+
+  models = randomModels(c_cursors);
+  std::vector<LegacyInstance> legacy;
+  legacy.reserve(3 * c_cursors);
+  instances.reserve(3 * c_cursors);
+  report.legacyEncode = throughput(c_cursors, [&] {
+    legacy.clear();
+    for (const math137::Matrix4f &model : models)
+      appendLegacy(model, 0, legacy);
+    BenchUtil::keep(legacy.size());
+  });
+  report.encode = throughput(c_cursors, [&] {
+    instances.clear();
+    for (const math137::Matrix4f &model : models)
+      Cursor::appendInstances(model, 0, instances);
+    BenchUtil::keep(instances.size());
+  });
+  return report;
+}
+
+void writeFormatReport(std::ostream &out, const FormatReport &report) {
+  out << "{\"instance_bytes\": {\"legacy\": " << report.legacyInstanceBytes
+      << ", \"packed\": " << report.instanceBytes << "}, \"vertex_bytes\": {\"legacy\": "
+      << report.legacyVertexBytes << ", \"packed\": " << report.vertexBytes
+      << "}, \"buffer_bytes_" << c_cursors << "_cursors\": {\"legacy\": "
+      << report.legacyBufferBytes << ", \"packed\": " << report.bufferBytes
+      << "}, \"half_vertex_error\": " << report.halfVertexError
+      << ", \"instance_error\": " << report.instanceError
+      << ", \"mcursors_per_s\": {\"legacy_encode\": " << report.legacyEncode
+      << ", \"packed_encode\": " << report.encode << "}}";
+}
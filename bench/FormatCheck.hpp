@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+// Size, accuracy and encode speed of the packed cursor instances and mesh
+// vertices against the float layouts they replaced.
+struct FormatReport {
+  size_t legacyInstanceBytes{0};
+  size_t instanceBytes{0};
+  size_t legacyVertexBytes{0};
+  size_t vertexBytes{0};
+  // of c_cursors cursors, three axis instances each
+  size_t legacyBufferBytes{0};
+  size_t bufferBytes{0};
+  // largest distance between a mesh vertex placed by the float matrices and
+  // by the packed data, in world units
+  double halfVertexError{0.0};
+  double instanceError{0.0};
+  // well above the half precision rounding of the mesh, far below a wrong
+  // or missing component of the packed instance
+  static constexpr double c_instanceTolerance = 1e-3;
+  // million cursors encoded per second
+  double legacyEncode{0.0};
+  double encode{0.0};
+};
+
+FormatReport measureFormats();
+void writeFormatReport(std::ostream &out, const FormatReport &report);
@@ -0,0 +1,117 @@
+#include "PickCheck.hpp"
+#include "BenchUtil.hpp"
+#include "Bvh.hpp"
+#include "Cursor.hpp"
+#include <cmath>
+
+namespace {
+constexpr size_t c_sizes[] = {1000, 10000, 100000};
+constexpr size_t c_picks = 20000;
+// the linear scan costs O(n) per pick, fewer of them are compared
+constexpr size_t c_checkedPicks = 1000;
+// cursors fill a cube of this side, more of them only pack it denser
+constexpr float c_extent = 20.0f;
+
+using BenchUtil::Clock;
+using BenchUtil::elapsed;
+
+RayHit linearPick(const std::vector<BoundingSphere> &spheres, const Ray &ray) {
+  RayHit hit{Bvh::c_noHit, INFINITY};
+  math137::Vector3f direction = ray.direction * (1.0f / std::sqrt(ray.direction * ray.direction));
+  for (size_t i = 0; i < spheres.size(); ++i) {
+    math137::Vector3f offset = ray.origin - spheres[i].center;
+    float b = offset * direction;
+    math137::Vector3f across = offset - direction * b;
+    float discriminant = spheres[i].radius * spheres[i].radius - across * across;
+    if (discriminant < 0.0f)
+      continue;
+    float root = std::sqrt(discriminant);
+    float t = std::max(-b - root, 0.0f);
+    if (-b + root >= 0.0f && t < hit.distance)
+      hit = {static_cast<uint32_t>(i), t};
+  }
+  return hit;
+}
+} // namespace
+
+PickReport measurePicking() {
+  PickReport report;
+  std::mt19937 rng = BenchUtil::seededRng();
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  for (size_t count : c_sizes) {
+    PickReport::Size &size = report.sizes.emplace_back();
+    size.objects = count;
+    std::vector<float> centers = BenchUtil::randomPositions(count, 0.5f * c_extent, rng);
+    std::vector<BoundingSphere> spheres(count);
+    for (size_t i = 0; i < count; ++i)
+      spheres[i] = {{centers[i * 3], centers[i * 3 + 1], centers[i * 3 + 2]},
+                    Cursor::boundingRadius};
+
+    Bvh bvh;
+    auto from = Clock::now();
+    bvh.build(spheres);
+    size.buildMs = elapsed(from) * 1e3;
+    size.depth = bvh.getDepth();
+
+    // every object steps a little along its track, as a tick moves them
+    for (BoundingSphere &sphere : spheres)
+      sphere.center = sphere.center + math137::Vector3f{0.05f * unit(rng), 0.05f * unit(rng),
+                                                        0.05f * unit(rng)};
+    from = Clock::now();
+    for (size_t i = 0; i < count; ++i)
+      bvh.move(static_cast<uint32_t>(i), spheres[i]);
+    size.moveUs = elapsed(from) * 1e6 / static_cast<double>(count);
+    for (BoundingSphere &sphere : spheres)
+      sphere.center = sphere.center + math137::Vector3f{0.05f * unit(rng), 0.05f * unit(rng),
+                                                        0.05f * unit(rng)};
+    from = Clock::now();
+    bvh.refit(spheres);
+    size.refitMs = elapsed(from) * 1e3;
+
+    // from a camera orbiting the cube towards a random cursor, the way a
+    // click ray would come in
+    std::vector<Ray> rays(c_picks);
+    for (Ray &ray : rays) {
+      math137::Vector3f eye{unit(rng), unit(rng), unit(rng)};
+      eye = eye * (1.5f * c_extent / std::sqrt(eye * eye + 1e-6f));
+      math137::Vector3f target = spheres[rng() % count].center;
+      ray = {eye, target - eye};
+    }
+    uint64_t visited = 0;
+    uint32_t sum = 0;
+    from = Clock::now();
+    for (const Ray &ray : rays) {
+      sum += bvh.pick(ray).object;
+      visited += bvh.getVisited();
+    }
+    size.pickUs = elapsed(from) * 1e6 / static_cast<double>(c_picks);
+    size.visitedNodes = static_cast<double>(visited) / static_cast<double>(c_picks);
+
+    from = Clock::now();
+    for (size_t i = 0; i < c_checkedPicks; ++i) {
+      RayHit expected = linearPick(spheres, rays[i]);
+      sum += expected.object;
+      RayHit hit = bvh.pick(rays[i]);
+      // equally near spheres may resolve either way
+      if (hit.object != expected.object && std::abs(hit.distance - expected.distance) > 1e-4f)
+        ++size.mismatches;
+    }
+    size.linearPickUs = elapsed(from) * 1e6 / static_cast<double>(c_checkedPicks) - size.pickUs;
+    BenchUtil::keep(sum);
+  }
+  return report;
+}
+
+void writePickReport(std::ostream &out, const PickReport &report) {
+  out << "[\n";
+  for (size_t i = 0; i < report.sizes.size(); ++i) {
+    const PickReport::Size &size = report.sizes[i];
+    out << "    {\"objects\": " << size.objects << ", \"depth\": " << size.depth
+        << ", \"build_ms\": " << size.buildMs << ", \"refit_ms\": " << size.refitMs
+        << ", \"move_us\": " << size.moveUs << ", \"pick_us\": " << size.pickUs
+        << ", \"linear_pick_us\": " << size.linearPickUs
+        << ", \"visited_nodes\": " << size.visitedNodes << ", \"mismatches\": " << size.mismatches
+        << "}" << (i + 1 < report.sizes.size() ? "," : "") << "\n";
+  }
+  out << "  ]";
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Cost of building, refitting and querying the picking hierarchy at growing
+// object counts, with every sampled pick checked against a linear scan.
+struct PickReport {
+  struct Size {
+    size_t objects{0};
+    uint32_t depth{0};
+    double buildMs{0.0};
+    // every object at once, and one object through move
+    double refitMs{0.0};
+    double moveUs{0.0};
+    double pickUs{0.0};
+    double linearPickUs{0.0};
+    double visitedNodes{0.0};
+    // picks whose nearest hit differs from the linear scan
+    size_t mismatches{0};
+  };
+  std::vector<Size> sizes;
+};
+
+PickReport measurePicking();
+void writePickReport(std::ostream &out, const PickReport &report);
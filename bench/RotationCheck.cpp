@@ -0,0 +1,262 @@
+#include "RotationCheck.hpp"
+#include "BenchUtil.hpp"
+#include <MatrixUtils.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+constexpr size_t c_accuracySamples = 1 << 14;
+constexpr size_t c_throughputSamples = 1 << 20;
+constexpr const char *c_orderNames[Rotation::c_orderCount] = {
+    "XYZ", "XZY", "YXZ", "YZX", "ZXY", "ZYX",
+    "XYX", "XZX", "YXY", "YZY", "ZXZ", "ZYZ"};
+
+using Matrix3d = std::array<std::array<double, 3>, 3>;
+
+Matrix3d axisRotation(int axis, double angle) {
+  Matrix3d m{};
+  int a = (axis + 1) % 3, b = (axis + 2) % 3;
+  double c = std::cos(angle), s = std::sin(angle);
+  m[axis][axis] = 1.0;
+  m[a][a] = c;
+  m[a][b] = -s;
+  m[b][a] = s;
+  m[b][b] = c;
+  return m;
+}
+
+Matrix3d multiply(const Matrix3d &a, const Matrix3d &b) {
+  Matrix3d m{};
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 3; ++c)
+      for (int k = 0; k < 3; ++k)
+        m[r][c] += a[r][k] * b[k][c];
+  return m;
+}
+
+// the definition the module has to meet: one axis product per angle
+Matrix3d reference(const float *angles, EulerOrder order) {
+  const char *name = c_orderNames[static_cast<int>(order)];
+  Matrix3d m = axisRotation(name[0] - 'X', angles[0]);
+  m = multiply(axisRotation(name[1] - 'X', angles[1]), m);
+  return multiply(axisRotation(name[2] - 'X', angles[2]), m);
+}
+
+Matrix3d fromQuaternion(const float *q) {
+  double w = q[0], x = q[1], y = q[2], z = q[3];
+  double s = 2.0 / (w * w + x * x + y * y + z * z);
+  return {{{1.0 - s * (y * y + z * z), s * (x * y - w * z), s * (x * z + w * y)},
+           {s * (x * y + w * z), 1.0 - s * (x * x + z * z), s * (y * z - w * x)},
+           {s * (x * z - w * y), s * (y * z + w * x), 1.0 - s * (x * x + y * y)}}};
+}
+
+double difference(const Matrix3d &a, const Matrix3d &b) {
+  double error = 0.0;
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 3; ++c)
+      error = std::max(error, std::abs(a[r][c] - b[r][c]));
+  return error;
+}
+
+double difference(const Matrix3d &a, const float *m) {
+  double error = 0.0;
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 3; ++c)
+      error = std::max(error, std::abs(a[r][c] - m[r * 4 + c]));
+  return error;
+}
+
+// the conversions Scene and Window carried before the Rotation module
+math137::Quaternion legacyEulerToQuaternion(float roll, float pitch, float yaw) {
+  float cr = std::cos(roll * 0.5f);
+  float sr = std::sin(roll * 0.5f);
+  float cp = std::cos(pitch * 0.5f);
+  float sp = std::sin(pitch * 0.5f);
+  float cy = std::cos(yaw * 0.5f);
+  float sy = std::sin(yaw * 0.5f);
+  math137::Quaternion q;
+  q.a = cr * cp * cy + sr * sp * sy;
+  q.b = sr * cp * cy - cr * sp * sy;
+  q.c = cr * sp * cy + sr * cp * sy;
+  q.d = cr * cp * sy - sr * sp * cy;
+  return q;
+}
+
+void legacyQuaternionToEuler(const float *quaternion, float *angles) {
+  math137::Quaternion q{quaternion[0], quaternion[1], quaternion[2], quaternion[3]};
+  q.normalize();
+  float w = q.a, x = q.b, y = q.c, z = q.d;
+  float sinp = 2.0f * (w * y - z * x);
+  angles[0] = atan2f(2.0f * (w * x + y * z), 1.0f - 2.0f * (x * x + y * y));
+  angles[1] = fabsf(sinp) >= 1.0f ? copysignf(M_PI_2, sinp) : asinf(sinp);
+  angles[2] = atan2f(2.0f * (w * z + x * y), 1.0f - 2.0f * (y * y + z * z));
+}
+
+// the wrap Scene used before the Rotation module, in [-pi, pi)
+float legacyShortestTurn(float from, float to) {
+  constexpr float pi = static_cast<float>(M_PI);
+  float delta = fmodf(to - from + pi, 2.0f * pi);
+  if (delta < 0.0f)
+    delta += 2.0f * pi;
+  return delta - pi;
+}
+
+size_t countEulerLerpMismatches(const std::vector<float> &from) {
+  constexpr float pi = static_cast<float>(M_PI);
+  std::vector<float> to(from.rbegin(), from.rend());
+  // exact half turns both ways, where rounding to the nearest turn picks a
+  // side the fmodf wrap does not
+  const float halfTurns[][2] = {{0.0f, pi}, {pi, 0.0f}, {-0.5f * pi, 0.5f * pi},
+                                {0.5f * pi, -0.5f * pi}, {-pi, 0.0f}, {0.0f, -pi}};
+  std::vector<float> starts(from);
+  for (size_t i = 0; i < std::size(halfTurns) * 3; ++i) {
+    starts[i] = halfTurns[i / 3][0];
+    to[i] = halfTurns[i / 3][1];
+  }
+  constexpr float c_alpha = 0.625f;
+  std::vector<float> batch(starts.size());
+  Rotation::eulerLerp(starts, to, c_alpha, batch);
+  size_t mismatches = 0;
+  for (size_t i = 0; i < starts.size(); i += 3) {
+    math137::Vector3f scalar = Rotation::eulerLerp({starts[i], starts[i + 1], starts[i + 2]},
+                                                   {to[i], to[i + 1], to[i + 2]}, c_alpha);
+    const float single[3] = {scalar.x(), scalar.y(), scalar.z()};
+    bool differs = false;
+    for (int a = 0; a < 3; ++a) {
+      float expected = starts[i + a] + legacyShortestTurn(starts[i + a], to[i + a]) * c_alpha;
+      differs |= batch[i + a] != expected || single[a] != expected;
+    }
+    mismatches += differs;
+  }
+  return mismatches;
+}
+
+std::vector<float> randomAngles(size_t count) {
+  std::mt19937 rng = BenchUtil::seededRng();
+  std::vector<float> angles = BenchUtil::randomAngles(count, rng);
+  // gimbal lock for the Tait-Bryan orders and for the repeated ones
+  angles[0] = 0.3f;
+  angles[1] = static_cast<float>(M_PI_2);
+  angles[2] = -0.7f;
+  angles[3] = 0.3f;
+  angles[4] = 0.0f;
+  angles[5] = -0.7f;
+  return angles;
+}
+} // namespace
+
+using BenchUtil::throughput;
+
+RotationReport measureRotations() {
+  RotationReport report;
+  std::vector<float> angles = randomAngles(c_accuracySamples);
+  std::vector<float> matrices(c_accuracySamples * 16);
+  std::vector<float> quaternions(c_accuracySamples * 4);
+  std::vector<float> roundTrip(c_accuracySamples * 3);
+  for (int o = 0; o < Rotation::c_orderCount; ++o) {
+    EulerOrder order = static_cast<EulerOrder>(o);
+    Rotation::eulerToMatrix(angles, matrices, order);
+    Rotation::eulerToQuaternion(angles, quaternions, order);
+    Rotation::quaternionToEuler(quaternions, roundTrip, order);
+    RotationReport::Order &result = report.orders[o];
+    for (size_t i = 0; i < c_accuracySamples; ++i) {
+      Matrix3d expected = reference(&angles[i * 3], order);
+      result.matrixError =
+          std::max(result.matrixError, difference(expected, &matrices[i * 16]));
+      result.quaternionError = std::max(
+          result.quaternionError, difference(expected, fromQuaternion(&quaternions[i * 4])));
+      result.roundTripError = std::max(
+          result.roundTripError, difference(expected, reference(&roundTrip[i * 3], order)));
+    }
+  }
+
+  Rotation::eulerToQuaternion(angles, quaternions);
+  for (size_t i = 0; i < c_accuracySamples; ++i) {
+    const float *a = &angles[i * 3];
+    math137::Quaternion legacy = legacyEulerToQuaternion(a[0], a[1], a[2]);
+    const float *q = &quaternions[i * 4];
+    report.legacyQuaternionError =
+        std::max({report.legacyQuaternionError, std::abs(double(legacy.a) - q[0]),
+                  std::abs(double(legacy.b) - q[1]), std::abs(double(legacy.c) - q[2]),
+                  std::abs(double(legacy.d) - q[3])});
+    float legacyAngles[3];
+    legacyQuaternionToEuler(q, legacyAngles);
+    report.legacyRoundTripError =
+        std::max(report.legacyRoundTripError, difference(reference(a, EulerOrder::XYZ),
+                                                         reference(legacyAngles, EulerOrder::XYZ)));
+  }
+  report.eulerLerpMismatches = countEulerLerpMismatches(angles);
+
+  angles = randomAngles(c_throughputSamples);
+  quaternions.resize(c_throughputSamples * 4);
+  matrices.resize(c_throughputSamples * 16);
+  roundTrip.resize(c_throughputSamples * 3);
+  report.legacyEulerToQuaternion = throughput(c_throughputSamples, [&] {
+    float sum = 0.0f;
+    for (size_t i = 0; i < c_throughputSamples; ++i)
+      sum += legacyEulerToQuaternion(angles[i * 3], angles[i * 3 + 1], angles[i * 3 + 2]).a;
+    BenchUtil::keep(sum);
+  });
+  report.scalarEulerToQuaternion = throughput(c_throughputSamples, [&] {
+    float sum = 0.0f;
+    for (size_t i = 0; i < c_throughputSamples; ++i)
+      sum += Rotation::eulerToQuaternion({angles[i * 3], angles[i * 3 + 1], angles[i * 3 + 2]}).a;
+    BenchUtil::keep(sum);
+  });
+  report.batchEulerToQuaternion = throughput(c_throughputSamples, [&] {
+    Rotation::eulerToQuaternion(angles, quaternions);
+    BenchUtil::keep(quaternions.back());
+  });
+  report.legacyEulerToMatrix = throughput(c_throughputSamples, [&] {
+    float sum = 0.0f;
+    for (size_t i = 0; i < c_throughputSamples; ++i) {
+      math137::Matrix4f m = math137::MatrixUtils::RotateZ(angles[i * 3 + 2]) *
+                            math137::MatrixUtils::RotateY(angles[i * 3 + 1]) *
+                            math137::MatrixUtils::RotateX(angles[i * 3]);
+      sum += m.getValue(0, 0);
+    }
+    BenchUtil::keep(sum);
+  });
+  report.batchEulerToMatrix = throughput(c_throughputSamples, [&] {
+    Rotation::eulerToMatrix(angles, matrices);
+    BenchUtil::keep(matrices.back());
+  });
+  report.legacyQuaternionToEuler = throughput(c_throughputSamples, [&] {
+    float sum = 0.0f, out[3];
+    for (size_t i = 0; i < c_throughputSamples; ++i) {
+      legacyQuaternionToEuler(&quaternions[i * 4], out);
+      sum += out[0];
+    }
+    BenchUtil::keep(sum);
+  });
+  report.batchQuaternionToEuler = throughput(c_throughputSamples, [&] {
+    Rotation::quaternionToEuler(quaternions, roundTrip);
+    BenchUtil::keep(roundTrip.back());
+  });
+  return report;
+}
+
+void writeRotationReport(std::ostream &out, const RotationReport &report) {
+  out << "{\n    \"orders\": {\n";
+  for (int o = 0; o < Rotation::c_orderCount; ++o) {
+    const RotationReport::Order &order = report.orders[o];
+    out << "      \"" << c_orderNames[o] << "\": {\"matrix_error\": " << order.matrixError
+        << ", \"quaternion_error\": " << order.quaternionError
+        << ", \"round_trip_error\": " << order.roundTripError << "}"
+        << (o + 1 < Rotation::c_orderCount ? "," : "") << "\n";
+  }
+  out << "    },\n";
+  out << "    \"legacy_quaternion_error\": " << report.legacyQuaternionError << ",\n";
+  out << "    \"legacy_round_trip_error\": " << report.legacyRoundTripError << ",\n";
+  out << "    \"euler_lerp_mismatches\": " << report.eulerLerpMismatches << ",\n";
+  out << "    \"mrot_per_s\": {\"legacy_euler_to_quaternion\": "
+      << report.legacyEulerToQuaternion
+      << ", \"scalar_euler_to_quaternion\": " << report.scalarEulerToQuaternion
+      << ", \"batch_euler_to_quaternion\": " << report.batchEulerToQuaternion
+      << ", \"legacy_euler_to_matrix\": " << report.legacyEulerToMatrix
+      << ", \"batch_euler_to_matrix\": " << report.batchEulerToMatrix
+      << ", \"legacy_quaternion_to_euler\": " << report.legacyQuaternionToEuler
+      << ", \"batch_quaternion_to_euler\": " << report.batchQuaternionToEuler << "}\n";
+  out << "  }";
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Rotation.hpp"
+#include <array>
+#include <ostream>
+
+// Accuracy of every Euler order against double precision axis products, and
+// throughput of the Rotation module against the per-call conversions the
+// app used before it.
+struct RotationReport {
+  struct Order {
+    // largest element error of the resulting rotation matrices
+    double matrixError{0.0};
+    double quaternionError{0.0};
+    double roundTripError{0.0};
+  };
+  std::array<Order, Rotation::c_orderCount> orders;
+  // XYZ through the former eulerToQuaternion lambda, and the former
+  // quat -> Euler code measured like roundTripError
+  double legacyQuaternionError{0.0};
+  double legacyRoundTripError{0.0};
+  // Euler lerps, scalar or batch, that differ from the former per-angle
+  // fmodf wrap, half turns included
+  size_t eulerLerpMismatches{0};
+  // million rotations per second
+  double legacyEulerToQuaternion{0.0};
+  double scalarEulerToQuaternion{0.0};
+  double batchEulerToQuaternion{0.0};
+  double legacyEulerToMatrix{0.0};
+  double batchEulerToMatrix{0.0};
+  double legacyQuaternionToEuler{0.0};
+  double batchQuaternionToEuler{0.0};
+};
+
+RotationReport measureRotations();
+void writeRotationReport(std::ostream &out, const RotationReport &report);
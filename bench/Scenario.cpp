@@ -0,0 +1,88 @@
+#include "Scenario.hpp"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+std::vector<Scenario> loadScenarios(const std::string &path) {
+  std::ifstream file(path);
+  if (!file)
+    throw std::runtime_error("Failed to open scenario script " + path);
+
+  std::vector<Scenario> scenarios;
+  std::string line;
+  for (int number = 1; std::getline(file, line); ++number) {
+    if (size_t comment = line.find('#'); comment != std::string::npos)
+      line.erase(comment);
+    std::istringstream stream(line);
+    std::string key;
+    if (!(stream >> key))
+      continue;
+    auto fail = [&](const std::string &reason) {
+      return std::runtime_error(path + ":" + std::to_string(number) + ": " +
+                                reason);
+    };
+
+    if (key == "scenario") {
+      scenarios.push_back({});
+      if (!(stream >> scenarios.back().name))
+        throw fail("scenario needs a name");
+      continue;
+    }
+    if (scenarios.empty())
+      throw fail("'" + key + "' before the first scenario");
+    Scenario &scenario = scenarios.back();
+
+    std::string value;
+    if (!(stream >> value))
+      throw fail("missing value for '" + key + "'");
+    try {
+      if (key == "panels")
+        scenario.panels = std::stoi(value);
+      else if (key == "ghosts")
+        scenario.ghosts = std::stoi(value);
+      else if (key == "orbit")
+        scenario.orbit = std::stof(value);
+      else if (key == "skeleton")
+        scenario.skeleton = std::stoi(value);
+      else if (key == "constant_speed")
+        scenario.constantSpeed = std::stoi(value) != 0;
+      else if (key == "culling")
+        scenario.culling = std::stoi(value) != 0;
+      else if (key == "width")
+        scenario.width = std::stoi(value);
+      else if (key == "height")
+        scenario.height = std::stoi(value);
+      else if (key == "warmup")
+        scenario.warmupFrames = std::stoi(value);
+      else if (key == "frames")
+        scenario.frames = std::stoi(value);
+      else if (key == "lod") {
+        if (value == "off")
+          scenario.lod = LodMode::OFF;
+        else if (value == "cpu")
+          scenario.lod = LodMode::CPU;
+        else if (value == "gpu")
+          scenario.lod = LodMode::GPU;
+        else
+          throw fail("lod must be off, cpu or gpu");
+      } else if (key == "spacing") {
+        if (value == "time")
+          scenario.spacing = GhostSpacing::TIME;
+        else if (value == "arc_length")
+          scenario.spacing = GhostSpacing::ARC_LENGTH;
+        else
+          throw fail("spacing must be time or arc_length");
+      } else
+        throw fail("unknown key '" + key + "'");
+    } catch (const std::logic_error &) {
+      // stoi and stof report bad numbers as invalid_argument or out_of_range
+      throw fail("bad value '" + value + "' for '" + key + "'");
+    }
+  }
+  for (const Scenario &scenario : scenarios)
+    if (scenario.panels < 1 || scenario.ghosts < 0 || scenario.skeleton < 0 || scenario.frames < 1 ||
+        scenario.warmupFrames < 0 || scenario.width < 1 || scenario.height < 1)
+      throw std::runtime_error(path + ": scenario " + scenario.name +
+                               " has an out of range value");
+  return scenarios;
+}
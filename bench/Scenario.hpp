@@ -0,0 +1,30 @@
+#pragma once
+
+#include "CursorBatch.hpp"
+#include "Scene.hpp"
+#include <string>
+#include <vector>
+
+// One benchmark run, read from a scenario script. Scripts are plain text:
+// a "scenario <name>" line starts a run, the "key value" lines after it
+// override its defaults and '#' starts a comment.
+struct Scenario {
+  std::string name;
+  // one panel per track, methods cycle linear, spherical, Euler
+  int panels{2};
+  int ghosts{0};
+  GhostSpacing spacing{GhostSpacing::TIME};
+  bool constantSpeed{false};
+  // joints of the rig every panel carries, 0 for none
+  int skeleton{0};
+  // camera yaw per frame in the units of Camera::applyInput
+  float orbit{0.0f};
+  LodMode lod{LodMode::CPU};
+  bool culling{true};
+  int width{1280};
+  int height{720};
+  int warmupFrames{60};
+  int frames{600};
+};
+
+std::vector<Scenario> loadScenarios(const std::string &path);
@@ -0,0 +1,164 @@
+#include "SimdCheck.hpp"
+#include "BenchUtil.hpp"
+#include "Cursor.hpp"
+#include "Rotation.hpp"
+#include "Simd.hpp"
+#include <MatrixUtils.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+using BenchUtil::timePerElement;
+
+double maxDifference(const std::vector<float> &a, const std::vector<float> &b) {
+  double error = 0.0;
+  for (size_t i = 0; i < a.size(); ++i)
+    error = std::max(error, std::abs(static_cast<double>(a[i]) - b[i]));
+  return error;
+}
+
+void store(const math137::Matrix4f &m, float *out) {
+  std::copy_n(m.data(), 16, out);
+}
+
+math137::Matrix4f load(const float *m) {
+  math137::Matrix4f matrix;
+  for (int i = 0; i < 16; ++i)
+    matrix.setValue(i / 4, i % 4, m[i]);
+  return matrix;
+}
+
+// the Hamilton product Cursor::appendInstances used before
+void multiplyScalar(const float *a, const float *b, float *out) {
+  out[0] = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+  out[1] = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+  out[2] = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+  out[3] = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+}
+
+struct Inputs {
+  std::vector<float> angles;
+  std::vector<float> translations;
+  std::vector<float> rotations;
+  std::vector<float> models;
+  std::vector<float> from;
+  std::vector<float> to;
+};
+
+Inputs randomInputs(size_t count) {
+  std::mt19937 rng = BenchUtil::seededRng();
+  Inputs inputs;
+  inputs.angles = BenchUtil::randomAngles(count, rng);
+  inputs.translations = BenchUtil::randomPositions(count, 10.0f, rng);
+  inputs.rotations.resize(count * 16);
+  Rotation::eulerToMatrix(inputs.angles, inputs.rotations);
+  inputs.models.resize(count * 16);
+  Simd::translateMatrices(inputs.translations, inputs.rotations, inputs.models);
+  inputs.from.resize(count * 4);
+  inputs.to.resize(count * 4);
+  Rotation::eulerToQuaternion(inputs.angles, inputs.from);
+  std::reverse_copy(inputs.from.begin(), inputs.from.end(), inputs.to.begin());
+  return inputs;
+}
+} // namespace
+
+SimdReport measureSimd() {
+  SimdReport report;
+  report.backend = Simd::c_backend;
+  const size_t n = BenchUtil::c_denseCount;
+  Inputs in = randomInputs(n);
+  std::vector<float> scalar, simd;
+
+  auto add = [&](std::string name, double scalarNs, double simdNs) {
+    report.cases.push_back({std::move(name), n, scalarNs, simdNs, maxDifference(scalar, simd)});
+    BenchUtil::keep(simd[simd.size() / 2]);
+  };
+
+  // the per-cursor model matrix, Translate * rotation
+  scalar.assign(n * 16, 0.0f);
+  simd.assign(n * 16, 0.0f);
+  double scalarNs = timePerElement(n, [&] {
+    for (size_t i = 0; i < n; ++i) {
+      const float *t = &in.translations[i * 3];
+      store(math137::MatrixUtils::Translate(t[0], t[1], t[2]) * load(&in.rotations[i * 16]),
+            &scalar[i * 16]);
+    }
+  });
+  double simdNs = timePerElement(
+      n, [&] { Simd::translateMatrices(in.translations, in.rotations, simd); });
+  add("model_matrix", scalarNs, simdNs);
+
+  // a general product, as forward kinematics chains them
+  scalarNs = timePerElement(n, [&] {
+    for (size_t i = 0; i < n; ++i)
+      store(load(&in.models[i * 16]) * load(&in.rotations[i * 16]), &scalar[i * 16]);
+  });
+  simdNs = timePerElement(n, [&] { Simd::multiplyMatrices(in.models, in.rotations, simd); });
+  add("matrix_multiply", scalarNs, simdNs);
+
+  // turning every cursor's rotation into its three axes
+  scalar.assign(n * 4, 0.0f);
+  simd.assign(n * 4, 0.0f);
+  scalarNs = timePerElement(n, [&] {
+    for (size_t i = 0; i < n; ++i)
+      multiplyScalar(&in.from[i * 4], &in.to[i * 4], &scalar[i * 4]);
+  });
+  simdNs = timePerElement(n, [&] { Simd::multiplyQuaternions(in.from, in.to, simd); });
+  add("quaternion_multiply", scalarNs, simdNs);
+
+  // vertices of a cursor placed by its model matrix
+  std::vector<math137::Vector3f> mesh = Cursor::generateVertices();
+  std::vector<float> points(n * 3);
+  for (size_t i = 0; i < n; ++i) {
+    const math137::Vector3f &v = mesh[i % mesh.size()];
+    points[i * 3] = v.x();
+    points[i * 3 + 1] = v.y();
+    points[i * 3 + 2] = v.z();
+  }
+  const float *e = in.models.data();
+  scalar.assign(n * 3, 0.0f);
+  simd.assign(n * 3, 0.0f);
+  scalarNs = timePerElement(n, [&] {
+    for (size_t i = 0; i < n; ++i)
+      for (int r = 0; r < 3; ++r)
+        scalar[i * 3 + r] = e[r * 4] * points[i * 3] + e[r * 4 + 1] * points[i * 3 + 1] +
+                            e[r * 4 + 2] * points[i * 3 + 2] + e[r * 4 + 3];
+  });
+  simdNs = timePerElement(n, [&] { Simd::transformPoints(load(e), points, simd); });
+  add("transform_points", scalarNs, simdNs);
+
+  // a linear panel per cursor: nlerp, rotation matrix, model matrix, one
+  // call each per cursor against the packed batches
+  scalar.assign(n * 16, 0.0f);
+  simd.assign(n * 16, 0.0f);
+  constexpr float c_alpha = 0.375f;
+  scalarNs = timePerElement(n, [&] {
+    for (size_t i = 0; i < n; ++i) {
+      const float *f = &in.from[i * 4], *t = &in.to[i * 4], *p = &in.translations[i * 3];
+      math137::Quaternion q = Rotation::nlerp({f[0], f[1], f[2], f[3]}, {t[0], t[1], t[2], t[3]},
+                                              c_alpha);
+      store(math137::MatrixUtils::Translate(p[0], p[1], p[2]) * Rotation::quaternionToMatrix(q),
+            &scalar[i * 16]);
+    }
+  });
+  std::vector<float> quaternions(n * 4);
+  simdNs = timePerElement(n, [&] {
+    Rotation::nlerp(in.from, in.to, c_alpha, quaternions);
+    Rotation::quaternionToMatrix(quaternions, simd);
+    Simd::translateMatrices(in.translations, simd, simd);
+  });
+  add("interpolate_linear", scalarNs, simdNs);
+  return report;
+}
+
+void writeSimdReport(std::ostream &out, const SimdReport &report) {
+  out << "{\"backend\": \"" << report.backend << "\", \"cases\": [";
+  for (size_t i = 0; i < report.cases.size(); ++i) {
+    const SimdReport::Case &c = report.cases[i];
+    out << (i > 0 ? ", " : "") << "{\"name\": \"" << c.name << "\", \"count\": " << c.count
+        << ", \"scalar_ns\": " << c.scalarNs << ", \"simd_ns\": " << c.simdNs
+        << ", \"speedup\": " << c.scalarNs / c.simdNs << ", \"max_error\": " << c.maxError
+        << "}";
+  }
+  out << "]}";
+}
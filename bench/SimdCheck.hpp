@@ -0,0 +1,30 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Speed of the Simd kernels, and the Rotation batches on top of them, over
+// the scalar code the cursor and interpolation loops ran before, on the
+// same random inputs. The backend is fixed at build time, a SCALAR build
+// times its plain loops against the same references.
+struct SimdReport {
+  struct Case {
+    std::string name;
+    size_t count;
+    // best of a few runs, per element
+    double scalarNs;
+    double simdNs;
+    // largest element difference between the two outputs
+    double maxError;
+  };
+  // a few float ulps of the largest inputs, the kernels do the scalar
+  // arithmetic in another order at most
+  static constexpr double c_tolerance = 1e-4;
+
+  std::string backend;
+  std::vector<Case> cases;
+};
+
+SimdReport measureSimd();
+void writeSimdReport(std::ostream &out, const SimdReport &report);
@@ -0,0 +1,67 @@
+#include "SkeletonCheck.hpp"
+#include "BenchUtil.hpp"
+#include "Skeleton.hpp"
+#include "ThreadPool.hpp"
+#include <MatrixUtils.hpp>
+#include <algorithm>
+#include <cstring>
+#include <span>
+
+namespace {
+// the joint count of scenarios/skeleton.txt
+constexpr size_t c_joints = 10000;
+constexpr float c_alpha = 0.375f;
+} // namespace
+
+SkeletonReport measureSkeleton() {
+  SkeletonReport report;
+  Skeleton rig = Skeleton::procedural(c_joints);
+  report.joints = rig.getJointCount();
+  report.levels = rig.getLevelCount();
+  const math137::Matrix4f root = math137::MatrixUtils::Translate(1.0f, 0.5f, -2.0f);
+  std::vector<CursorInstance> instances;
+  instances.reserve(3 * c_joints);
+
+  unsigned maxThreads = ThreadPool::defaultWorkers() + 1;
+  for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+    ThreadPool pool(threads - 1);
+    SkeletonReport::Run &run = report.runs.emplace_back();
+    run.threads = pool.getThreadCount();
+    run.evaluateMs = 1e3 * BenchUtil::bestOf([&] {
+      rig.evaluate(c_alpha, InterpolationMethod::SPHERICAL, root, pool);
+    });
+    run.publishMs = 1e3 * BenchUtil::bestOf([&] {
+      instances.clear();
+      rig.appendInstances(0, instances);
+      BenchUtil::keep(instances.size());
+    });
+    if (threads == maxThreads)
+      break;
+  }
+
+  std::vector<CursorInstance> legacy;
+  legacy.reserve(3 * c_joints);
+  report.legacyPublishMs = 1e3 * BenchUtil::bestOf([&] {
+    legacy.clear();
+    for (uint32_t slot = 0; slot < rig.getJointCount(); ++slot)
+      Cursor::appendInstances(rig.getWorld(slot), 0, legacy);
+    BenchUtil::keep(legacy.size());
+  });
+  std::span<const CursorInstance> packed = rig.getInstances();
+  for (size_t i = 0; i < legacy.size(); ++i)
+    report.mismatches += std::memcmp(&packed[i], &legacy[i], sizeof(CursorInstance)) != 0;
+  return report;
+}
+
+void writeSkeletonReport(std::ostream &out, const SkeletonReport &report) {
+  out << "{\"joints\": " << report.joints << ", \"levels\": " << report.levels
+      << ", \"legacy_publish_ms\": " << report.legacyPublishMs
+      << ", \"mismatches\": " << report.mismatches << ", \"runs\": [";
+  for (size_t i = 0; i < report.runs.size(); ++i) {
+    const SkeletonReport::Run &run = report.runs[i];
+    out << (i > 0 ? ", " : "") << "{\"threads\": " << run.threads
+        << ", \"evaluate_ms\": " << run.evaluateMs << ", \"publish_ms\": " << run.publishMs
+        << "}";
+  }
+  out << "]}";
+}
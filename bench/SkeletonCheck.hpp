@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+// Cost of posing a procedural rig and handing its axis instances to a
+// snapshot, on pools of growing size, against the serial per-joint packing
+// publish did before. The packed instances are checked against it too.
+struct SkeletonReport {
+  struct Run {
+    unsigned threads{0};
+    // best of a few runs: interpolation, levels and packing
+    double evaluateMs{0.0};
+    // copying the packed instances, what publish does per rig
+    double publishMs{0.0};
+  };
+  size_t joints{0};
+  size_t levels{0};
+  std::vector<Run> runs;
+  // getWorld and Cursor::appendInstances per joint, on the caller
+  double legacyPublishMs{0.0};
+  // instances that differ from the per-joint packing
+  size_t mismatches{0};
+};
+
+SkeletonReport measureSkeleton();
+void writeSkeletonReport(std::ostream &out, const SkeletonReport &report);
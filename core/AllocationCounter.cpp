@@ -0,0 +1,53 @@
+#include "AllocationCounter.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<uint64_t> s_count{0};
+std::atomic<uint64_t> s_bytes{0};
+
+void count(std::size_t size) {
+  s_count.fetch_add(1, std::memory_order_relaxed);
+  s_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+} // namespace
+
+AllocationCount allocationCount() {
+  return {s_count.load(std::memory_order_relaxed),
+          s_bytes.load(std::memory_order_relaxed)};
+}
+
+// the array, sized and nothrow forms forward to these
+void *operator new(std::size_t size) {
+  count(size);
+  if (void *ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  count(size);
+  auto align = static_cast<std::size_t>(alignment);
+  if (size == 0)
+    size = 1;
+#ifdef _WIN32
+  void *ptr = _aligned_malloc(size, align);
+#else
+  // aligned_alloc wants a multiple of the alignment
+  void *ptr = std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+  if (ptr)
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+#ifdef _WIN32
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts every global operator new in the process since it started, on
+// every thread. Only available in targets that link the AllocationCounter
+// object library, the core library sees it when COUNT_ALLOCATIONS is set.
+struct AllocationCount {
+  uint64_t count;
+  uint64_t bytes;
+};
+
+AllocationCount allocationCount();
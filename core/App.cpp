@@ -1,12 +1,20 @@
 #include "App.hpp"
+#include <iostream>
 
-App::App()
-    : m_window(1920, 1080, "Universal Interface for Virtual Space Interaction"),
-      m_isRunning(true) {}
+App::App(const RecordingOptions &recording, GlDebugMode glDebug)
+    : m_expectZeroAllocations(recording.expectZeroAllocations), m_isRunning(true),
+      m_window(1920, 1080, "Universal Interface for Virtual Space Interaction",
+               recording, glDebug) {}
 
-void App::run() {
+int App::run() {
   while (m_isRunning) {
     m_window.update(m_isRunning);
     m_window.draw();
   }
+  if (m_expectZeroAllocations && m_window.getAllocatingFrames() > 0) {
+    std::cerr << m_window.getAllocatingFrames() << " frames drew with "
+              << m_window.getMeasuredAllocations() << " heap allocations\n";
+    return 1;
+  }
+  return 0;
 }
@@ -3,11 +3,14 @@
 
 class App {
 public:
-  App();
+  App(const RecordingOptions &recording = {},
+      GlDebugMode glDebug = c_defaultGlDebugMode);
 
-  void run();
+  // the process exit code
+  int run();
 
 private:
+  bool m_expectZeroAllocations;
   bool m_isRunning;
   Window m_window;
 };
@@ -0,0 +1,62 @@
+#include "ArcLengthTable.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+namespace {
+// steps per chunk handed to a worker, each chunk evaluates one extra pose
+constexpr size_t c_grain = 256;
+} // namespace
+
+void ArcLengthTable::build(size_t steps, const StepLengths &stepLengths) {
+  steps = std::max(steps, c_minSteps);
+  std::vector<float> lengths(steps);
+  ThreadPool::shared().parallelFor(steps, c_grain, [&](size_t first, size_t last) {
+    stepLengths(first, last, lengths.data() + first);
+  });
+
+  // prefix sum of non-negative steps, so the table is monotone
+  m_length.assign(steps + 1, 0.0f);
+  for (size_t i = 0; i < steps; ++i)
+    m_length[i + 1] = m_length[i] + std::max(lengths[i], 0.0f);
+
+  // cell c starts at distance c / steps of the total, record the step it
+  // falls into
+  m_grid.resize(steps);
+  float total = m_length.back();
+  size_t step = 0;
+  for (size_t cell = 0; cell < steps; ++cell) {
+    float target = total * static_cast<float>(cell) / static_cast<float>(steps);
+    while (step + 1 < steps && m_length[step + 1] <= target)
+      ++step;
+    m_grid[cell] = static_cast<uint32_t>(step);
+  }
+}
+
+void ArcLengthTable::clear() {
+  m_length.clear();
+  m_grid.clear();
+}
+
+float ArcLengthTable::alphaAt(float fraction) const {
+  fraction = std::clamp(fraction, 0.0f, 1.0f);
+  float total = getLength();
+  if (total <= 0.0f)
+    return fraction;
+  size_t steps = m_grid.size();
+  float target = total * fraction;
+  size_t cell = std::min(static_cast<size_t>(fraction * static_cast<float>(steps)), steps - 1);
+  size_t step = m_grid[cell];
+  while (step + 1 < steps && m_length[step + 1] < target)
+    ++step;
+  float length = m_length[step + 1] - m_length[step];
+  float within = length > 0.0f ? std::clamp((target - m_length[step]) / length, 0.0f, 1.0f) : 0.0f;
+  return (static_cast<float>(step) + within) / static_cast<float>(steps);
+}
+
+size_t ArcLengthTable::getMemory() const {
+  return m_length.capacity() * sizeof(float) + m_grid.capacity() * sizeof(uint32_t);
+}
+
+size_t ArcLengthTable::stepsForBudget(size_t bytes) {
+  return std::max(bytes / c_bytesPerStep, c_minSteps);
+}
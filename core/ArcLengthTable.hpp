@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Cumulative distance along a track at evenly spaced alphas, for playing it
+// at constant speed. Inverting is O(1): a uniform grid over the distance
+// points at the step that contains each cell's start, and a short walk
+// refines from there.
+class ArcLengthTable {
+public:
+  static constexpr size_t c_defaultSteps = 4096;
+  static constexpr size_t c_minSteps = 16;
+  // bytes kept per step, the distance and its grid cell
+  static constexpr size_t c_bytesPerStep = sizeof(float) + sizeof(uint32_t);
+
+  // lengths[i - first] must be the distance covered by step i, from alpha
+  // i / steps to (i + 1) / steps. Called concurrently on disjoint ranges.
+  using StepLengths = std::function<void(size_t first, size_t last, float *lengths)>;
+
+  // evaluates the steps on the shared thread pool
+  void build(size_t steps, const StepLengths &stepLengths);
+  void clear();
+  inline bool empty() const { return m_length.empty(); }
+
+  // alpha at which the given fraction of the total distance is covered,
+  // the fraction itself when the track does not move at all
+  float alphaAt(float fraction) const;
+  inline float getLength() const { return m_length.empty() ? 0.0f : m_length.back(); }
+  inline size_t getSteps() const { return m_length.empty() ? 0 : m_length.size() - 1; }
+  size_t getMemory() const;
+
+  static size_t stepsForBudget(size_t bytes);
+
+private:
+  std::vector<float> m_length;
+  std::vector<uint32_t> m_grid;
+};
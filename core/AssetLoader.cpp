@@ -0,0 +1,89 @@
+#include "AssetLoader.hpp"
+#include <stdexcept>
+
+AssetLoader::AssetLoader(unsigned workers) {
+  m_workers.reserve(workers);
+  for (unsigned i = 0; i < workers; ++i)
+    m_workers.emplace_back([this](std::stop_token stop) { run(stop); });
+}
+
+AssetLoader::~AssetLoader() {
+  // jobs not started are dropped, running ones finish before the join
+  for (std::jthread &worker : m_workers)
+    worker.request_stop();
+  m_workers.clear();
+}
+
+void AssetLoader::load(std::string name, Work work) {
+  {
+    std::lock_guard lock(m_jobMutex);
+    m_jobs.push_back({std::move(name), std::move(work)});
+  }
+  ++m_queued;
+  m_wake.notify_one();
+}
+
+void AssetLoader::pump(std::chrono::duration<double> budget) {
+  auto start = std::chrono::steady_clock::now();
+  do {
+    Finished finished;
+    {
+      std::lock_guard lock(m_finishedMutex);
+      if (m_finished.empty())
+        return;
+      finished = std::move(m_finished.front());
+      m_finished.pop_front();
+    }
+    complete(finished);
+  } while (std::chrono::steady_clock::now() - start < budget);
+}
+
+void AssetLoader::finish() {
+  while (!isIdle()) {
+    Finished finished;
+    {
+      std::unique_lock lock(m_finishedMutex);
+      m_finishedChanged.wait(lock, [this] { return !m_finished.empty(); });
+      finished = std::move(m_finished.front());
+      m_finished.pop_front();
+    }
+    complete(finished);
+  }
+}
+
+void AssetLoader::complete(Finished &finished) {
+  ++m_completed;
+  m_lastCompleted = finished.name;
+  try {
+    if (finished.error)
+      std::rethrow_exception(finished.error);
+    if (finished.upload)
+      finished.upload();
+  } catch (const std::exception &e) {
+    throw std::runtime_error("Failed to load " + finished.name + ": " + e.what());
+  }
+}
+
+void AssetLoader::run(std::stop_token stop) {
+  while (!stop.stop_requested()) {
+    Job job;
+    {
+      std::unique_lock lock(m_jobMutex);
+      if (!m_wake.wait(lock, stop, [this] { return !m_jobs.empty(); }))
+        return;
+      job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+    }
+    Finished finished{std::move(job.name), {}, nullptr};
+    try {
+      finished.upload = job.work();
+    } catch (...) {
+      finished.error = std::current_exception();
+    }
+    {
+      std::lock_guard lock(m_finishedMutex);
+      m_finished.push_back(std::move(finished));
+    }
+    m_finishedChanged.notify_one();
+  }
+}
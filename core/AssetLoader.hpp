@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loads assets in two halves. The CPU half, file reads, mesh generation and
+// decoding, runs on worker threads and returns the GL half, which waits in
+// a queue until the context thread pumps it. Nothing here blocks the
+// context thread, so frames keep coming while the workers are busy.
+class AssetLoader {
+public:
+  // the GL half, run on the context thread
+  using Upload = std::function<void()>;
+  // the CPU half, run on a worker
+  using Work = std::function<Upload()>;
+
+  explicit AssetLoader(unsigned workers = 2);
+  ~AssetLoader();
+  AssetLoader(const AssetLoader &) = delete;
+  AssetLoader &operator=(const AssetLoader &) = delete;
+
+  // name is only used to report progress and errors
+  void load(std::string name, Work work);
+  // context thread: runs finished uploads until budget is spent, always at
+  // least one when there is one. An exception thrown by either half is
+  // rethrown here
+  void pump(std::chrono::duration<double> budget);
+  // context thread: waits for and uploads everything queued so far
+  void finish();
+
+  // since construction, loads are counted when their upload has run
+  inline size_t getQueued() const { return m_queued; }
+  inline size_t getCompleted() const { return m_completed; }
+  inline bool isIdle() const { return m_completed == m_queued; }
+  // the asset whose upload ran last
+  inline const std::string &getLastCompleted() const { return m_lastCompleted; }
+
+private:
+  struct Job {
+    std::string name;
+    Work work;
+  };
+  struct Finished {
+    std::string name;
+    Upload upload;
+    std::exception_ptr error;
+  };
+
+  void run(std::stop_token stop);
+  void complete(Finished &finished);
+
+  std::mutex m_jobMutex;
+  std::condition_variable_any m_wake;
+  std::deque<Job> m_jobs;
+  std::mutex m_finishedMutex;
+  std::condition_variable m_finishedChanged;
+  std::deque<Finished> m_finished;
+  // context thread only
+  size_t m_queued{0};
+  size_t m_completed{0};
+  std::string m_lastCompleted;
+  std::vector<std::jthread> m_workers;
+};
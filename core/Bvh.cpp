@@ -0,0 +1,224 @@
+#include "Bvh.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+constexpr float c_infinity = std::numeric_limits<float>::infinity();
+// deeper than any median split tree of 2^32 objects
+constexpr int c_stackSize = 64;
+
+// entry distance of the ray into the box, infinity for a miss
+float enterBox(const float *origin, const float *inverse, const float *min, const float *max,
+               float limit) {
+  float near = 0.0f, far = limit;
+  for (int a = 0; a < 3; ++a) {
+    float t0 = (min[a] - origin[a]) * inverse[a];
+    float t1 = (max[a] - origin[a]) * inverse[a];
+    // written so a NaN from a ray in the slab plane keeps the interval
+    near = std::max(near, std::min(t0, t1));
+    far = std::min(far, std::max(t0, t1));
+  }
+  return near <= far ? near : c_infinity;
+}
+} // namespace
+
+void Bvh::build(std::span<const BoundingSphere> objects) {
+  clear();
+  size_t count = objects.size();
+  if (count == 0)
+    return;
+  m_spheres.resize(count);
+  m_objects.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    const BoundingSphere &bounds = objects[i];
+    m_spheres[i] = {{bounds.center.x(), bounds.center.y(), bounds.center.z()}, bounds.radius};
+    m_objects[i] = static_cast<uint32_t>(i);
+  }
+  // a full binary tree with leaves of at least half c_leafSize
+  m_nodes.reserve(2 * (count / (c_leafSize / 2) + 1));
+  m_parent.reserve(m_nodes.capacity());
+
+  struct Range {
+    uint32_t node, begin, end, depth;
+  };
+  std::vector<Range> stack{{0, 0, static_cast<uint32_t>(count), 1}};
+  m_nodes.push_back({});
+  m_parent.push_back(c_noHit);
+  while (!stack.empty()) {
+    Range range = stack.back();
+    stack.pop_back();
+    m_depth = std::max(m_depth, range.depth);
+    uint32_t size = range.end - range.begin;
+    if (size <= c_leafSize) {
+      m_nodes[range.node].first = range.begin;
+      m_nodes[range.node].count = size;
+      continue;
+    }
+
+    // split the centers at the median of their widest axis
+    float low[3] = {c_infinity, c_infinity, c_infinity};
+    float high[3] = {-c_infinity, -c_infinity, -c_infinity};
+    for (uint32_t i = range.begin; i < range.end; ++i)
+      for (int a = 0; a < 3; ++a) {
+        low[a] = std::min(low[a], m_spheres[m_objects[i]].center[a]);
+        high[a] = std::max(high[a], m_spheres[m_objects[i]].center[a]);
+      }
+    int axis = 0;
+    for (int a = 1; a < 3; ++a)
+      if (high[a] - low[a] > high[axis] - low[axis])
+        axis = a;
+    uint32_t middle = range.begin + size / 2;
+    std::nth_element(m_objects.begin() + range.begin, m_objects.begin() + middle,
+                     m_objects.begin() + range.end, [this, axis](uint32_t a, uint32_t b) {
+                       return m_spheres[a].center[axis] < m_spheres[b].center[axis];
+                     });
+
+    uint32_t child = static_cast<uint32_t>(m_nodes.size());
+    m_nodes[range.node].first = child;
+    m_nodes[range.node].count = 0;
+    m_nodes.resize(child + 2);
+    m_parent.resize(child + 2, range.node);
+    stack.push_back({child + 1, middle, range.end, range.depth + 1});
+    stack.push_back({child, range.begin, middle, range.depth + 1});
+  }
+
+  // spheres in leaf order, each leaf reads one contiguous run
+  std::vector<Sphere> ordered(count);
+  m_slot.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    ordered[i] = m_spheres[m_objects[i]];
+    m_slot[m_objects[i]] = static_cast<uint32_t>(i);
+  }
+  m_spheres = std::move(ordered);
+  m_leaf.resize(count);
+  for (uint32_t node = 0; node < m_nodes.size(); ++node)
+    for (uint32_t i = 0; i < m_nodes[node].count; ++i)
+      m_leaf[m_nodes[node].first + i] = node;
+  for (size_t node = m_nodes.size(); node-- > 0;)
+    refitNode(static_cast<uint32_t>(node));
+}
+
+void Bvh::clear() {
+  m_nodes.clear();
+  m_parent.clear();
+  m_spheres.clear();
+  m_objects.clear();
+  m_slot.clear();
+  m_leaf.clear();
+  m_depth = 0;
+}
+
+bool Bvh::refitNode(uint32_t index) {
+  Node &node = m_nodes[index];
+  float low[3] = {c_infinity, c_infinity, c_infinity};
+  float high[3] = {-c_infinity, -c_infinity, -c_infinity};
+  if (node.count > 0) {
+    for (uint32_t i = node.first; i < node.first + node.count; ++i)
+      for (int a = 0; a < 3; ++a) {
+        low[a] = std::min(low[a], m_spheres[i].center[a] - m_spheres[i].radius);
+        high[a] = std::max(high[a], m_spheres[i].center[a] + m_spheres[i].radius);
+      }
+  } else {
+    for (uint32_t c = node.first; c < node.first + 2; ++c)
+      for (int a = 0; a < 3; ++a) {
+        low[a] = std::min(low[a], m_nodes[c].min[a]);
+        high[a] = std::max(high[a], m_nodes[c].max[a]);
+      }
+  }
+  bool changed = false;
+  for (int a = 0; a < 3; ++a) {
+    changed |= low[a] != node.min[a] || high[a] != node.max[a];
+    node.min[a] = low[a];
+    node.max[a] = high[a];
+  }
+  return changed;
+}
+
+void Bvh::move(uint32_t object, const BoundingSphere &bounds) {
+  uint32_t slot = m_slot[object];
+  m_spheres[slot] = {{bounds.center.x(), bounds.center.y(), bounds.center.z()}, bounds.radius};
+  for (uint32_t node = m_leaf[slot]; node != c_noHit && refitNode(node); node = m_parent[node])
+    ;
+}
+
+void Bvh::refit(std::span<const BoundingSphere> objects) {
+  for (size_t i = 0; i < objects.size(); ++i) {
+    const BoundingSphere &bounds = objects[i];
+    m_spheres[m_slot[i]] = {{bounds.center.x(), bounds.center.y(), bounds.center.z()},
+                            bounds.radius};
+  }
+  for (size_t node = m_nodes.size(); node-- > 0;)
+    refitNode(static_cast<uint32_t>(node));
+}
+
+RayHit Bvh::pick(const Ray &ray) const {
+  RayHit hit{c_noHit, c_infinity};
+  m_visited = 0;
+  if (m_nodes.empty())
+    return hit;
+  float length = std::sqrt(ray.direction * ray.direction);
+  if (length == 0.0f)
+    return hit;
+  const float origin[3] = {ray.origin.x(), ray.origin.y(), ray.origin.z()};
+  const float direction[3] = {ray.direction.x() / length, ray.direction.y() / length,
+                              ray.direction.z() / length};
+  const float inverse[3] = {1.0f / direction[0], 1.0f / direction[1], 1.0f / direction[2]};
+
+  // nodes still to visit with the distance their box was entered at
+  struct Entry {
+    uint32_t node;
+    float distance;
+  };
+  Entry stack[c_stackSize];
+  int top = 0;
+  float rootDistance = enterBox(origin, inverse, m_nodes[0].min, m_nodes[0].max, c_infinity);
+  ++m_visited;
+  if (rootDistance != c_infinity)
+    stack[top++] = {0, rootDistance};
+  while (top > 0) {
+    Entry entry = stack[--top];
+    // something nearer was found since it was pushed
+    if (entry.distance > hit.distance)
+      continue;
+    const Node &node = m_nodes[entry.node];
+    if (node.count > 0) {
+      for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+        const Sphere &sphere = m_spheres[i];
+        float offset[3] = {origin[0] - sphere.center[0], origin[1] - sphere.center[1],
+                           origin[2] - sphere.center[2]};
+        float b = offset[0] * direction[0] + offset[1] * direction[1] + offset[2] * direction[2];
+        // r^2 minus the squared distance of the center from the ray, which
+        // unlike b^2 - c keeps its precision far from the origin
+        float discriminant = sphere.radius * sphere.radius;
+        for (int a = 0; a < 3; ++a) {
+          float across = offset[a] - b * direction[a];
+          discriminant -= across * across;
+        }
+        if (discriminant < 0.0f)
+          continue;
+        float root = std::sqrt(discriminant);
+        // from inside a sphere the ray starts in it
+        float t = std::max(-b - root, 0.0f);
+        if (-b + root >= 0.0f && t < hit.distance)
+          hit = {m_objects[i], t};
+      }
+      continue;
+    }
+    uint32_t near = node.first, far = node.first + 1;
+    float nearDistance =
+        enterBox(origin, inverse, m_nodes[near].min, m_nodes[near].max, hit.distance);
+    float farDistance = enterBox(origin, inverse, m_nodes[far].min, m_nodes[far].max, hit.distance);
+    m_visited += 2;
+    if (farDistance < nearDistance) {
+      std::swap(near, far);
+      std::swap(nearDistance, farDistance);
+    }
+    // the nearer child is popped first
+    if (farDistance != c_infinity)
+      stack[top++] = {far, farDistance};
+    if (nearDistance != c_infinity)
+      stack[top++] = {near, nearDistance};
+  }
+  return hit;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Frustum.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+struct Ray {
+  math137::Vector3f origin;
+  // need not be normalized
+  math137::Vector3f direction;
+};
+
+struct RayHit {
+  // index into the spheres the tree was built from, c_noHit for a miss
+  uint32_t object;
+  // along the normalized direction, to where the ray enters the sphere
+  float distance;
+};
+
+// Bounding volume hierarchy of boxes over bounding spheres, for picking.
+// Built once by median splits along the widest axis, so it stays balanced
+// and a query visits O(log n) nodes when the objects do not overlap much.
+// Objects that move afterwards only refit the boxes on their path to the
+// root, the topology is kept until the next build.
+class Bvh {
+public:
+  static constexpr uint32_t c_noHit = UINT32_MAX;
+  // objects per leaf at most
+  static constexpr uint32_t c_leafSize = 4;
+
+  void build(std::span<const BoundingSphere> objects);
+  void clear();
+  // widens or shrinks the boxes above the object, stopping at the first
+  // one that did not change
+  void move(uint32_t object, const BoundingSphere &bounds);
+  // every object at once, cheaper than moving most of them one by one
+  void refit(std::span<const BoundingSphere> objects);
+  // the nearest object whose sphere the ray hits in front of its origin
+  RayHit pick(const Ray &ray) const;
+
+  inline bool empty() const { return m_nodes.empty(); }
+  inline size_t getObjectCount() const { return m_spheres.size(); }
+  inline size_t getNodeCount() const { return m_nodes.size(); }
+  inline uint32_t getDepth() const { return m_depth; }
+  // nodes whose box the last pick tested
+  inline uint32_t getVisited() const { return m_visited; }
+
+private:
+  struct Node {
+    float min[3];
+    // first child for interior nodes, the second follows it, else the
+    // first sphere of the leaf
+    uint32_t first;
+    float max[3];
+    // spheres of a leaf, 0 for interior nodes
+    uint32_t count;
+  };
+  struct Sphere {
+    float center[3];
+    float radius;
+  };
+
+  // bounds of a node from its spheres or children, true if they changed
+  bool refitNode(uint32_t node);
+
+  // parents precede their children, so a reverse walk refits bottom up
+  std::vector<Node> m_nodes;
+  std::vector<uint32_t> m_parent;
+  // in leaf order, and the leaf and slot of every object
+  std::vector<Sphere> m_spheres;
+  std::vector<uint32_t> m_objects;
+  std::vector<uint32_t> m_slot;
+  std::vector<uint32_t> m_leaf;
+  uint32_t m_depth{0};
+  mutable uint32_t m_visited{0};
+};
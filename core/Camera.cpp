@@ -43,12 +43,22 @@ void Camera::recalculateView() {
   m_view = math137::MatrixUtils::LookAt(m_position, m_target, {0.f, 1.f, 0.f});
 }
 
-void Camera::rotateCamera(float dx, float dy) {
+void Camera::addAngles(float dx, float dy) {
   m_yaw += (sensitivity * dx);
   m_pitch += (sensitivity * dy);
   if (m_pitch >= M_PI_2)
     m_pitch = M_PI_2 - 0.01f;
   if (m_pitch <= -M_PI_2)
     m_pitch = -M_PI_2 + 0.01f;
+}
+
+void Camera::rotateCamera(float dx, float dy) {
+  addAngles(dx, dy);
+  recalculateView();
+}
+
+void Camera::applyInput(float dx, float dy, float distanceDelta) {
+  addAngles(dx, dy);
+  addDistance(distanceDelta);
   recalculateView();
 }
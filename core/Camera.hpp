@@ -12,6 +12,8 @@ public:
   inline math137::Vector3f getPosition() const { return m_position; }
   math137::Matrix4f getInverseView() const;
   void rotateCamera(float dx, float dy);
+  // rotate and zoom in one step, recomputing the view only once
+  void applyInput(float dx, float dy, float distanceDelta);
 
   inline void setTarget(const math137::Vector3f &v) {
     m_target = v;
@@ -28,15 +30,20 @@ public:
   }
 
   inline void changeDistance(float dx) {
-    m_distance += dx;
-    constexpr float eps = 0.01f;
-    if (m_distance < eps)
-      m_distance = eps;
+    addDistance(dx);
     recalculateView();
   }
 
 private:
   void recalculateView();
+  // the clamped steps, without recomputing the view
+  void addAngles(float dx, float dy);
+  inline void addDistance(float dx) {
+    m_distance += dx;
+    constexpr float eps = 0.01f;
+    if (m_distance < eps)
+      m_distance = eps;
+  }
 
   float m_distance;
   float m_yaw;
@@ -1,74 +1,70 @@
 #include "Cursor.hpp"
 #include "MatrixUtils.hpp"
-#include <GL/glew.h>
+#include "Packing.hpp"
+#include "Rotation.hpp"
+#include "Simd.hpp"
+#include <cmath>
 
 Cursor::Cursor()
     : m_position{0.0f, 0.0f, 0.0f}, m_rotation{math137::MatrixUtils::Identity()} {
         recalculateModelMatrix();
-        glGenBuffers(1, &m_vbo);
-        glGenBuffers(1, &m_ebo);
-        glGenVertexArrays(1, &m_vao);
-        glBindVertexArray(m_vao);
-        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-        auto vertices = generateVertices();
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(math137::Vector3f), vertices.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(math137::Vector3f), (void*)0);
-        glEnableVertexAttribArray(0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-        auto indices = generateIndices();
-        m_indexCount = static_cast<uint32_t>(indices.size());
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
-        glBindVertexArray(0);
     }
 
-Cursor::~Cursor()
-{
-    glDeleteBuffers(1, &m_vbo);
-    glDeleteBuffers(1, &m_ebo);
-    glDeleteVertexArrays(1, &m_vao);
+void Cursor::recalculateModelMatrix() {
+    m_model = Simd::translate(m_position.x(), m_position.y(), m_position.z(), m_rotation);
 }
 
-void Cursor::recalculateModelMatrix() {
-    m_model = math137::MatrixUtils::Translate(m_position.x(), m_position.y(), m_position.z()) * m_rotation;
+static void writeAxis(const float *model, const float (&rotation)[4], uint32_t color,
+                      int viewport, CursorInstance &instance) {
+    for (int i = 0; i < 3; ++i)
+        instance.translation[i] = model[i * 4 + 3];
+    instance.color = color;
+    // the shader reads x, y, z, w
+    for (int i = 0; i < 4; ++i)
+        instance.rotation[i] = Packing::toSnorm16(rotation[(i + 1) % 4]);
+    instance.viewport = viewport;
+    instance.padding = 0;
 }
 
-void Cursor::render(std::unique_ptr<Renderer> &renderer)
-{
-    recalculateModelMatrix();
-    renderer->setModel(m_model);
-    renderer->setShader(ShaderType::OBJECT);
-    glBindVertexArray(m_vao);
-    // Z axis (original) - blue
-    renderer->setColor(math137::Vector4f{0.0f, 0.0f, 1.0f, 1.0f});
-    glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0);
+void Cursor::appendInstances(const math137::Matrix4f &model, int viewport,
+                             std::vector<CursorInstance> &instances) {
+    math137::Quaternion q = Rotation::matrixToQuaternion(model);
+    const float rotation[4] = {q.a, q.b, q.c, q.d};
+    instances.resize(instances.size() + 3);
+    writeInstances(model.data(), rotation, viewport, &instances[instances.size() - 3]);
+}
 
-    // Y axis - green (rotate cylinder so its length points along +Y)
-    {
-        auto rotY = math137::MatrixUtils::RotateX(-static_cast<float>(M_PI_2));
-        renderer->setModel(m_model * rotY);
-        renderer->setColor(math137::Vector4f{0.0f, 1.0f, 0.0f, 1.0f});
-        glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0);
-    }
+void Cursor::writeInstances(const float *model, const float *rotation, int viewport,
+                            CursorInstance *out) {
+    // the cylinder points along +Z, the other two axes are it turned by a
+    // quarter about X and Y
+    constexpr float c_half = 0.70710678f;
+    static const float toY[4] = {c_half, -c_half, 0.0f, 0.0f};
+    static const float toX[4] = {c_half, 0.0f, c_half, 0.0f};
+    static const uint32_t blue = Packing::toUnorm4x8({0.0f, 0.0f, 1.0f, 1.0f});
+    static const uint32_t green = Packing::toUnorm4x8({0.0f, 1.0f, 0.0f, 1.0f});
+    static const uint32_t red = Packing::toUnorm4x8({1.0f, 0.0f, 0.0f, 1.0f});
 
-    // X axis - red (rotate cylinder so its length points along +X)
-    {
-        auto rotX = math137::MatrixUtils::RotateY(static_cast<float>(M_PI_2));
-        renderer->setModel(m_model * rotX);
-        renderer->setColor(math137::Vector4f{1.0f, 0.0f, 0.0f, 1.0f});
-        glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0);
-    }
-    //glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_INT, 0);
+    const float *q = rotation;
+    float length = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    float unit[4] = {q[0] / length, q[1] / length, q[2] / length, q[3] / length};
+    float turned[4];
+    writeAxis(model, unit, blue, viewport, out[0]);
+    Simd::multiplyQuaternion(unit, toY, turned);
+    writeAxis(model, turned, green, viewport, out[1]);
+    Simd::multiplyQuaternion(unit, toX, turned);
+    writeAxis(model, turned, red, viewport, out[2]);
 }
 
-std::vector<math137::Vector3f> Cursor::generateVertices()
+std::vector<math137::Vector3f> Cursor::generateVertices(uint16_t segments)
 {
     std::vector<math137::Vector3f> vertices;
-    vertices.reserve((radiusSegments + 1) * 2);
+    vertices.reserve((segments + 1) * 2);
 
     for (uint16_t i = 0; i < 2; ++i) {
         float z = (cursorLength * i);
-        for (uint16_t j = 0; j <= radiusSegments; ++j) {
-            float angle = (2.0f * M_PI * j) / radiusSegments;
+        for (uint16_t j = 0; j <= segments; ++j) {
+            float angle = (2.0f * M_PI * j) / segments;
             float x = cursorRadius * cosf(angle);
             float y = cursorRadius * sinf(angle);
             vertices.emplace_back(x, y, z);
@@ -79,14 +75,14 @@ std::vector<math137::Vector3f> Cursor::generateVertices()
 }
 
 
-std::vector<uint32_t> Cursor::generateIndices() {
+std::vector<uint32_t> Cursor::generateIndices(uint16_t segments) {
     std::vector<uint32_t> indices;
-    indices.reserve(radiusSegments * 2 * 6);
+    indices.reserve(segments * 2 * 6);
 
     for (uint16_t i = 0; i < 2; ++i) {
-        for (uint16_t j = 0; j < radiusSegments; ++j) {
-            uint32_t first = (i * (radiusSegments + 1)) + j;
-            uint32_t second = first + radiusSegments + 1;
+        for (uint16_t j = 0; j < segments; ++j) {
+            uint32_t first = (i * (segments + 1)) + j;
+            uint32_t second = first + segments + 1;
 
             indices.push_back(first);
             indices.push_back(second);
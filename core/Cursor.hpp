@@ -2,32 +2,57 @@
 
 #include <Vector.hpp>
 #include <Quaternion.hpp>
-#include "Renderer.hpp"
+#include <Matrix.hpp>
+#include <vector>
+#include "Frustum.hpp"
+#include <cstdint>
+
+// one axis of a cursor as the instanced shaders read it, mirrors the std430
+// Instance struct in instanced.vs. The transform is rigid, so a unit
+// quaternion and a translation replace the 4x4 matrix.
+struct CursorInstance {
+    float translation[3];
+    // RGBA8, unpackUnorm4x8
+    uint32_t color;
+    // x, y, z, w as SNORM16, two unpackSnorm2x16
+    int16_t rotation[4];
+    int32_t viewport;
+    int32_t padding;
+};
+static_assert(sizeof(CursorInstance) == 32);
 
 class Cursor {
 public:
     Cursor();
-    ~Cursor();
     inline void setPosition(const math137::Vector3f& pos) { m_position = pos; }
     inline void setRotation(const math137::Matrix4f& rot) { m_rotation = rot; }
     inline math137::Vector3f getPosition() const { return m_position; }
     inline math137::Matrix4f getRotation() const { return m_rotation; }
+    inline BoundingSphere getBounds() const { return {m_position, boundingRadius}; }
+
+    inline const math137::Matrix4f& getModel() const { return m_model; }
 
     void recalculateModelMatrix();
-    void render(std::unique_ptr<Renderer>& renderer);
-private:
-    std::vector<math137::Vector3f> generateVertices();
-    std::vector<uint32_t> generateIndices();
-    
+
+    // axis cylinder geometry, shared by every cursor through CursorBatch
+    static std::vector<math137::Vector3f> generateVertices(uint16_t segments = radiusSegments);
+    static std::vector<uint32_t> generateIndices(uint16_t segments = radiusSegments);
+    // the three axis instances of a cursor with the given model matrix
+    static void appendInstances(const math137::Matrix4f& model, int viewport,
+                                std::vector<CursorInstance>& instances);
+    // the same into out[0..2], from a row-major model matrix and its
+    // rotation as a quaternion, a b c d, for callers converting in batches
+    static void writeInstances(const float* model, const float* rotation, int viewport,
+                               CursorInstance* out);
+
    static constexpr float cursorRadius = 0.02f;
    static constexpr float cursorLength = 0.2f;
    static constexpr uint16_t radiusSegments = 16;
+   // encloses all three axes around the cursor origin
+   static constexpr float boundingRadius = cursorLength + cursorRadius;
 
+private:
     math137::Matrix4f m_model;
     math137::Matrix4f m_rotation;
     math137::Vector3f m_position;
-    uint32_t m_vao;
-    uint32_t m_vbo;
-    uint32_t m_ebo;
-    uint32_t m_indexCount;
-};
\ No newline at end of file
+};
@@ -0,0 +1,268 @@
+#include "CursorBatch.hpp"
+#include "Cursor.hpp"
+#include "MatrixUtils.hpp"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+
+CursorBatch::Geometry CursorBatch::generateGeometry() {
+  Geometry geometry;
+  for (int lod = 0; lod < c_lodCount; ++lod) {
+    geometry.vertices[lod] = Cursor::generateVertices(c_lodSegments[lod]);
+    geometry.indices[lod] = Cursor::generateIndices(c_lodSegments[lod]);
+  }
+  return geometry;
+}
+
+CursorBatch::CursorBatch(MeshPool &meshPool)
+    : CursorBatch(meshPool, generateGeometry()) {}
+
+CursorBatch::CursorBatch(MeshPool &meshPool, const Geometry &geometry)
+    : m_meshPool(meshPool), m_capacity(0), m_selectedCapacity(0) {
+  for (int lod = 0; lod < c_lodCount; ++lod)
+    m_meshes[lod] = m_meshPool.add(geometry.vertices[lod], geometry.indices[lod]);
+  glCreateBuffers(1, &m_ssbo);
+  glCreateBuffers(1, &m_selectedSsbo);
+  glCreateBuffers(1, &m_commandBuffer);
+  glNamedBufferData(m_commandBuffer, c_lodCount * sizeof(DrawCommand),
+                    nullptr, GL_DYNAMIC_DRAW);
+  glCreateBuffers(1, &m_readbackBuffer);
+  GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  GLsizeiptr size = c_readbackSlots * c_lodCount * sizeof(DrawCommand);
+  glNamedBufferStorage(m_readbackBuffer, size, nullptr, flags);
+  m_readbackData = static_cast<const DrawCommand *>(
+      glMapNamedBufferRange(m_readbackBuffer, 0, size, flags));
+}
+
+CursorBatch::~CursorBatch() {
+  glDeleteBuffers(1, &m_ssbo);
+  glDeleteBuffers(1, &m_selectedSsbo);
+  glDeleteBuffers(1, &m_commandBuffer);
+  for (Readback &readback : m_readbacks)
+    if (readback.fence)
+      glDeleteSync(readback.fence);
+  glUnmapNamedBuffer(m_readbackBuffer);
+  glDeleteBuffers(1, &m_readbackBuffer);
+}
+
+void CursorBatch::add(const math137::Matrix4f &model, int viewport) {
+  Cursor::appendInstances(model, viewport, m_instances);
+}
+
+void CursorBatch::addInstances(std::span<const CursorInstance> instances, int viewport) {
+  size_t first = m_instances.size();
+  m_instances.insert(m_instances.end(), instances.begin(), instances.end());
+  for (size_t i = first; i < m_instances.size(); ++i)
+    m_instances[i].viewport = viewport;
+}
+
+void CursorBatch::cull() {
+  size_t count = m_instances.size();
+  size_t kept = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const Instance &instance = m_instances[i];
+    const float *t = instance.translation;
+    if (m_frustums[instance.viewport].isVisible(t[0], t[1], t[2],
+                                                Cursor::boundingRadius))
+      m_instances[kept++] = instance;
+  }
+  m_instances.resize(kept);
+  m_stats.culled += static_cast<uint32_t>(count - kept);
+}
+
+int CursorBatch::selectLod(const Instance &instance,
+                           const std::unique_ptr<Renderer> &renderer) const {
+  const Viewport &vp = renderer->getViewport(instance.viewport);
+  math137::Vector3f camera = renderer->getCameraPosition();
+  float dx = instance.translation[0] - camera.x();
+  float dy = instance.translation[1] - camera.y();
+  float dz = instance.translation[2] - camera.z();
+  float distance = std::max(sqrtf(dx * dx + dy * dy + dz * dz), 1e-4f);
+  float pixelScale = vp.projection.getValue(1, 1) * vp.height * 0.5f;
+  float pixels = Cursor::cursorLength * pixelScale / distance;
+
+  int lod = 0;
+  while (lod < c_lodCount - 1 && pixels < c_lodThresholds[lod])
+    ++lod;
+  return lod;
+}
+
+void CursorBatch::upload(uint32_t buffer, size_t &capacity, const void *data,
+                         size_t size) {
+  if (size > capacity) {
+    capacity = size * 2;
+    glNamedBufferData(buffer, capacity, nullptr, GL_DYNAMIC_DRAW);
+  }
+  if (data) {
+    glNamedBufferSubData(buffer, 0, size, data);
+    m_stats.uploadedBytes += size;
+  }
+}
+
+void CursorBatch::flush(const std::unique_ptr<Renderer> &renderer) {
+  if (m_instances.empty())
+    return;
+
+  m_stats.submitted += static_cast<uint32_t>(m_instances.size());
+  for (int i = 0; i < renderer->getViewportCount(); ++i) {
+    const Viewport &vp = renderer->getViewport(i);
+    m_frustums[i] = m_culling ? Frustum(vp.projection * renderer->getView())
+                              : Frustum();
+  }
+  // the compute pass culls on its own
+  if (m_lodMode != LodMode::GPU) {
+    cull();
+    m_stats.drawn += static_cast<uint32_t>(m_instances.size());
+    if (m_instances.empty())
+      return;
+  }
+
+  m_meshPool.bind();
+  switch (m_lodMode) {
+  case LodMode::OFF:
+    drawUnsorted(renderer);
+    break;
+  case LodMode::CPU:
+    drawCpuSelected(renderer);
+    break;
+  case LodMode::GPU:
+    drawGpuSelected(renderer);
+    break;
+  }
+  glBindVertexArray(0);
+  renderer->setShader(ShaderType::OBJECT);
+
+  m_instances.clear();
+}
+
+void CursorBatch::drawUnsorted(const std::unique_ptr<Renderer> &renderer) {
+  upload(m_ssbo, m_capacity, m_instances.data(),
+         m_instances.size() * sizeof(Instance));
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_ssbo);
+
+  renderer->setShader(ShaderType::INSTANCED);
+  m_meshPool.draw(m_meshes[0], GL_TRIANGLES,
+                  static_cast<GLsizei>(m_instances.size()));
+  ++m_stats.drawCalls;
+}
+
+void CursorBatch::drawCpuSelected(const std::unique_ptr<Renderer> &renderer) {
+  // counting sort by level so each level is a contiguous instance range
+  m_lodCounts.fill(0);
+  m_instanceLods.resize(m_instances.size());
+  for (size_t i = 0; i < m_instances.size(); ++i) {
+    int lod = selectLod(m_instances[i], renderer);
+    m_instanceLods[i] = static_cast<uint8_t>(lod);
+    ++m_lodCounts[lod];
+  }
+  for (int lod = 0; lod < c_lodCount; ++lod)
+    m_stats.lods[lod] += m_lodCounts[lod];
+  std::array<uint32_t, c_lodCount> offsets{};
+  for (int lod = 1; lod < c_lodCount; ++lod)
+    offsets[lod] = offsets[lod - 1] + m_lodCounts[lod - 1];
+  m_sorted.resize(m_instances.size());
+  for (size_t i = 0; i < m_instances.size(); ++i)
+    m_sorted[offsets[m_instanceLods[i]]++] = m_instances[i];
+
+  upload(m_ssbo, m_capacity, m_sorted.data(),
+         m_sorted.size() * sizeof(Instance));
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_ssbo);
+
+  renderer->setShader(ShaderType::INSTANCED);
+  uint32_t first = 0;
+  for (int lod = 0; lod < c_lodCount; ++lod) {
+    if (m_lodCounts[lod] == 0)
+      continue;
+    const Mesh &mesh = m_meshes[lod];
+    glDrawElementsInstancedBaseVertexBaseInstance(
+        GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT,
+        (void *)(mesh.firstIndex * sizeof(uint32_t)), m_lodCounts[lod],
+        mesh.baseVertex, first);
+    first += m_lodCounts[lod];
+    ++m_stats.drawCalls;
+  }
+}
+
+void CursorBatch::readGpuStats() {
+  // oldest first, stopping at the first copy the GPU has not finished, so
+  // the counters arrive a few flushes late instead of stalling this one
+  while (m_readbackTail != m_readbackHead) {
+    Readback &readback = m_readbacks[m_readbackTail % c_readbackSlots];
+    GLenum status = glClientWaitSync(readback.fence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+      return;
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+    const DrawCommand *commands = m_readbackData + (m_readbackTail % c_readbackSlots) * c_lodCount;
+    uint32_t drawn = 0;
+    for (int lod = 0; lod < c_lodCount; ++lod)
+      drawn += commands[lod].instanceCount;
+    m_stats.drawn += drawn;
+    m_stats.culled += readback.submitted - drawn;
+    ++m_readbackTail;
+  }
+}
+
+void CursorBatch::queueReadback(uint32_t submitted) {
+  // with every slot in flight the counters of this flush are not reported
+  if (m_readbackHead - m_readbackTail == c_readbackSlots)
+    return;
+  size_t slot = m_readbackHead % c_readbackSlots;
+  glCopyNamedBufferSubData(m_commandBuffer, m_readbackBuffer, 0,
+                           slot * c_lodCount * sizeof(DrawCommand),
+                           c_lodCount * sizeof(DrawCommand));
+  m_readbacks[slot] = {glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), submitted};
+  ++m_readbackHead;
+}
+
+void CursorBatch::drawGpuSelected(const std::unique_ptr<Renderer> &renderer) {
+  readGpuStats();
+  uint32_t count = static_cast<uint32_t>(m_instances.size());
+  upload(m_ssbo, m_capacity, m_instances.data(), count * sizeof(Instance));
+  // every level may receive all instances, so reserve a full range for each
+  upload(m_selectedSsbo, m_selectedCapacity, nullptr,
+         c_lodCount * count * sizeof(Instance));
+
+  std::array<DrawCommand, c_lodCount> commands;
+  for (int lod = 0; lod < c_lodCount; ++lod)
+    commands[lod] = {m_meshes[lod].indexCount, 0, m_meshes[lod].firstIndex,
+                     m_meshes[lod].baseVertex, lod * count};
+  glNamedBufferSubData(m_commandBuffer, 0, sizeof(commands), commands.data());
+
+  std::array<float, Renderer::c_maxViewports> pixelScales{};
+  float planes[Renderer::c_maxViewports][6][4];
+  for (int i = 0; i < renderer->getViewportCount(); ++i) {
+    const Viewport &vp = renderer->getViewport(i);
+    pixelScales[i] = vp.projection.getValue(1, 1) * vp.height * 0.5f;
+    m_frustums[i].getPlanes(planes[i]);
+  }
+
+  renderer->setShader(ShaderType::SELECT);
+  const Shader &select = renderer->getShader();
+  select.setUInt("instanceCount", count);
+  select.setVec3("cameraPos", renderer->getCameraPosition());
+  select.setFloat("objectSize", Cursor::cursorLength);
+  select.setFloat("boundingRadius", Cursor::boundingRadius);
+  select.setVec4Array("frustumPlanes", &planes[0][0][0],
+                      6 * renderer->getViewportCount());
+  select.setFloatArray("pixelScale", pixelScales.data(),
+                       renderer->getViewportCount());
+  select.setFloatArray("lodThresholds", c_lodThresholds.data(),
+                       c_lodThresholds.size());
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_ssbo);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_selectedSsbo);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_commandBuffer);
+  glDispatchCompute((count + 63) / 64, 1, 1);
+  // the counters are also copied to the readback ring after the draw
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT |
+                  GL_BUFFER_UPDATE_BARRIER_BIT);
+
+  renderer->setShader(ShaderType::INSTANCED);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_selectedSsbo);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+  glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr,
+                              c_lodCount, 0);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  queueReadback(count);
+  m_stats.drawCalls += 2;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "Cursor.hpp"
+#include "Frustum.hpp"
+#include "Matrix.hpp"
+#include "MeshPool.hpp"
+#include "Renderer.hpp"
+#include <GL/glew.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+enum class LodMode { OFF, CPU, GPU };
+
+// Collects every cursor drawn in a frame and submits them with one instance
+// buffer upload over a shared axis mesh. Cursors outside their viewport's
+// frustum are dropped and the rest pick a level of detail of that mesh from
+// their projected size, either on the CPU or in a compute pass that writes
+// the indirect draw commands.
+class CursorBatch {
+public:
+  static constexpr int c_lodCount = 4;
+  static constexpr std::array<uint16_t, c_lodCount> c_lodSegments{16, 8, 5, 3};
+  // minimum projected axis length in pixels for every level but the last
+  static constexpr std::array<float, c_lodCount - 1> c_lodThresholds{48.f, 16.f,
+                                                                     6.f};
+
+  // the axis mesh of every level, generated without a context
+  struct Geometry {
+    std::array<std::vector<math137::Vector3f>, c_lodCount> vertices;
+    std::array<std::vector<uint32_t>, c_lodCount> indices;
+  };
+  static Geometry generateGeometry();
+
+  // generates the geometry on the calling thread
+  CursorBatch(MeshPool &meshPool);
+  CursorBatch(MeshPool &meshPool, const Geometry &geometry);
+  ~CursorBatch();
+  CursorBatch(const CursorBatch &) = delete;
+  CursorBatch &operator=(const CursorBatch &) = delete;
+
+  void add(const math137::Matrix4f &model, int viewport);
+  // appends prebuilt axis instances, as cached for ghost frames, retargeted
+  // to the viewport
+  void addInstances(std::span<const CursorInstance> instances, int viewport);
+  void flush(const std::unique_ptr<Renderer> &renderer);
+  inline size_t getInstanceCount() const { return m_instances.size(); }
+
+  // counted in axis instances, three per cursor, since the last reset
+  struct Stats {
+    uint32_t submitted;
+    uint32_t culled;
+    uint32_t drawn;
+    // per level, only known when selection runs on the CPU
+    std::array<uint32_t, c_lodCount> lods;
+    // draw and dispatch calls issued
+    uint32_t drawCalls;
+    // written to the instance buffers
+    uint64_t uploadedBytes;
+  };
+
+  inline void setLodMode(LodMode mode) { m_lodMode = mode; }
+  inline LodMode getLodMode() const { return m_lodMode; }
+  inline void setCulling(bool enabled) { m_culling = enabled; }
+  inline bool getCulling() const { return m_culling; }
+  inline const Stats &getStats() const { return m_stats; }
+  inline void resetStats() { m_stats = {}; }
+
+private:
+  using Instance = CursorInstance;
+
+  // layout expected by glMultiDrawElementsIndirect
+  struct DrawCommand {
+    uint32_t count;
+    uint32_t instanceCount;
+    uint32_t firstIndex;
+    int32_t baseVertex;
+    uint32_t baseInstance;
+  };
+
+  int selectLod(const Instance &instance,
+                const std::unique_ptr<Renderer> &renderer) const;
+  void upload(uint32_t buffer, size_t &capacity, const void *data,
+              size_t size);
+  void cull();
+  // adds the counters of every finished readback to the stats
+  void readGpuStats();
+  void queueReadback(uint32_t submitted);
+  void drawUnsorted(const std::unique_ptr<Renderer> &renderer);
+  void drawCpuSelected(const std::unique_ptr<Renderer> &renderer);
+  void drawGpuSelected(const std::unique_ptr<Renderer> &renderer);
+
+  std::vector<Instance> m_instances;
+  std::vector<Instance> m_sorted;
+  std::vector<uint8_t> m_instanceLods;
+  std::array<uint32_t, c_lodCount> m_lodCounts{};
+  std::array<Frustum, Renderer::c_maxViewports> m_frustums;
+  LodMode m_lodMode{LodMode::CPU};
+  bool m_culling{true};
+  Stats m_stats{};
+  // the compute pass's commands are copied to a persistently mapped ring
+  // and read once their fence has signalled, never waiting on the GPU
+  static constexpr size_t c_readbackSlots = 8;
+  struct Readback {
+    GLsync fence;
+    // instances submitted to the compute pass
+    uint32_t submitted;
+  };
+  std::array<Readback, c_readbackSlots> m_readbacks{};
+  // next slot to write and oldest unread one
+  size_t m_readbackHead{0};
+  size_t m_readbackTail{0};
+  uint32_t m_readbackBuffer;
+  const DrawCommand *m_readbackData{nullptr};
+
+  MeshPool &m_meshPool;
+  std::array<Mesh, c_lodCount> m_meshes;
+  uint32_t m_ssbo;
+  uint32_t m_selectedSsbo;
+  uint32_t m_commandBuffer;
+  size_t m_capacity;
+  size_t m_selectedCapacity;
+};
@@ -0,0 +1,79 @@
+#include "DynamicResolution.hpp"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+
+DynamicResolution::~DynamicResolution() { release(); }
+
+void DynamicResolution::begin(int width, int height) {
+  if (width != m_width || height != m_height)
+    allocate(width, height);
+
+  adjustScale();
+  m_renderWidth = std::max(1, static_cast<int>(m_width * m_scale));
+  m_renderHeight = std::max(1, static_cast<int>(m_height * m_scale));
+
+  glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+  m_timer.begin();
+}
+
+void DynamicResolution::end() {
+  m_timer.end();
+  glBlitNamedFramebuffer(m_fbo, 0, 0, 0, m_renderWidth, m_renderHeight, 0, 0,
+                         m_width, m_height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void DynamicResolution::allocate(int width, int height) {
+  // the target always has the full framebuffer size, scale changes only
+  // change the rectangle rendered into and never reallocate
+  release();
+  m_width = width;
+  m_height = height;
+
+  glCreateTextures(GL_TEXTURE_2D, 1, &m_color);
+  glTextureStorage2D(m_color, 1, GL_RGBA8, width, height);
+  glTextureParameteri(m_color, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTextureParameteri(m_color, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  glCreateRenderbuffers(1, &m_depthStencil);
+  glNamedRenderbufferStorage(m_depthStencil, GL_DEPTH24_STENCIL8, width,
+                             height);
+
+  glCreateFramebuffers(1, &m_fbo);
+  glNamedFramebufferTexture(m_fbo, GL_COLOR_ATTACHMENT0, m_color, 0);
+  glNamedFramebufferRenderbuffer(m_fbo, GL_DEPTH_STENCIL_ATTACHMENT,
+                                 GL_RENDERBUFFER, m_depthStencil);
+}
+
+void DynamicResolution::release() {
+  if (m_fbo == 0)
+    return;
+  glDeleteFramebuffers(1, &m_fbo);
+  glDeleteTextures(1, &m_color);
+  glDeleteRenderbuffers(1, &m_depthStencil);
+  m_fbo = m_color = m_depthStencil = 0;
+}
+
+void DynamicResolution::adjustScale() {
+  double gpuTime;
+  bool measured = m_timer.poll(gpuTime);
+  if (measured)
+    m_gpuTime = gpuTime;
+  if (!m_enabled) {
+    m_scale = 1.0f;
+    return;
+  }
+  if (!measured)
+    return;
+
+  // cost follows the pixel count, i.e. the square of the scale; only react
+  // outside a band around the budget to avoid oscillating
+  if (gpuTime > m_budget || gpuTime < m_budget * 0.8) {
+    double step = std::sqrt(m_budget / std::max(gpuTime, 0.01));
+    step = std::clamp(step, 0.85, 1.05);
+    m_scale = std::clamp(static_cast<float>(m_scale * step), c_minScale, 1.0f);
+  }
+}
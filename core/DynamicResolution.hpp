@@ -0,0 +1,51 @@
+#pragma once
+
+#include "GpuTimer.hpp"
+#include <cstdint>
+
+// Renders the scene into an offscreen target sized to the framebuffer and
+// draws into a scaled sub-rectangle of it, then upscales that rectangle to
+// the real framebuffer. The scale follows the measured GPU time of the
+// scene pass towards a frame time budget.
+class DynamicResolution {
+public:
+  static constexpr float c_minScale = 0.5f;
+
+  DynamicResolution() = default;
+  ~DynamicResolution();
+  DynamicResolution(const DynamicResolution &) = delete;
+  DynamicResolution &operator=(const DynamicResolution &) = delete;
+
+  // binds and clears the offscreen target for a framebuffer of this size
+  void begin(int width, int height);
+  // upscales into the default framebuffer
+  void end();
+
+  // size of the area scene passes should render into
+  inline int getWidth() const { return m_renderWidth; }
+  inline int getHeight() const { return m_renderHeight; }
+  inline float getScale() const { return m_scale; }
+  inline double getGpuTime() const { return m_gpuTime; }
+
+  inline void setEnabled(bool enabled) { m_enabled = enabled; }
+  inline bool getEnabled() const { return m_enabled; }
+  inline void setBudget(double milliseconds) { m_budget = milliseconds; }
+  inline double getBudget() const { return m_budget; }
+
+private:
+  void allocate(int width, int height);
+  void release();
+  void adjustScale();
+
+  GpuTimer m_timer;
+  uint32_t m_fbo{0};
+  uint32_t m_color{0};
+  uint32_t m_depthStencil{0};
+  int m_width{0}, m_height{0};
+  int m_renderWidth{0}, m_renderHeight{0};
+
+  bool m_enabled{true};
+  float m_scale{1.0f};
+  double m_budget{12.0};
+  double m_gpuTime{0.0};
+};
@@ -0,0 +1,62 @@
+#include "FrameArena.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+
+FrameArena::FrameArena(size_t capacity)
+    : m_buffer(std::make_unique<std::byte[]>(capacity)), m_capacity(capacity) {}
+
+void FrameArena::reset() {
+  m_peak = std::max(m_peak, m_used + m_overflowBytes);
+  if (!m_overflow.empty()) {
+    // alignment padding is not in the byte counts, leave room for it
+    m_capacity = std::bit_ceil(m_peak + m_peak / 8);
+    m_buffer = std::make_unique<std::byte[]>(m_capacity);
+    m_overflow.clear();
+  }
+  m_used = 0;
+  m_overflowBytes = 0;
+}
+
+void *FrameArena::do_allocate(size_t bytes, size_t alignment) {
+  auto base = reinterpret_cast<uintptr_t>(m_buffer.get());
+  uintptr_t aligned = (base + m_used + alignment - 1) & ~(uintptr_t(alignment) - 1);
+  if (aligned + bytes <= base + m_capacity) {
+    m_used = aligned + bytes - base;
+    return reinterpret_cast<void *>(aligned);
+  }
+
+  // only until the next reset makes the buffer big enough
+  ++m_overflowCount;
+  m_overflowBytes += bytes;
+  m_overflow.push_back(std::make_unique<std::byte[]>(bytes + alignment));
+  auto block = reinterpret_cast<uintptr_t>(m_overflow.back().get());
+  return reinterpret_cast<void *>((block + alignment - 1) & ~(uintptr_t(alignment) - 1));
+}
+
+const char *FrameArena::format(const char *fmt, ...) {
+  char *remaining = reinterpret_cast<char *>(m_buffer.get()) + m_used;
+  size_t space = m_capacity - m_used;
+  va_list args;
+  va_start(args, fmt);
+  int length = std::vsnprintf(remaining, space, fmt, args);
+  va_end(args);
+  if (length < 0)
+    return "";
+  if (static_cast<size_t>(length) < space) {
+    m_used += length + 1;
+    return remaining;
+  }
+  char *text = static_cast<char *>(allocate(length + 1, 1));
+  va_start(args, fmt);
+  std::vsnprintf(text, length + 1, fmt, args);
+  va_end(args);
+  return text;
+}
+
+FrameArena::Stats FrameArena::getStats() const {
+  return {m_used + m_overflowBytes, m_capacity, std::max(m_peak, m_used + m_overflowBytes),
+          m_overflowCount};
+}
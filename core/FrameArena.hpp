@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+// Bump allocator for data that only lives until the end of the frame, also
+// usable as the resource of std::pmr containers. reset() releases everything
+// at once. Requests that do not fit go to the heap until the next reset,
+// which grows the buffer to the frame's peak, so a steady frame allocates
+// nothing after the first few. Main thread only.
+class FrameArena : public std::pmr::memory_resource {
+public:
+  static constexpr size_t c_defaultCapacity = 64 * 1024;
+
+  struct Stats {
+    // bytes handed out since the last reset, including overflow
+    size_t used;
+    size_t capacity;
+    size_t peak;
+    // requests that missed the buffer since the arena was created
+    uint64_t overflows;
+  };
+
+  explicit FrameArena(size_t capacity = c_defaultCapacity);
+
+  void reset();
+
+  template <typename T> std::span<T> allocateArray(size_t count) {
+    return {static_cast<T *>(allocate(count * sizeof(T), alignof(T))), count};
+  }
+  // printf into the arena, valid until the next reset
+  const char *format(const char *fmt, ...);
+
+  Stats getStats() const;
+
+private:
+  void *do_allocate(size_t bytes, size_t alignment) override;
+  // everything is released by reset
+  void do_deallocate(void *, size_t, size_t) override {}
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+  std::unique_ptr<std::byte[]> m_buffer;
+  size_t m_capacity;
+  size_t m_used{0};
+  size_t m_peak{0};
+  std::vector<std::unique_ptr<std::byte[]>> m_overflow;
+  size_t m_overflowBytes{0};
+  uint64_t m_overflowCount{0};
+};
@@ -0,0 +1,91 @@
+#include "FramePacer.hpp"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+FramePacer::FramePacer(double targetRate)
+    : m_targetRate(targetRate), m_lastPresent(clock::now()),
+      m_wakeUp(m_lastPresent) {}
+
+void FramePacer::setPresentMode(PresentMode mode) {
+  // tearing on late frames needs the swap_control_tear extensions
+  if (mode == PresentMode::ADAPTIVE_VSYNC &&
+      !glfwExtensionSupported("WGL_EXT_swap_control_tear") &&
+      !glfwExtensionSupported("GLX_EXT_swap_control_tear"))
+    mode = PresentMode::VSYNC;
+
+  m_mode = mode;
+  switch (mode) {
+  case PresentMode::VSYNC:
+    glfwSwapInterval(1);
+    break;
+  case PresentMode::ADAPTIVE_VSYNC:
+    glfwSwapInterval(-1);
+    break;
+  case PresentMode::UNLOCKED:
+    glfwSwapInterval(0);
+    break;
+  }
+}
+
+void FramePacer::waitForFrame() {
+  if (m_targetRate > 0.0) {
+    auto period = std::chrono::duration<double>(1.0 / m_targetRate);
+    auto deadline = m_lastPresent + period;
+    // start the frame as late as the predicted work allows
+    if (m_lateSampling)
+      deadline -= std::chrono::duration<double>(
+          std::min(m_predictedWork + c_safetyMargin, period.count()));
+    sleepUntil(std::chrono::time_point_cast<clock::duration>(deadline));
+  }
+  m_wakeUp = clock::now();
+}
+
+void FramePacer::frameSubmitted() {
+  double work =
+      std::chrono::duration<double>(clock::now() - m_wakeUp).count();
+  // rise fast and decay slowly, a missed deadline costs more than idling
+  m_predictedWork = work > m_predictedWork
+                        ? work
+                        : m_predictedWork * 0.95 + work * 0.05;
+}
+
+void FramePacer::framePresented() {
+  auto now = clock::now();
+  double frame = std::chrono::duration<double>(now - m_lastPresent).count();
+  m_lastPresent = now;
+
+  m_frameTimes[m_frameCount % c_historySize] = frame;
+  ++m_frameCount;
+}
+
+FramePacer::Stats FramePacer::getStats() const {
+  size_t count = std::min(m_frameCount, c_historySize);
+  Stats stats{0.0, 0.0, 0.0, m_predictedWork * 1000.0};
+  if (count == 0)
+    return stats;
+
+  double sum = 0.0, worst = 0.0;
+  for (size_t i = 0; i < count; ++i) {
+    sum += m_frameTimes[i];
+    worst = std::max(worst, m_frameTimes[i]);
+  }
+  double mean = sum / count;
+  double variance = 0.0;
+  for (size_t i = 0; i < count; ++i)
+    variance += (m_frameTimes[i] - mean) * (m_frameTimes[i] - mean);
+  stats.averageFrame = mean * 1000.0;
+  stats.jitter = std::sqrt(variance / count) * 1000.0;
+  stats.worstFrame = worst * 1000.0;
+  return stats;
+}
+
+void FramePacer::sleepUntil(clock::time_point deadline) const {
+  auto spin = std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>(c_spinThreshold));
+  if (clock::now() < deadline - spin)
+    std::this_thread::sleep_until(deadline - spin);
+  while (clock::now() < deadline)
+    std::this_thread::yield();
+}
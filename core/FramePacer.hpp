@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+enum class PresentMode { VSYNC, ADAPTIVE_VSYNC, UNLOCKED };
+
+// Paces the main loop to a target frame rate. With late sampling enabled it
+// sleeps until just before the next deadline, minus the predicted cost of a
+// frame, so input is polled and the simulation sampled as late as possible.
+class FramePacer {
+public:
+  using clock = std::chrono::steady_clock;
+
+  struct Stats {
+    // milliseconds, over the last c_historySize frames
+    double averageFrame;
+    double jitter;
+    double worstFrame;
+    // wake up to submission, what late sampling has to leave room for
+    double predictedWork;
+  };
+
+  FramePacer(double targetRate);
+
+  // GLFW swap interval, must be called with the context current
+  void setPresentMode(PresentMode mode);
+  inline PresentMode getPresentMode() const { return m_mode; }
+  // frames per second, zero disables pacing
+  inline void setTargetRate(double rate) { m_targetRate = rate; }
+  inline double getTargetRate() const { return m_targetRate; }
+  inline void setLateSampling(bool enabled) { m_lateSampling = enabled; }
+  inline bool getLateSampling() const { return m_lateSampling; }
+
+  // before polling input
+  void waitForFrame();
+  // once the frame is submitted, before the buffer swap, which blocks
+  // until the vblank when synchronized
+  void frameSubmitted();
+  // right after the buffer swap
+  void framePresented();
+  Stats getStats() const;
+
+private:
+  static constexpr size_t c_historySize = 120;
+  // kept between the wake up and the predicted deadline
+  static constexpr double c_safetyMargin = 0.002;
+  // final stretch spent yielding instead of sleeping, for timer slack
+  static constexpr double c_spinThreshold = 0.001;
+
+  void sleepUntil(clock::time_point deadline) const;
+
+  PresentMode m_mode{PresentMode::VSYNC};
+  double m_targetRate;
+  bool m_lateSampling{false};
+
+  clock::time_point m_lastPresent;
+  clock::time_point m_wakeUp;
+  double m_predictedWork{0.0};
+  std::array<double, c_historySize> m_frameTimes{};
+  size_t m_frameCount{0};
+};
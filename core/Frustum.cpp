@@ -0,0 +1,65 @@
+#include "Frustum.hpp"
+#include "Simd.hpp"
+#include <cmath>
+
+Frustum::Frustum() {
+  // every lane starts as a padding plane that never rejects anything
+  for (int i = 0; i < 8; ++i) {
+    m_nx[i] = m_ny[i] = m_nz[i] = 0.0f;
+    m_d[i] = 1.0f;
+  }
+}
+
+Frustum::Frustum(const math137::Matrix4f &viewProjection) : Frustum() {
+  // Gribb-Hartmann: each plane is the last row plus or minus another row
+  auto m = [&viewProjection](int r, int c) {
+    return viewProjection.getValue(r, c);
+  };
+  for (int i = 0; i < 6; ++i) {
+    int row = i / 2;
+    float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+    float a = m(3, 0) + sign * m(row, 0);
+    float b = m(3, 1) + sign * m(row, 1);
+    float c = m(3, 2) + sign * m(row, 2);
+    float d = m(3, 3) + sign * m(row, 3);
+    float length = sqrtf(a * a + b * b + c * c);
+    m_nx[i] = a / length;
+    m_ny[i] = b / length;
+    m_nz[i] = c / length;
+    m_d[i] = d / length;
+  }
+}
+
+bool Frustum::isVisible(float x, float y, float z, float radius) const {
+#if SIMD_SSE
+  __m128 cx = _mm_set1_ps(x);
+  __m128 cy = _mm_set1_ps(y);
+  __m128 cz = _mm_set1_ps(z);
+  __m128 limit = _mm_set1_ps(-radius);
+  int outside = 0;
+  for (int i = 0; i < 8; i += 4) {
+    __m128 distance = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(_mm_load_ps(m_nx + i), cx),
+                   _mm_mul_ps(_mm_load_ps(m_ny + i), cy)),
+        _mm_add_ps(_mm_mul_ps(_mm_load_ps(m_nz + i), cz),
+                   _mm_load_ps(m_d + i)));
+    outside |= _mm_movemask_ps(_mm_cmplt_ps(distance, limit));
+  }
+  return outside == 0;
+#else
+  for (int i = 0; i < 6; ++i) {
+    if (m_nx[i] * x + m_ny[i] * y + m_nz[i] * z + m_d[i] < -radius)
+      return false;
+  }
+  return true;
+#endif
+}
+
+void Frustum::getPlanes(float (&planes)[6][4]) const {
+  for (int i = 0; i < 6; ++i) {
+    planes[i][0] = m_nx[i];
+    planes[i][1] = m_ny[i];
+    planes[i][2] = m_nz[i];
+    planes[i][3] = m_d[i];
+  }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Matrix.hpp"
+#include "Vector.hpp"
+
+struct BoundingSphere {
+  math137::Vector3f center;
+  float radius;
+};
+
+// View frustum as six inward facing planes, stored as structure of arrays
+// padded to eight lanes so a sphere is tested against all planes at once.
+class Frustum {
+public:
+  Frustum();
+  Frustum(const math137::Matrix4f &viewProjection);
+
+  bool isVisible(float x, float y, float z, float radius) const;
+  inline bool isVisible(const BoundingSphere &sphere) const {
+    return isVisible(sphere.center.x(), sphere.center.y(), sphere.center.z(),
+                     sphere.radius);
+  }
+  // planes as (nx, ny, nz, d), for upload to shaders
+  void getPlanes(float (&planes)[6][4]) const;
+
+private:
+  alignas(16) float m_nx[8];
+  alignas(16) float m_ny[8];
+  alignas(16) float m_nz[8];
+  alignas(16) float m_d[8];
+};
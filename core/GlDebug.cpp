@@ -0,0 +1,272 @@
+#include "GlDebug.hpp"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#ifdef GL_DEBUG_STACKTRACE
+#include <stacktrace>
+#endif
+
+namespace {
+// driver notes about buffer placement and shader recompiles, not problems
+constexpr GLuint c_ignoredIds[] = {131169, 131185, 131218, 131204};
+
+const char *sourceName(GLenum source) {
+  switch (source) {
+  case GL_DEBUG_SOURCE_API:
+    return "API";
+  case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
+    return "Window System";
+  case GL_DEBUG_SOURCE_SHADER_COMPILER:
+    return "Shader Compiler";
+  case GL_DEBUG_SOURCE_THIRD_PARTY:
+    return "Third Party";
+  case GL_DEBUG_SOURCE_APPLICATION:
+    return "Application";
+  default:
+    return "Other";
+  }
+}
+
+const char *typeName(GLenum type) {
+  switch (type) {
+  case GL_DEBUG_TYPE_ERROR:
+    return "Error";
+  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+    return "Deprecated Behaviour";
+  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+    return "Undefined Behaviour";
+  case GL_DEBUG_TYPE_PORTABILITY:
+    return "Portability";
+  case GL_DEBUG_TYPE_PERFORMANCE:
+    return "Performance";
+  case GL_DEBUG_TYPE_MARKER:
+    return "Marker";
+  case GL_DEBUG_TYPE_PUSH_GROUP:
+    return "Push Group";
+  case GL_DEBUG_TYPE_POP_GROUP:
+    return "Pop Group";
+  default:
+    return "Other";
+  }
+}
+
+const char *severityName(GLenum severity) {
+  switch (severity) {
+  case GL_DEBUG_SEVERITY_HIGH:
+    return "high";
+  case GL_DEBUG_SEVERITY_MEDIUM:
+    return "medium";
+  case GL_DEBUG_SEVERITY_LOW:
+    return "low";
+  default:
+    return "notification";
+  }
+}
+
+const char *errorName(GLenum error) {
+  switch (error) {
+  case GL_INVALID_ENUM:
+    return "INVALID_ENUM";
+  case GL_INVALID_VALUE:
+    return "INVALID_VALUE";
+  case GL_INVALID_OPERATION:
+    return "INVALID_OPERATION";
+  case GL_STACK_OVERFLOW:
+    return "STACK_OVERFLOW";
+  case GL_STACK_UNDERFLOW:
+    return "STACK_UNDERFLOW";
+  case GL_OUT_OF_MEMORY:
+    return "OUT_OF_MEMORY";
+  case GL_INVALID_FRAMEBUFFER_OPERATION:
+    return "INVALID_FRAMEBUFFER_OPERATION";
+  default:
+    return "UNKNOWN_ERROR";
+  }
+}
+
+// the id, and FNV-1a over source, type and text above it. Drivers reuse
+// one id for messages naming different objects or sizes, those must each
+// be printed once.
+uint64_t keyOf(GLenum source, GLenum type, GLuint id, const char *text) {
+  uint32_t hash = 2166136261u;
+  auto mix = [&hash](uint32_t byte) { hash = (hash ^ byte) * 16777619u; };
+  for (int shift = 0; shift < 32; shift += 8) {
+    mix((source >> shift) & 0xffu);
+    mix((type >> shift) & 0xffu);
+  }
+  for (const char *c = text; *c; ++c)
+    mix(static_cast<unsigned char>(*c));
+  // 0 marks an empty slot
+  if (hash == 0)
+    hash = 1;
+  return static_cast<uint64_t>(id) | static_cast<uint64_t>(hash) << 32;
+}
+} // namespace
+
+GlDebugMode parseGlDebugMode(std::string_view name) {
+  if (name == "off")
+    return GlDebugMode::OFF;
+  if (name == "async")
+    return GlDebugMode::ASYNC;
+  if (name == "sync")
+    return GlDebugMode::SYNC;
+  throw std::invalid_argument("Unknown GL debug mode " + std::string(name));
+}
+
+void GlDebug::hintContext(GlDebugMode mode) {
+  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, mode != GlDebugMode::OFF ? GLFW_TRUE : GLFW_FALSE);
+}
+
+GlDebug::GlDebug(GlDebugMode mode, std::ostream &out) : m_out(out), m_mode(GlDebugMode::OFF) {
+  GLint flags = 0;
+  glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+  m_debugContext = (flags & GL_CONTEXT_FLAG_DEBUG_BIT) != 0;
+  glDebugMessageCallback(callback, this);
+  glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+  glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, std::size(c_ignoredIds),
+                        c_ignoredIds, GL_FALSE);
+  setMode(mode);
+}
+
+GlDebug::~GlDebug() {
+  glDisable(GL_DEBUG_OUTPUT);
+  glDebugMessageCallback(nullptr, nullptr);
+  if (m_thread.joinable()) {
+    m_thread.request_stop();
+    m_thread.join();
+  }
+  drainOnce();
+}
+
+void GlDebug::setMode(GlDebugMode mode) {
+  m_mode.store(mode, std::memory_order_relaxed);
+  if (mode == GlDebugMode::OFF) {
+    glDisable(GL_DEBUG_OUTPUT);
+    return;
+  }
+  glEnable(GL_DEBUG_OUTPUT);
+  if (mode == GlDebugMode::SYNC)
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  else
+    glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  // started on first use, so OFF never has a thread
+  if (!m_thread.joinable())
+    m_thread = std::jthread([this](std::stop_token stop) { drain(stop); });
+}
+
+void GlDebug::checkErrors(const char *file, int line) {
+  if (getMode() != GlDebugMode::SYNC)
+    return;
+  GLenum error;
+  while ((error = glGetError()) != GL_NO_ERROR) {
+    std::lock_guard lock(m_outMutex);
+    m_out << errorName(error) << " | " << file << " (" << line << ")\n";
+  }
+}
+
+GlDebug::Stats GlDebug::getStats() const {
+  return {m_received.load(std::memory_order_relaxed), m_repeats.load(std::memory_order_relaxed),
+          m_rateLimited.load(std::memory_order_relaxed), m_dropped.load(std::memory_order_relaxed)};
+}
+
+void APIENTRY GlDebug::callback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                GLsizei length, const GLchar *text, const void *user) {
+  auto *debug = const_cast<GlDebug *>(static_cast<const GlDebug *>(user));
+  Message message{source, type, severity, id, {}};
+  size_t size = length < 0 ? std::strlen(text) : static_cast<size_t>(length);
+  size = std::min(size, sizeof(message.text) - 1);
+  std::memcpy(message.text, text, size);
+  message.text[size] = '\0';
+  debug->receive(message, debug->getMode() == GlDebugMode::SYNC);
+}
+
+void GlDebug::receive(const Message &message, bool synchronous) {
+  m_received.fetch_add(1, std::memory_order_relaxed);
+  if (!firstOccurrence(keyOf(message.source, message.type, message.id, message.text))) {
+    m_repeats.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  if (!withinRate()) {
+    m_rateLimited.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  if (synchronous) {
+    // on the thread of the call that caused it, so the backtrace points at it
+    std::lock_guard lock(m_outMutex);
+    write(message);
+#ifdef GL_DEBUG_STACKTRACE
+    m_out << std::stacktrace::current(2) << "\n";
+#endif
+    m_out.flush();
+    return;
+  }
+  if (!m_queue.push(message))
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool GlDebug::firstOccurrence(uint64_t key) {
+  size_t slot = static_cast<size_t>((key * 0x9e3779b97f4a7c15ull) >> 54) & (c_tableSize - 1);
+  for (size_t probe = 0; probe < c_tableSize; ++probe, slot = (slot + 1) & (c_tableSize - 1)) {
+    uint64_t stored = m_keys[slot].load(std::memory_order_acquire);
+    if (stored == 0) {
+      // claim the empty slot, or find out which key beat us to it
+      if (m_keys[slot].compare_exchange_strong(stored, key, std::memory_order_acq_rel))
+        stored = key;
+    }
+    if (stored == key)
+      return m_counts[slot].fetch_add(1, std::memory_order_relaxed) == 0;
+  }
+  // every slot taken, report without deduplicating
+  return true;
+}
+
+bool GlDebug::withinRate() {
+  int64_t second = std::chrono::duration_cast<std::chrono::seconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                       .count();
+  int64_t window = m_rateWindow.load(std::memory_order_relaxed);
+  if (window != second &&
+      m_rateWindow.compare_exchange_strong(window, second, std::memory_order_relaxed))
+    m_rateCount.store(0, std::memory_order_relaxed);
+  return m_rateCount.fetch_add(1, std::memory_order_relaxed) < c_maxPerSecond;
+}
+
+void GlDebug::write(const Message &message) {
+  m_out << "GL " << severityName(message.severity) << " " << typeName(message.type) << " from "
+        << sourceName(message.source) << " (" << message.id << "): " << message.text << "\n";
+}
+
+void GlDebug::drain(std::stop_token stop) {
+  while (!stop.stop_requested()) {
+    {
+      std::unique_lock lock(m_wakeMutex);
+      m_wake.wait_for(lock, stop, c_drainInterval, [] { return false; });
+    }
+    drainOnce();
+  }
+}
+
+void GlDebug::drainOnce() {
+  std::lock_guard lock(m_outMutex);
+  Message message;
+  bool wrote = false;
+  while (m_queue.pop(message)) {
+    write(message);
+    wrote = true;
+  }
+  for (size_t slot = 0; slot < c_tableSize; ++slot) {
+    uint32_t count = m_counts[slot].load(std::memory_order_relaxed);
+    if (count <= m_reported[slot] + 1)
+      continue;
+    uint64_t key = m_keys[slot].load(std::memory_order_relaxed);
+    m_out << "GL message " << (key & 0xffffffffu) << " repeated "
+          << count - 1 - m_reported[slot] << " more times\n";
+    m_reported[slot] = count - 1;
+    wrote = true;
+  }
+  if (wrote)
+    m_out.flush();
+}
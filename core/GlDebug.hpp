@@ -0,0 +1,112 @@
+#pragma once
+
+#include "MpscQueue.hpp"
+#include <GL/glew.h>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <thread>
+
+// OFF costs nothing: no debug context, no debug output, no thread. ASYNC
+// lets the driver report from any thread at any time, messages are queued
+// and written by a thread of their own. SYNC reports on the thread of the
+// offending call with its backtrace, and checks glGetError every frame.
+enum class GlDebugMode : uint8_t { OFF, ASYNC, SYNC };
+
+// set with -DINTERPOLATION_GL_DEBUG, overridden by --gl-debug
+#ifndef GL_DEBUG_DEFAULT
+#define GL_DEBUG_DEFAULT OFF
+#endif
+constexpr GlDebugMode c_defaultGlDebugMode = GlDebugMode::GL_DEBUG_DEFAULT;
+
+// "off", "async" or "sync"
+GlDebugMode parseGlDebugMode(std::string_view name);
+
+// Receives the GL debug output of the current context. Repeats of a message
+// are only counted, and new messages beyond c_maxPerSecond are dropped, so
+// a message raised every draw call cannot flood the log or stall the
+// driver's thread.
+class GlDebug {
+public:
+  static constexpr uint32_t c_maxPerSecond = 20;
+  // how often queued messages and repeat counts are written
+  static constexpr std::chrono::milliseconds c_drainInterval{100};
+
+  // before the window is created, a debug context is only requested when
+  // the mode is not OFF
+  static void hintContext(GlDebugMode mode);
+
+  // with the context current, mode may differ from the hinted one
+  GlDebug(GlDebugMode mode, std::ostream &out);
+  // the context must still be current
+  ~GlDebug();
+  GlDebug(const GlDebug &) = delete;
+  GlDebug &operator=(const GlDebug &) = delete;
+
+  void setMode(GlDebugMode mode);
+  inline GlDebugMode getMode() const { return m_mode.load(std::memory_order_relaxed); }
+  // whether the context was created with the debug flag, drivers report
+  // less or nothing without it
+  inline bool hasDebugContext() const { return m_debugContext; }
+  // reports pending glGetError codes, SYNC only since it stalls the pipeline
+  void checkErrors(const char *file, int line);
+
+  struct Stats {
+    uint64_t received;
+    uint64_t repeats;
+    uint64_t rateLimited;
+    // the queue was full
+    uint64_t dropped;
+  };
+  Stats getStats() const;
+
+private:
+  struct Message {
+    GLenum source;
+    GLenum type;
+    GLenum severity;
+    GLuint id;
+    char text[256];
+  };
+
+  static void APIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                GLsizei length, const GLchar *message, const void *user);
+  void receive(const Message &message, bool synchronous);
+  // true for the first time source, type, id and text occur
+  bool firstOccurrence(uint64_t key);
+  bool withinRate();
+  void write(const Message &message);
+  void drain(std::stop_token stop);
+  void drainOnce();
+
+  std::ostream &m_out;
+  std::mutex m_outMutex;
+  std::atomic<GlDebugMode> m_mode;
+  bool m_debugContext{false};
+
+  MpscQueue<Message, 256> m_queue;
+  // open addressing over the (source, type, id, text) keys seen so far,
+  // with the number of times each arrived
+  static constexpr size_t c_tableSize = 1024;
+  std::array<std::atomic<uint64_t>, c_tableSize> m_keys{};
+  std::array<std::atomic<uint32_t>, c_tableSize> m_counts{};
+  // repeats already written, drain thread only
+  std::array<uint32_t, c_tableSize> m_reported{};
+  std::atomic<int64_t> m_rateWindow{0};
+  std::atomic<uint32_t> m_rateCount{0};
+
+  std::atomic<uint64_t> m_received{0};
+  std::atomic<uint64_t> m_repeats{0};
+  std::atomic<uint64_t> m_rateLimited{0};
+  std::atomic<uint64_t> m_dropped{0};
+
+  std::mutex m_wakeMutex;
+  std::condition_variable_any m_wake;
+  std::jthread m_thread;
+};
+
+#define glCheckError(debug) (debug).checkErrors(__FILE__, __LINE__)
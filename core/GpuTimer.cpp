@@ -0,0 +1,38 @@
+#include "GpuTimer.hpp"
+#include <GL/glew.h>
+
+GpuTimer::GpuTimer() {
+  glCreateQueries(GL_TIME_ELAPSED, c_queryCount, m_queries.data());
+}
+
+GpuTimer::~GpuTimer() { glDeleteQueries(c_queryCount, m_queries.data()); }
+
+void GpuTimer::begin() {
+  m_active = m_issued - m_collected < c_queryCount;
+  if (m_active)
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[m_issued % c_queryCount]);
+}
+
+void GpuTimer::end() {
+  if (!m_active)
+    return;
+  glEndQuery(GL_TIME_ELAPSED);
+  ++m_issued;
+}
+
+bool GpuTimer::poll(double &milliseconds) {
+  bool found = false;
+  while (m_collected != m_issued) {
+    uint32_t query = m_queries[m_collected % c_queryCount];
+    GLint available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+      break;
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+    milliseconds = nanoseconds / 1.0e6;
+    found = true;
+    ++m_collected;
+  }
+  return found;
+}
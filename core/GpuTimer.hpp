@@ -0,0 +1,29 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Measures GPU time between begin() and end() with a small ring of
+// GL_TIME_ELAPSED queries. Results are collected a few frames later once
+// the GPU has produced them, so timing never stalls the pipeline.
+class GpuTimer {
+public:
+  GpuTimer();
+  ~GpuTimer();
+  GpuTimer(const GpuTimer &) = delete;
+  GpuTimer &operator=(const GpuTimer &) = delete;
+
+  void begin();
+  void end();
+  // newest finished measurement in milliseconds, false if none is ready
+  bool poll(double &milliseconds);
+
+private:
+  static constexpr uint32_t c_queryCount = 4;
+
+  std::array<uint32_t, c_queryCount> m_queries;
+  uint32_t m_issued{0};
+  uint32_t m_collected{0};
+  // false when every query is still in flight and this frame is skipped
+  bool m_active{false};
+};
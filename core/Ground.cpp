@@ -1,44 +1,35 @@
 #include "Ground.hpp"
 #include <GL/glew.h>
 #include <MatrixUtils.hpp>
+#include <numeric>
 
-Ground::Ground() {
-  glGenVertexArrays(1, &m_vao);
-  glGenBuffers(1, &m_vbo);
-  glBindVertexArray(m_vao);
-  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-  auto vertices = getGrid();
-  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float),
-               vertices.data(), GL_STATIC_DRAW);
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-  glBindVertexArray(0);
+Ground::Ground(MeshPool &meshPool) : Ground(meshPool, getGrid()) {}
+
+Ground::Ground(MeshPool &meshPool, std::span<const math137::Vector3f> grid)
+    : m_meshPool(meshPool) {
+  std::vector<uint32_t> indices(grid.size());
+  std::iota(indices.begin(), indices.end(), 0u);
+  m_mesh = m_meshPool.add(grid, indices);
 }
 
 void Ground::render(const std::unique_ptr<Renderer> &renderer) {
-  glBindVertexArray(m_vao);
+  m_meshPool.bind();
   renderer->setModel(math137::MatrixUtils::Identity());
   renderer->setColor({1.f, 1.f, 1.f, 1.f});
-  glDrawArrays(GL_LINES, 0, (c_gridSize * 4 / c_gapSize + 1) * 4);
+  // one instance per active viewport, base.vs routes each to its viewport
+  renderer->setViewportIndex(-1);
+  m_meshPool.draw(m_mesh, GL_LINES, renderer->getViewportCount());
   glBindVertexArray(0);
 }
 
-std::vector<float> Ground::getGrid() {
-  std::vector<float> vertices;
+std::vector<math137::Vector3f> Ground::getGrid() {
+  std::vector<math137::Vector3f> vertices;
   for (float i = -c_gridSize; i <= c_gridSize; i += c_gapSize) {
-    vertices.push_back(i);
-    vertices.push_back(0.0f);
-    vertices.push_back(-c_gridSize);
-    vertices.push_back(i);
-    vertices.push_back(0.0f);
-    vertices.push_back(c_gridSize);
+    vertices.emplace_back(i, 0.0f, -c_gridSize);
+    vertices.emplace_back(i, 0.0f, c_gridSize);
 
-    vertices.push_back(-c_gridSize);
-    vertices.push_back(0.0f);
-    vertices.push_back(i);
-    vertices.push_back(c_gridSize);
-    vertices.push_back(0.0f);
-    vertices.push_back(i);
+    vertices.emplace_back(-c_gridSize, 0.0f, i);
+    vertices.emplace_back(c_gridSize, 0.0f, i);
   }
 
   return vertices;
@@ -2,10 +2,18 @@
 
 #include <cstdint>
 #include <memory>
+#include "MeshPool.hpp"
 #include "Renderer.hpp" 
+#include <span>
+#include <vector>
 class Ground {
 public:
-  Ground();
+  // grid lines as pairs of end points, generated without a context
+  static std::vector<math137::Vector3f> getGrid();
+
+  // generates the grid on the calling thread
+  Ground(MeshPool &meshPool);
+  Ground(MeshPool &meshPool, std::span<const math137::Vector3f> grid);
   void render(const std::unique_ptr<Renderer> &renderer);
 
 protected:
@@ -15,8 +23,6 @@ private:
   static constexpr float c_gapSize = 1.f;
   static constexpr uint16_t c_gridCount = 24 * (c_gridSize / c_gapSize);
 
-  std::vector<float> getGrid();
-  uint32_t m_vao;
-  uint32_t m_vbo;
-  uint32_t m_ebo;
+  MeshPool &m_meshPool;
+  Mesh m_mesh;
 };
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "SpscQueue.hpp"
+#include <cstdint>
+
+enum class InputEventType : uint8_t { CURSOR_MOVE, SCROLL, MOUSE_BUTTON };
+
+struct InputEvent {
+  InputEventType type;
+  // cursor position, scroll offsets, or button and action
+  double x, y;
+  int button;
+  int action;
+  // glfwGetTime() when the event arrived
+  double timestamp;
+};
+
+// filled by the GLFW callbacks, drained once per frame
+using InputQueue = SpscQueue<InputEvent, 1024>;
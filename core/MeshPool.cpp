@@ -0,0 +1,123 @@
+#include "MeshPool.hpp"
+#include "Packing.hpp"
+#include <algorithm>
+#include <cstring>
+
+MeshPool::MeshPool(size_t vertexCapacity, size_t indexCapacity)
+    : m_vertexCapacity(vertexCapacity), m_indexCapacity(indexCapacity) {
+  glCreateBuffers(1, &m_vbo);
+  glCreateBuffers(1, &m_ebo);
+  glNamedBufferData(m_vbo, m_vertexCapacity * sizeof(PackedVertex),
+                    nullptr, GL_STATIC_DRAW);
+  glNamedBufferData(m_ebo, m_indexCapacity * sizeof(uint32_t), nullptr,
+                    GL_STATIC_DRAW);
+
+  glCreateVertexArrays(1, &m_vao);
+  glVertexArrayVertexBuffer(m_vao, 0, m_vbo, 0, sizeof(PackedVertex));
+  glVertexArrayElementBuffer(m_vao, m_ebo);
+  glEnableVertexArrayAttrib(m_vao, 0);
+  glVertexArrayAttribFormat(m_vao, 0, 3, GL_HALF_FLOAT, GL_FALSE, 0);
+  glVertexArrayAttribBinding(m_vao, 0, 0);
+}
+
+MeshPool::~MeshPool() {
+  glDeleteBuffers(1, &m_vbo);
+  glDeleteBuffers(1, &m_ebo);
+  glDeleteVertexArrays(1, &m_vao);
+}
+
+Mesh MeshPool::add(std::span<const math137::Vector3f> positions,
+                   std::span<const uint32_t> indices) {
+  std::vector<PackedVertex> packed(positions.size());
+  for (size_t i = 0; i < positions.size(); ++i)
+    packed[i] = {{Packing::toHalf(positions[i].x()), Packing::toHalf(positions[i].y()),
+                  Packing::toHalf(positions[i].z()), 0}};
+  std::span<const PackedVertex> vertices = packed;
+  uint64_t key = hash(vertices, indices);
+  auto [first, last] = m_lookup.equal_range(key);
+  for (auto it = first; it != last; ++it) {
+    if (matches(m_meshes[it->second], vertices, indices))
+      return m_meshes[it->second];
+  }
+
+  reserve(m_vertices.size() + vertices.size(),
+          m_indices.size() + indices.size());
+
+  Mesh mesh{static_cast<int32_t>(m_vertices.size()),
+            static_cast<uint32_t>(m_indices.size()),
+            static_cast<uint32_t>(indices.size()),
+            static_cast<uint32_t>(vertices.size())};
+  glNamedBufferSubData(m_vbo, mesh.baseVertex * sizeof(PackedVertex),
+                       vertices.size_bytes(), vertices.data());
+  glNamedBufferSubData(m_ebo, mesh.firstIndex * sizeof(uint32_t),
+                       indices.size_bytes(), indices.data());
+  m_vertices.insert(m_vertices.end(), vertices.begin(), vertices.end());
+  m_indices.insert(m_indices.end(), indices.begin(), indices.end());
+
+  m_lookup.emplace(key, m_meshes.size());
+  m_meshes.push_back(mesh);
+  return mesh;
+}
+
+void MeshPool::bind() const { glBindVertexArray(m_vao); }
+
+void MeshPool::draw(const Mesh &mesh, GLenum mode,
+                    GLsizei instanceCount) const {
+  glDrawElementsInstancedBaseVertex(
+      mode, mesh.indexCount, GL_UNSIGNED_INT,
+      (void *)(mesh.firstIndex * sizeof(uint32_t)), instanceCount,
+      mesh.baseVertex);
+}
+
+uint64_t MeshPool::hash(std::span<const PackedVertex> vertices,
+                        std::span<const uint32_t> indices) {
+  // FNV-1a over the raw bytes of both streams
+  uint64_t h = 14695981039346656037ull;
+  auto mix = [&h](const void *data, size_t size) {
+    auto bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+      h ^= bytes[i];
+      h *= 1099511628211ull;
+    }
+  };
+  mix(vertices.data(), vertices.size_bytes());
+  mix(indices.data(), indices.size_bytes());
+  return h;
+}
+
+bool MeshPool::matches(const Mesh &mesh,
+                       std::span<const PackedVertex> vertices,
+                       std::span<const uint32_t> indices) const {
+  return mesh.vertexCount == vertices.size() &&
+         mesh.indexCount == indices.size() &&
+         std::memcmp(m_vertices.data() + mesh.baseVertex, vertices.data(),
+                     vertices.size_bytes()) == 0 &&
+         std::memcmp(m_indices.data() + mesh.firstIndex, indices.data(),
+                     indices.size_bytes()) == 0;
+}
+
+void MeshPool::reserve(size_t vertexCount, size_t indexCount) {
+  // grow by replacing the buffers and refilling them from the CPU copies,
+  // the vertex array is repointed so existing Mesh handles stay valid
+  if (vertexCount > m_vertexCapacity) {
+    m_vertexCapacity = std::max(vertexCount, m_vertexCapacity * 2);
+    glDeleteBuffers(1, &m_vbo);
+    glCreateBuffers(1, &m_vbo);
+    glNamedBufferData(m_vbo, m_vertexCapacity * sizeof(PackedVertex),
+                      nullptr, GL_STATIC_DRAW);
+    glNamedBufferSubData(m_vbo, 0,
+                         m_vertices.size() * sizeof(PackedVertex),
+                         m_vertices.data());
+    glVertexArrayVertexBuffer(m_vao, 0, m_vbo, 0, sizeof(PackedVertex));
+  }
+  if (indexCount > m_indexCapacity) {
+    m_indexCapacity = std::max(indexCount, m_indexCapacity * 2);
+    glDeleteBuffers(1, &m_ebo);
+    glCreateBuffers(1, &m_ebo);
+    glNamedBufferData(m_ebo, m_indexCapacity * sizeof(uint32_t), nullptr,
+                      GL_STATIC_DRAW);
+    glNamedBufferSubData(m_ebo, 0, m_indices.size() * sizeof(uint32_t),
+                         m_indices.data());
+    glVertexArrayElementBuffer(m_vao, m_ebo);
+  }
+}
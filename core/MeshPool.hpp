@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Vector.hpp"
+#include <GL/glew.h>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// a position as IEEE halves, the fourth is padding that keeps every vertex
+// 4 byte aligned
+struct PackedVertex {
+  uint16_t position[4];
+};
+static_assert(sizeof(PackedVertex) == 8);
+
+// Location of a mesh inside the shared vertex/index buffers of a MeshPool.
+struct Mesh {
+  int32_t baseVertex;
+  uint32_t firstIndex;
+  uint32_t indexCount;
+  uint32_t vertexCount;
+};
+
+// Owns one vertex buffer, one index buffer and one vertex array for all
+// static geometry. Meshes are suballocated and drawn with base-vertex
+// offsets, identical meshes are stored once. Positions are stored as half
+// floats, exact for the ground grid and well below a pixel for the cursor.
+class MeshPool {
+public:
+  MeshPool(size_t vertexCapacity = 1 << 14, size_t indexCapacity = 1 << 16);
+  ~MeshPool();
+  MeshPool(const MeshPool &) = delete;
+  MeshPool &operator=(const MeshPool &) = delete;
+
+  Mesh add(std::span<const math137::Vector3f> vertices,
+           std::span<const uint32_t> indices);
+
+  void bind() const;
+  void draw(const Mesh &mesh, GLenum mode, GLsizei instanceCount = 1) const;
+
+  inline size_t getMeshCount() const { return m_meshes.size(); }
+  inline size_t getVertexCount() const { return m_vertices.size(); }
+  inline size_t getIndexCount() const { return m_indices.size(); }
+  inline size_t getVertexBytes() const { return m_vertices.size() * sizeof(PackedVertex); }
+
+private:
+  static uint64_t hash(std::span<const PackedVertex> vertices,
+                       std::span<const uint32_t> indices);
+  bool matches(const Mesh &mesh, std::span<const PackedVertex> vertices,
+               std::span<const uint32_t> indices) const;
+  void reserve(size_t vertexCount, size_t indexCount);
+
+  // CPU copies, used for deduplication and to refill grown buffers
+  std::vector<PackedVertex> m_vertices;
+  std::vector<uint32_t> m_indices;
+  std::vector<Mesh> m_meshes;
+  std::unordered_multimap<uint64_t, size_t> m_lookup;
+
+  size_t m_vertexCapacity;
+  size_t m_indexCapacity;
+  uint32_t m_vao;
+  uint32_t m_vbo;
+  uint32_t m_ebo;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free queue for any number of producer threads and one
+// consumer. Every slot carries a sequence number telling producers whether
+// it is free for their ticket and the consumer whether it holds a value.
+// Capacity must be a power of two.
+template <typename T, size_t Capacity> class MpscQueue {
+  static_assert((Capacity & (Capacity - 1)) == 0,
+                "capacity must be a power of two");
+
+public:
+  MpscQueue() {
+    for (size_t i = 0; i < Capacity; ++i)
+      m_slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  // returns false and drops the value when the queue is full
+  inline bool push(const T &value) {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    for (;;) {
+      Slot &slot = m_slots[head & (Capacity - 1)];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(head);
+      if (difference == 0) {
+        // the slot is free for this ticket, claim it
+        if (m_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+          slot.value = value;
+          slot.sequence.store(head + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        // the consumer has not freed it since the last lap
+        return false;
+      } else {
+        head = m_head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // consumer thread only
+  inline bool pop(T &value) {
+    Slot &slot = m_slots[m_tail & (Capacity - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != m_tail + 1)
+      return false;
+    value = slot.value;
+    slot.sequence.store(m_tail + Capacity, std::memory_order_release);
+    ++m_tail;
+    return true;
+  }
+
+private:
+  struct Slot {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  std::array<Slot, Capacity> m_slots;
+  alignas(64) std::atomic<size_t> m_head{0};
+  alignas(64) size_t m_tail{0};
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Conversions to the compact formats the GPU buffers use, each the inverse
+// of the GLSL unpack function or vertex fetch named next to it.
+namespace Packing {
+// IEEE binary16, round to nearest even, GL_HALF_FLOAT
+uint16_t toHalf(float value);
+float fromHalf(uint16_t half);
+
+// [-1, 1] to 16 bits, unpackSnorm2x16 and GL_SHORT normalized
+inline int16_t toSnorm16(float value) {
+  return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+inline float fromSnorm16(int16_t value) {
+  return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+}
+
+// [0, 1] per channel, first channel in the lowest byte, unpackUnorm4x8
+inline uint32_t toUnorm4x8(const float (&color)[4]) {
+  uint32_t packed = 0;
+  for (int i = 0; i < 4; ++i)
+    packed |= static_cast<uint32_t>(std::lround(std::clamp(color[i], 0.0f, 1.0f) * 255.0f))
+              << (8 * i);
+  return packed;
+}
+} // namespace Packing
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+// Seeded generators for the procedural rigs and the analysis samples. They
+// are counter based, so seeding from an item's index gives every item the
+// same numbers whichever thread or chunk produces it.
+namespace Random {
+// SplitMix64, Steele, Lea and Flood, "Fast Splittable Pseudorandom Number
+// Generators"
+inline uint64_t splitMix(uint64_t &state) {
+  uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+} // namespace Random
@@ -0,0 +1,165 @@
+#include "Recording.hpp"
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+enum RecordType : uint8_t { FRAME, INPUT, ACTION, PARAMETERS };
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+};
+
+constexpr char c_magic[8] = {'I', '1', '3', '7', 'R', 'E', 'C', '\0'};
+constexpr uint32_t c_version = 1;
+
+size_t payloadSize(uint8_t type) {
+  switch (type) {
+  case FRAME:
+    return sizeof(double);
+  case INPUT:
+    return sizeof(InputEvent);
+  case ACTION:
+    return sizeof(UiAction);
+  case PARAMETERS:
+    return sizeof(UiParameters);
+  }
+  throw std::runtime_error("Corrupt recording");
+}
+
+// the padded structs are written field by field into zeroed bytes, at the
+// offsets the replayer copies them back from, so no uninitialized padding
+// reaches the file
+template <typename T> using Payload = std::array<std::byte, sizeof(T)>;
+
+template <typename T, typename F>
+void pack(Payload<T> &out, size_t offset, const F &field) {
+  std::memcpy(out.data() + offset, &field, sizeof(field));
+}
+
+Payload<UiAction> packAction(const UiAction &action) {
+  Payload<UiAction> out{};
+  pack<UiAction>(out, offsetof(UiAction, type), action.type);
+  pack<UiAction>(out, offsetof(UiAction, id), action.id);
+  pack<UiAction>(out, offsetof(UiAction, value), action.value);
+  pack<UiAction>(out, offsetof(UiAction, amount), action.amount);
+  return out;
+}
+
+Payload<InputEvent> packInput(const InputEvent &event) {
+  Payload<InputEvent> out{};
+  pack<InputEvent>(out, offsetof(InputEvent, type), event.type);
+  pack<InputEvent>(out, offsetof(InputEvent, x), event.x);
+  pack<InputEvent>(out, offsetof(InputEvent, y), event.y);
+  pack<InputEvent>(out, offsetof(InputEvent, button), event.button);
+  pack<InputEvent>(out, offsetof(InputEvent, action), event.action);
+  pack<InputEvent>(out, offsetof(InputEvent, timestamp), event.timestamp);
+  return out;
+}
+} // namespace
+
+Recorder::Recorder(const std::string &path)
+    : m_file(path, std::ios::binary | std::ios::trunc) {
+  if (!m_file)
+    throw std::runtime_error("Failed to create recording " + path);
+  Header header{};
+  std::memcpy(header.magic, c_magic, sizeof(c_magic));
+  header.version = c_version;
+  m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+void Recorder::beginFrame(double time) { write(FRAME, time); }
+
+void Recorder::input(const InputEvent &event) { write(INPUT, packInput(event)); }
+
+void Recorder::action(const UiAction &action) { write(ACTION, packAction(action)); }
+
+void Recorder::parameters(const UiParameters &parameters) {
+  if (m_hasParameters &&
+      std::memcmp(&m_parameters, &parameters, sizeof(parameters)) == 0)
+    return;
+  m_parameters = parameters;
+  m_hasParameters = true;
+  write(PARAMETERS, parameters);
+}
+
+template <typename T> void Recorder::write(uint8_t type, const T &payload) {
+  // payloads with padding go through packAction and packInput first
+  static_assert(std::is_trivially_copyable_v<T>);
+  m_file.put(static_cast<char>(type));
+  m_file.write(reinterpret_cast<const char *>(&payload), sizeof(payload));
+}
+
+Replayer::Replayer(const std::string &path) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file)
+    throw std::runtime_error("Failed to open recording " + path);
+  m_data.resize(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(reinterpret_cast<char *>(m_data.data()), m_data.size());
+
+  Header header;
+  if (m_data.size() < sizeof(header))
+    throw std::runtime_error("Not a recording " + path);
+  std::memcpy(&header, m_data.data(), sizeof(header));
+  if (std::memcmp(header.magic, c_magic, sizeof(c_magic)) != 0)
+    throw std::runtime_error("Not a recording " + path);
+  if (header.version != c_version)
+    throw std::runtime_error("Unsupported recording version " +
+                             std::to_string(header.version));
+
+  // check every record up front so replay never stops halfway
+  for (size_t offset = sizeof(header); offset < m_data.size();) {
+    uint8_t type = static_cast<uint8_t>(m_data[offset]);
+    size_t size = payloadSize(type);
+    if (m_data.size() - offset - 1 < size)
+      throw std::runtime_error("Truncated recording " + path);
+    if (type == FRAME)
+      ++m_frameCount;
+    offset += 1 + size;
+  }
+  m_offset = sizeof(header);
+}
+
+bool Replayer::next(ReplayFrame &frame) {
+  // records before the first frame cannot be placed, skip them
+  while (m_offset < m_data.size() &&
+         static_cast<uint8_t>(m_data[m_offset]) != FRAME)
+    m_offset += 1 + payloadSize(static_cast<uint8_t>(m_data[m_offset]));
+  if (m_offset >= m_data.size())
+    return false;
+
+  ++m_offset;
+  frame.time = read<double>();
+  frame.inputs.clear();
+  frame.actions.clear();
+  frame.parameters.reset();
+  while (m_offset < m_data.size()) {
+    uint8_t type = static_cast<uint8_t>(m_data[m_offset]);
+    if (type == FRAME)
+      break;
+    ++m_offset;
+    switch (type) {
+    case INPUT:
+      frame.inputs.push_back(read<InputEvent>());
+      break;
+    case ACTION:
+      frame.actions.push_back(read<UiAction>());
+      break;
+    case PARAMETERS:
+      frame.parameters = read<UiParameters>();
+      break;
+    }
+  }
+  return true;
+}
+
+template <typename T> T Replayer::read() {
+  T value;
+  std::memcpy(&value, m_data.data() + m_offset, sizeof(value));
+  m_offset += sizeof(value);
+  return value;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "InputQueue.hpp"
+#include "Scene.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Command line switches for record and replay runs.
+struct RecordingOptions {
+  std::string recordPath;
+  std::string replayPath;
+  // per frame wall time and a hash of the drawn poses, as CSV
+  std::string frameLogPath;
+  // fail the run when a frame past the warmup allocated, needs a
+  // COUNT_ALLOCATIONS build
+  bool expectZeroAllocations{false};
+};
+
+// Fields of the Info window that are only read when Start is pressed.
+struct UiParameters {
+  float startPos[3]{0.0f, 0.0f, 0.0f};
+  float startEuler[3]{0.0f, 0.0f, 0.0f};
+  float startQuat[4]{1.0f, 0.0f, 0.0f, 0.0f};
+  float endPos[3]{0.0f, 0.0f, 0.0f};
+  float endEuler[3]{0.0f, 0.0f, 0.0f};
+  float endQuat[4]{1.0f, 0.0f, 0.0f, 0.0f};
+  float duration{5.0f};
+  int newMethod{static_cast<int>(InterpolationMethod::SPHERICAL)};
+};
+
+enum class UiActionType : uint8_t {
+  START,
+  ADD_PANEL,
+  REMOVE_PANEL,
+  SET_METHOD,
+  GHOST_FRAMES,
+  LOD_MODE,
+  CULLING,
+  TICK_RATE,
+  PRESENT_MODE,
+  TARGET_RATE,
+  LATE_SAMPLING,
+  DYNAMIC_RESOLUTION,
+  GPU_BUDGET,
+  SEEK,
+  GHOST_SPACING,
+  CONSTANT_SPEED,
+  ARC_LENGTH_BUDGET,
+  SKELETON,
+  TRAIL,
+  TRAIL_RIBBON
+};
+
+// Everything the UI changes outside of UiParameters goes through one of these.
+struct UiAction {
+  UiActionType type;
+  // panel id
+  uint32_t id;
+  // method, mode, count or flag
+  int32_t value;
+  // rates, budgets and times
+  float amount;
+};
+
+struct ReplayFrame {
+  double time;
+  std::vector<InputEvent> inputs;
+  std::vector<UiAction> actions;
+  // recorded alongside the Start action that consumed them
+  std::optional<UiParameters> parameters;
+};
+
+// Log layout: a header, then records of a type byte followed by a fixed size
+// payload. A frame record opens every frame, the inputs, parameters and
+// actions after it belong to that frame.
+class Recorder {
+public:
+  explicit Recorder(const std::string &path);
+
+  void beginFrame(double time);
+  void input(const InputEvent &event);
+  void action(const UiAction &action);
+  // skipped when unchanged since the last call
+  void parameters(const UiParameters &parameters);
+
+private:
+  template <typename T> void write(uint8_t type, const T &payload);
+
+  std::ofstream m_file;
+  UiParameters m_parameters;
+  bool m_hasParameters{false};
+};
+
+class Replayer {
+public:
+  explicit Replayer(const std::string &path);
+
+  // false once every recorded frame was returned
+  bool next(ReplayFrame &frame);
+  inline size_t getFrameCount() const { return m_frameCount; }
+
+private:
+  template <typename T> T read();
+
+  std::vector<std::byte> m_data;
+  size_t m_offset{0};
+  size_t m_frameCount{0};
+};
@@ -1,24 +1,94 @@
 #include "Renderer.hpp"
 #include "Matrix.hpp"
+#include "MatrixUtils.hpp"
 #include "Shader.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <cstdint>
 
-Renderer::Renderer()
-    : m_objectShader("shaders/base.vs", "shaders/base.fs"){
+Renderer::Sources Renderer::readSources() {
+  return {ShaderSource::read("shaders/base.vs", "shaders/base.fs"),
+          ShaderSource::read("shaders/instanced.vs", "shaders/instanced.fs"),
+          ShaderSource::readCompute("shaders/select.comp"),
+          ShaderSource::read("shaders/trail.vs", "shaders/instanced.fs")};
+}
+
+Renderer::Renderer() : Renderer(readSources()) {}
+
+Renderer::Renderer(const Sources &sources)
+    : m_objectShader(sources.object), m_instancedShader(sources.instanced),
+      m_selectShader(sources.select), m_trailShader(sources.trail),
+      m_viewportCount(1) {
   m_selectedShader = &m_objectShader;
   m_type = ShaderType::OBJECT;
   m_selectedShader->use();
+
+  // writing gl_ViewportIndex from the vertex stage lets one instanced draw
+  // reach every viewport, otherwise the caller renders one pass per viewport
+  m_multiViewport =
+      GLEW_ARB_viewport_array && GLEW_ARB_shader_viewport_layer_array;
+  GLint maxViewports = 1;
+  if (m_multiViewport)
+    glGetIntegerv(GL_MAX_VIEWPORTS, &maxViewports);
+  m_maxViewports = std::clamp(maxViewports, 1, c_maxViewports);
+  setViewportIndex(0);
+}
+
+void Renderer::tileViewports(size_t count, int width, int height,
+                             std::vector<Viewport> &viewports) {
+  viewports.clear();
+  if (count == 0)
+    return;
+
+  int cols = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+  int rows = static_cast<int>((count + cols - 1) / cols);
+  float cellW = (float)width / cols;
+  float cellH = (float)height / rows;
+  auto projection =
+      math137::MatrixUtils::Projection(M_PI_4, cellW / cellH, 0.1f, 100.f);
+  for (size_t i = 0; i < count; ++i) {
+    int col = static_cast<int>(i) % cols;
+    int row = static_cast<int>(i) / cols;
+    viewports.push_back(
+        {col * cellW, (rows - 1 - row) * cellH, cellW, cellH, projection});
+  }
 }
 
-void Renderer::setProjection(const math137::Matrix4f &projection) {
+void Renderer::setViewports(std::span<const Viewport> viewports) {
+  m_viewportCount =
+      std::min(static_cast<int>(viewports.size()), m_maxViewports);
+  std::array<float, 16 * c_maxViewports> projections;
+  for (int i = 0; i < m_viewportCount; ++i) {
+    const Viewport &vp = viewports[i];
+    m_viewports[i] = vp;
+    if (m_multiViewport)
+      glViewportIndexedf(i, vp.x, vp.y, vp.width, vp.height);
+    else
+      glViewport(vp.x, vp.y, vp.width, vp.height);
+    std::copy_n(vp.projection.data(), 16, projections.data() + 16 * i);
+  }
+
+  for (Shader *shader : {&m_objectShader, &m_instancedShader, &m_trailShader}) {
+    shader->use();
+    shader->setMat4Array("projection", projections.data(), m_viewportCount);
+  }
+  m_objectShader.setInt("viewportCount", m_viewportCount);
+  m_selectedShader->use();
+}
+
+void Renderer::setViewportIndex(int index) {
   m_objectShader.use();
-  m_objectShader.setMat4("projection", projection);
+  m_objectShader.setInt("viewportIndex", index);
   m_selectedShader->use();
 }
 
 void Renderer::setView(const math137::Matrix4f &view) {
-  m_objectShader.use();
-  m_objectShader.setMat4("view", view);
+  m_view = view;
+  for (Shader *shader : {&m_objectShader, &m_instancedShader, &m_trailShader}) {
+    shader->use();
+    shader->setMat4("view", view);
+  }
   m_selectedShader->use();
 }
 
@@ -30,6 +100,15 @@ void Renderer::setShader(const ShaderType type) {
   case ShaderType::OBJECT:
     m_selectedShader = &m_objectShader;
     break;
+  case ShaderType::INSTANCED:
+    m_selectedShader = &m_instancedShader;
+    break;
+  case ShaderType::SELECT:
+    m_selectedShader = &m_selectShader;
+    break;
+  case ShaderType::TRAIL:
+    m_selectedShader = &m_trailShader;
+    break;
   }
   m_selectedShader->use();
 }
@@ -47,6 +126,7 @@ void Renderer::setModel(const math137::Matrix4f &model) {
 }
 
 void Renderer::setCamerPos(const math137::Vector3f &pos) {
+  m_cameraPos = pos;
   m_objectShader.use();
   m_objectShader.setVec3("cameraPos", pos);
   m_selectedShader->use();
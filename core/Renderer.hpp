@@ -2,14 +2,40 @@
 
 #include "Shader.hpp"
 #include "Vector.hpp"
+#include <array>
 #include <cstdint>
+#include <span>
+#include <vector>
 
 class Object;
 
+struct Viewport {
+  float x, y, width, height;
+  math137::Matrix4f projection;
+};
+
 class Renderer {
 public:
+  // matches MAX_VIEWPORTS in base.vs, also the minimum GL_MAX_VIEWPORTS
+  static constexpr int c_maxViewports = 16;
+
+  // every shader's code, readable off the context thread
+  struct Sources {
+    ShaderSource object;
+    ShaderSource instanced;
+    ShaderSource select;
+    ShaderSource trail;
+  };
+  static Sources readSources();
+
+  // reads the sources on the calling thread
   Renderer();
-  void setProjection(const math137::Matrix4f &projection);
+  explicit Renderer(const Sources &sources);
+  // near-square grid of count cells over the framebuffer, first row on top
+  static void tileViewports(size_t count, int width, int height,
+                            std::vector<Viewport> &viewports);
+  void setViewports(std::span<const Viewport> viewports);
+  void setViewportIndex(int index);
   void setView(const math137::Matrix4f &view);
   void setModel(const math137::Matrix4f &model);
   void setShader(const ShaderType type);
@@ -18,8 +44,28 @@ public:
   void setBlockData(float sizeX, float sizeY, float sizeZ);
   void setCamerPos(const math137::Vector3f &pos);
 
+  // true when every viewport can be rasterized in a single pass
+  inline bool isMultiViewport() const { return m_multiViewport; }
+  inline int getMaxViewports() const { return m_maxViewports; }
+  inline int getViewportCount() const { return m_viewportCount; }
+  inline const Viewport &getViewport(int index) const {
+    return m_viewports[index];
+  }
+  inline math137::Vector3f getCameraPosition() const { return m_cameraPos; }
+  inline const math137::Matrix4f &getView() const { return m_view; }
+  inline const Shader &getShader() const { return *m_selectedShader; }
+
 private:
   Shader *m_selectedShader;
   Shader m_objectShader;
+  Shader m_instancedShader;
+  Shader m_selectShader;
+  Shader m_trailShader;
   ShaderType m_type;
+  bool m_multiViewport;
+  int m_maxViewports;
+  int m_viewportCount;
+  std::array<Viewport, c_maxViewports> m_viewports;
+  math137::Vector3f m_cameraPos;
+  math137::Matrix4f m_view;
 };
@@ -0,0 +1,610 @@
+#include "Rotation.hpp"
+#include "Simd.hpp"
+#include <MatrixUtils.hpp>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+// Shoemake, "Euler Angle Conversion", Graphics Gems IV: the first axis i,
+// the following axes j and k, whether i j k is an odd permutation of x y z
+// and whether the first axis repeats
+struct Axes {
+  int i, j, k;
+  bool odd, repeat;
+};
+
+constexpr Axes c_axes[Rotation::c_orderCount] = {
+    {0, 1, 2, false, false}, // XYZ
+    {0, 2, 1, true, false},  // XZY
+    {1, 0, 2, true, false},  // YXZ
+    {1, 2, 0, false, false}, // YZX
+    {2, 0, 1, false, false}, // ZXY
+    {2, 1, 0, true, false},  // ZYX
+    {0, 1, 2, false, true},  // XYX
+    {0, 2, 1, true, true},   // XZX
+    {1, 0, 2, true, true},   // YXY
+    {1, 2, 0, false, true},  // YZY
+    {2, 0, 1, false, true},  // ZXZ
+    {2, 1, 0, true, true},   // ZYZ
+};
+
+// below this the middle axis is at gimbal lock and the first angle takes
+// the whole turn
+constexpr float c_gimbalEpsilon = 16.0f * 1.1920929e-7f;
+
+const Axes &axesOf(EulerOrder order) {
+  return c_axes[static_cast<int>(order)];
+}
+
+// the kernels are written once against these and run on plain floats or on
+// four lanes at a time
+inline void sinCos(float x, float &s, float &c) {
+  s = sinf(x);
+  c = cosf(x);
+}
+inline float arcTan2(float y, float x) { return atan2f(y, x); }
+inline float squareRoot(float x) { return sqrtf(x); }
+inline bool greater(float a, float b) { return a > b; }
+inline float select(bool mask, float a, float b) { return mask ? a : b; }
+inline float remainderTurn(float x, float turn) { return fmodf(x, turn); }
+
+#if SIMD_SSE
+struct Lanes {
+  __m128 v;
+  Lanes() = default;
+  Lanes(__m128 value) : v(value) {}
+  Lanes(float value) : v(_mm_set1_ps(value)) {}
+};
+struct LaneMask {
+  __m128 v;
+};
+
+inline Lanes operator+(Lanes a, Lanes b) { return _mm_add_ps(a.v, b.v); }
+inline Lanes operator-(Lanes a, Lanes b) { return _mm_sub_ps(a.v, b.v); }
+inline Lanes operator*(Lanes a, Lanes b) { return _mm_mul_ps(a.v, b.v); }
+inline Lanes operator/(Lanes a, Lanes b) { return _mm_div_ps(a.v, b.v); }
+inline Lanes operator-(Lanes a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); }
+inline Lanes squareRoot(Lanes x) { return _mm_sqrt_ps(x.v); }
+inline LaneMask greater(Lanes a, Lanes b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+inline Lanes select(LaneMask mask, Lanes a, Lanes b) {
+  return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+}
+// fmodf with a truncated quotient, exact like it while x lies within two
+// turns, where both operands of the subtraction are within a factor of two
+inline Lanes remainderTurn(Lanes x, float turn) {
+  __m128 quotient = _mm_cvtepi32_ps(_mm_cvttps_epi32(_mm_mul_ps(x.v, _mm_set1_ps(1.0f / turn))));
+  return _mm_sub_ps(x.v, _mm_mul_ps(quotient, _mm_set1_ps(turn)));
+}
+
+// Cephes sinf/cosf: reduce by pi/4 into octants, evaluate both minimax
+// polynomials and pick per lane
+void sinCos(Lanes x, Lanes &s, Lanes &c) {
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  __m128 sinSign = _mm_and_ps(x.v, signMask);
+  __m128 ax = _mm_andnot_ps(signMask, x.v);
+
+  __m128i octant = _mm_cvttps_epi32(_mm_mul_ps(ax, _mm_set1_ps(1.27323954473516f)));
+  // round odd octants up so the remainder lies in [-pi/4, pi/4]
+  octant = _mm_add_epi32(octant, _mm_set1_epi32(1));
+  octant = _mm_and_si128(octant, _mm_set1_epi32(~1));
+  __m128 y = _mm_cvtepi32_ps(octant);
+
+  __m128i sinFlip = _mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29);
+  __m128i cosFlip = _mm_slli_epi32(
+      _mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29);
+  __m128 usePoly2 = _mm_castsi128_ps(
+      _mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_setzero_si128()));
+
+  // extended precision modular arithmetic
+  ax = _mm_add_ps(ax, _mm_mul_ps(y, _mm_set1_ps(-0.78515625f)));
+  ax = _mm_add_ps(ax, _mm_mul_ps(y, _mm_set1_ps(-2.4187564849853515625e-4f)));
+  ax = _mm_add_ps(ax, _mm_mul_ps(y, _mm_set1_ps(-3.77489497744594108e-8f)));
+  __m128 z = _mm_mul_ps(ax, ax);
+
+  __m128 cosPoly = _mm_set1_ps(2.443315711809948e-5f);
+  cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(-1.388731625493765e-3f));
+  cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(4.166664568298827e-2f));
+  cosPoly = _mm_mul_ps(_mm_mul_ps(cosPoly, z), z);
+  cosPoly = _mm_sub_ps(cosPoly, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+  cosPoly = _mm_add_ps(cosPoly, _mm_set1_ps(1.0f));
+
+  __m128 sinPoly = _mm_set1_ps(-1.9515295891e-4f);
+  sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(8.3321608736e-3f));
+  sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(-1.6666654611e-1f));
+  sinPoly = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPoly, z), ax), ax);
+
+  __m128 sinValue = _mm_or_ps(_mm_and_ps(usePoly2, sinPoly), _mm_andnot_ps(usePoly2, cosPoly));
+  __m128 cosValue = _mm_or_ps(_mm_and_ps(usePoly2, cosPoly), _mm_andnot_ps(usePoly2, sinPoly));
+  sinSign = _mm_xor_ps(sinSign, _mm_castsi128_ps(sinFlip));
+  s = _mm_xor_ps(sinValue, sinSign);
+  c = _mm_xor_ps(cosValue, _mm_castsi128_ps(cosFlip));
+}
+
+// Cephes atanf on min/max of |y| and |x|, then folded back into the quadrant
+Lanes arcTan2(Lanes y, Lanes x) {
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  __m128 ay = _mm_andnot_ps(signMask, y.v);
+  __m128 ax = _mm_andnot_ps(signMask, x.v);
+  __m128 swap = _mm_cmpgt_ps(ay, ax);
+  __m128 num = _mm_min_ps(ay, ax);
+  __m128 den = _mm_max_ps(ay, ax);
+  // atan2(0, 0) is 0 like atan2f
+  __m128 zero = _mm_cmpeq_ps(den, _mm_setzero_ps());
+  __m128 t = _mm_andnot_ps(zero, _mm_div_ps(num, _mm_or_ps(den, _mm_and_ps(zero, _mm_set1_ps(1.0f)))));
+
+  // above tan(pi/8) use atan(t) = pi/4 + atan((t - 1) / (t + 1))
+  __m128 large = _mm_cmpgt_ps(t, _mm_set1_ps(0.4142135623730950f));
+  __m128 reduced = _mm_div_ps(_mm_sub_ps(t, _mm_set1_ps(1.0f)), _mm_add_ps(t, _mm_set1_ps(1.0f)));
+  t = _mm_or_ps(_mm_and_ps(large, reduced), _mm_andnot_ps(large, t));
+  __m128 offset = _mm_and_ps(large, _mm_set1_ps(0.7853981633974483f));
+
+  __m128 z = _mm_mul_ps(t, t);
+  __m128 poly = _mm_set1_ps(8.05374449538e-2f);
+  poly = _mm_add_ps(_mm_mul_ps(poly, z), _mm_set1_ps(-1.38776856032e-1f));
+  poly = _mm_add_ps(_mm_mul_ps(poly, z), _mm_set1_ps(1.99777106478e-1f));
+  poly = _mm_add_ps(_mm_mul_ps(poly, z), _mm_set1_ps(-3.33329491539e-1f));
+  __m128 angle = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(poly, z), t), t), offset);
+
+  // |y| > |x| means the angle was measured from the y axis
+  __m128 fromY = _mm_sub_ps(_mm_set1_ps(1.5707963267948966f), angle);
+  angle = _mm_or_ps(_mm_and_ps(swap, fromY), _mm_andnot_ps(swap, angle));
+  __m128 negativeX = _mm_cmplt_ps(x.v, _mm_setzero_ps());
+  __m128 mirrored = _mm_sub_ps(_mm_set1_ps(3.14159265358979f), angle);
+  angle = _mm_or_ps(_mm_and_ps(negativeX, mirrored), _mm_andnot_ps(negativeX, angle));
+  return _mm_or_ps(angle, _mm_and_ps(y.v, signMask));
+}
+#endif
+
+template <typename F>
+void eulerToQuaternionKernel(const F (&angles)[3], const Axes &axes, F (&q)[4]) {
+  F ti = angles[0] * F(0.5f);
+  F tj = angles[1] * F(0.5f);
+  F th = angles[2] * F(0.5f);
+  if (axes.odd)
+    tj = -tj;
+  F si, ci, sj, cj, sh, ch;
+  sinCos(ti, si, ci);
+  sinCos(tj, sj, cj);
+  sinCos(th, sh, ch);
+  F cc = ci * ch, cs = ci * sh, sc = si * ch, ss = si * sh;
+  F v[3];
+  if (axes.repeat) {
+    v[axes.i] = cj * (cs + sc);
+    v[axes.j] = sj * (cc + ss);
+    v[axes.k] = sj * (cs - sc);
+    q[0] = cj * (cc - ss);
+  } else {
+    v[axes.i] = cj * sc - sj * cs;
+    v[axes.j] = cj * ss + sj * cc;
+    v[axes.k] = cj * cs - sj * sc;
+    q[0] = cj * cc + sj * ss;
+  }
+  if (axes.odd)
+    v[axes.j] = -v[axes.j];
+  q[1] = v[0];
+  q[2] = v[1];
+  q[3] = v[2];
+}
+
+template <typename F>
+void eulerToMatrixKernel(const F (&angles)[3], const Axes &axes, F (&m)[3][3]) {
+  F ti = angles[0], tj = angles[1], th = angles[2];
+  if (axes.odd) {
+    ti = -ti;
+    tj = -tj;
+    th = -th;
+  }
+  F si, ci, sj, cj, sh, ch;
+  sinCos(ti, si, ci);
+  sinCos(tj, sj, cj);
+  sinCos(th, sh, ch);
+  F cc = ci * ch, cs = ci * sh, sc = si * ch, ss = si * sh;
+  const int i = axes.i, j = axes.j, k = axes.k;
+  if (axes.repeat) {
+    m[i][i] = cj;
+    m[i][j] = sj * si;
+    m[i][k] = sj * ci;
+    m[j][i] = sj * sh;
+    m[j][j] = cc - cj * ss;
+    m[j][k] = -(cj * cs) - sc;
+    m[k][i] = -(sj * ch);
+    m[k][j] = cj * sc + cs;
+    m[k][k] = cj * cc - ss;
+  } else {
+    m[i][i] = cj * ch;
+    m[i][j] = sj * sc - cs;
+    m[i][k] = sj * cc + ss;
+    m[j][i] = cj * sh;
+    m[j][j] = sj * ss + cc;
+    m[j][k] = sj * cs - sc;
+    m[k][i] = -sj;
+    m[k][j] = cj * si;
+    m[k][k] = cj * ci;
+  }
+}
+
+template <typename F>
+void matrixToEulerKernel(const F (&m)[3][3], const Axes &axes, F (&angles)[3]) {
+  const int i = axes.i, j = axes.j, k = axes.k;
+  F x, y, z;
+  if (axes.repeat) {
+    F sy = squareRoot(m[i][j] * m[i][j] + m[i][k] * m[i][k]);
+    auto regular = greater(sy, F(c_gimbalEpsilon));
+    x = select(regular, arcTan2(m[i][j], m[i][k]), arcTan2(-m[j][k], m[j][j]));
+    y = arcTan2(sy, m[i][i]);
+    z = select(regular, arcTan2(m[j][i], -m[k][i]), F(0.0f));
+  } else {
+    F cy = squareRoot(m[i][i] * m[i][i] + m[j][i] * m[j][i]);
+    auto regular = greater(cy, F(c_gimbalEpsilon));
+    x = select(regular, arcTan2(m[k][j], m[k][k]), arcTan2(-m[j][k], m[j][j]));
+    y = arcTan2(-m[k][i], cy);
+    z = select(regular, arcTan2(m[j][i], m[i][i]), F(0.0f));
+  }
+  if (axes.odd) {
+    x = -x;
+    y = -y;
+    z = -z;
+  }
+  angles[0] = x;
+  angles[1] = y;
+  angles[2] = z;
+}
+
+// scaled by 2 / |q|^2 so unnormalized input still gives a rotation
+template <typename F>
+void quaternionToMatrixKernel(const F (&q)[4], F (&m)[3][3]) {
+  F w = q[0], x = q[1], y = q[2], z = q[3];
+  F s = F(2.0f) / (w * w + x * x + y * y + z * z);
+  F xs = x * s, ys = y * s, zs = z * s;
+  F wx = w * xs, wy = w * ys, wz = w * zs;
+  F xx = x * xs, xy = x * ys, xz = x * zs;
+  F yy = y * ys, yz = y * zs, zz = z * zs;
+  m[0][0] = F(1.0f) - (yy + zz);
+  m[0][1] = xy - wz;
+  m[0][2] = xz + wy;
+  m[1][0] = xy + wz;
+  m[1][1] = F(1.0f) - (xx + zz);
+  m[1][2] = yz - wx;
+  m[2][0] = xz - wy;
+  m[2][1] = yz + wx;
+  m[2][2] = F(1.0f) - (xx + yy);
+}
+
+template <typename F> void normalizeKernel(F (&q)[4]) {
+  F length = squareRoot(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+  F scale = select(greater(length, F(0.0f)), F(1.0f) / length, F(0.0f));
+  for (F &v : q)
+    v = v * scale;
+}
+
+// to, negated when that is the shorter way round from from, and the dot
+// product of the two afterwards
+template <typename F> F alignKernel(const F (&from)[4], const F (&to)[4], F (&aligned)[4]) {
+  F dot = from[0] * to[0] + from[1] * to[1] + from[2] * to[2] + from[3] * to[3];
+  F sign = select(greater(F(0.0f), dot), F(-1.0f), F(1.0f));
+  for (int i = 0; i < 4; ++i)
+    aligned[i] = to[i] * sign;
+  return dot * sign;
+}
+
+template <typename F>
+void nlerpKernel(const F (&from)[4], const F (&to)[4], F alpha, F (&q)[4]) {
+  F aligned[4];
+  alignKernel(from, to, aligned);
+  F beta = F(1.0f) - alpha;
+  for (int i = 0; i < 4; ++i)
+    q[i] = from[i] * beta + aligned[i] * alpha;
+  normalizeKernel(q);
+}
+
+template <typename F>
+void slerpKernel(const F (&from)[4], const F (&to)[4], F alpha, F (&q)[4]) {
+  F aligned[4], across[4];
+  F dot = alignKernel(from, to, aligned);
+  // rotate from towards the part of to orthogonal to it
+  F length = F(0.0f);
+  for (int i = 0; i < 4; ++i) {
+    across[i] = aligned[i] - from[i] * dot;
+    length = length + across[i] * across[i];
+  }
+  length = squareRoot(length);
+  F s, c;
+  sinCos(arcTan2(length, dot) * alpha, s, c);
+  // the same orientation up to rounding, there is no direction to turn in
+  auto turns = greater(length, F(1e-6f));
+  s = select(turns, s / length, F(0.0f));
+  F linear[4];
+  nlerpKernel(from, to, alpha, linear);
+  for (int i = 0; i < 4; ++i)
+    q[i] = select(turns, from[i] * c + across[i] * s, linear[i]);
+  normalizeKernel(q);
+}
+
+// every angle turns to the nearest equivalent of its target, the delta
+// wrapped into [-pi, pi), so a half turn either way goes the negative way
+template <typename F>
+void eulerLerpKernel(const F (&from)[3], const F (&to)[3], F alpha, F (&angles)[3]) {
+  const float pi = static_cast<float>(M_PI);
+  for (int i = 0; i < 3; ++i) {
+    F delta = remainderTurn(to[i] - from[i] + F(pi), 2.0f * pi);
+    delta = select(greater(F(0.0f), delta), delta + F(2.0f * pi), delta) - F(pi);
+    angles[i] = from[i] + delta * alpha;
+  }
+}
+
+template <typename F>
+void storeMatrix(const F (&m)[3][3], F (&out)[16]) {
+  for (int r = 0; r < 3; ++r) {
+    for (int c = 0; c < 3; ++c)
+      out[r * 4 + c] = m[r][c];
+    out[r * 4 + 3] = F(0.0f);
+    out[12 + r] = F(0.0f);
+  }
+  out[15] = F(1.0f);
+}
+
+// Shepperd: take the root of the largest diagonal term to stay away from
+// cancellation. The branch differs per rotation, so this one has no lanes.
+void matrixToQuaternionKernel(const float *m, float (&q)[4]) {
+  auto e = [m](int r, int c) { return m[r * 4 + c]; };
+  float trace = e(0, 0) + e(1, 1) + e(2, 2);
+  if (trace > 0.0f) {
+    float s = 2.0f * sqrtf(trace + 1.0f);
+    q[0] = 0.25f * s;
+    q[1] = (e(2, 1) - e(1, 2)) / s;
+    q[2] = (e(0, 2) - e(2, 0)) / s;
+    q[3] = (e(1, 0) - e(0, 1)) / s;
+  } else if (e(0, 0) > e(1, 1) && e(0, 0) > e(2, 2)) {
+    float s = 2.0f * sqrtf(1.0f + e(0, 0) - e(1, 1) - e(2, 2));
+    q[0] = (e(2, 1) - e(1, 2)) / s;
+    q[1] = 0.25f * s;
+    q[2] = (e(0, 1) + e(1, 0)) / s;
+    q[3] = (e(0, 2) + e(2, 0)) / s;
+  } else if (e(1, 1) > e(2, 2)) {
+    float s = 2.0f * sqrtf(1.0f + e(1, 1) - e(0, 0) - e(2, 2));
+    q[0] = (e(0, 2) - e(2, 0)) / s;
+    q[1] = (e(0, 1) + e(1, 0)) / s;
+    q[2] = 0.25f * s;
+    q[3] = (e(1, 2) + e(2, 1)) / s;
+  } else {
+    float s = 2.0f * sqrtf(1.0f + e(2, 2) - e(0, 0) - e(1, 1));
+    q[0] = (e(1, 0) - e(0, 1)) / s;
+    q[1] = (e(0, 2) + e(2, 0)) / s;
+    q[2] = (e(1, 2) + e(2, 1)) / s;
+    q[3] = 0.25f * s;
+  }
+}
+
+// runs kernel over packed rotations, four at a time when SSE is available.
+// The tail block repeats the last rotation so every lane holds valid input.
+template <size_t In, size_t Out, typename Kernel>
+void runBatch(std::span<const float> in, std::span<float> out, Kernel kernel) {
+  if (in.size() % In != 0 || out.size() < in.size() / In * Out)
+    throw std::invalid_argument("Rotation batch sizes do not match");
+  size_t count = in.size() / In;
+#if SIMD_SSE
+  for (size_t first = 0; first < count; first += 4) {
+    alignas(16) float lanesIn[In][4];
+    alignas(16) float lanesOut[Out][4];
+    size_t lanes = std::min<size_t>(4, count - first);
+    for (size_t l = 0; l < 4; ++l) {
+      const float *src = &in[(first + std::min(l, lanes - 1)) * In];
+      for (size_t c = 0; c < In; ++c)
+        lanesIn[c][l] = src[c];
+    }
+    Lanes a[In], b[Out];
+    for (size_t c = 0; c < In; ++c)
+      a[c] = _mm_load_ps(lanesIn[c]);
+    kernel(a, b);
+    for (size_t c = 0; c < Out; ++c)
+      _mm_store_ps(lanesOut[c], b[c].v);
+    for (size_t l = 0; l < lanes; ++l) {
+      float *dst = &out[(first + l) * Out];
+      for (size_t c = 0; c < Out; ++c)
+        dst[c] = lanesOut[c][l];
+    }
+  }
+#else
+  for (size_t r = 0; r < count; ++r) {
+    float a[In], b[Out];
+    for (size_t c = 0; c < In; ++c)
+      a[c] = in[r * In + c];
+    kernel(a, b);
+    for (size_t c = 0; c < Out; ++c)
+      out[r * Out + c] = b[c];
+  }
+#endif
+}
+
+// runBatch for kernels that combine two packed inputs of the same layout
+template <size_t In, size_t Out, typename Kernel>
+void runPairBatch(std::span<const float> from, std::span<const float> to, std::span<float> out,
+                  Kernel kernel) {
+  if (from.size() % In != 0 || to.size() != from.size() || out.size() < from.size() / In * Out)
+    throw std::invalid_argument("Rotation batch sizes do not match");
+  size_t count = from.size() / In;
+#if SIMD_SSE
+  for (size_t first = 0; first < count; first += 4) {
+    alignas(16) float lanesFrom[In][4];
+    alignas(16) float lanesTo[In][4];
+    alignas(16) float lanesOut[Out][4];
+    size_t lanes = std::min<size_t>(4, count - first);
+    for (size_t l = 0; l < 4; ++l) {
+      size_t r = first + std::min(l, lanes - 1);
+      for (size_t c = 0; c < In; ++c) {
+        lanesFrom[c][l] = from[r * In + c];
+        lanesTo[c][l] = to[r * In + c];
+      }
+    }
+    Lanes a[In], b[In], result[Out];
+    for (size_t c = 0; c < In; ++c) {
+      a[c] = _mm_load_ps(lanesFrom[c]);
+      b[c] = _mm_load_ps(lanesTo[c]);
+    }
+    kernel(a, b, result);
+    for (size_t c = 0; c < Out; ++c)
+      _mm_store_ps(lanesOut[c], result[c].v);
+    for (size_t l = 0; l < lanes; ++l)
+      for (size_t c = 0; c < Out; ++c)
+        out[(first + l) * Out + c] = lanesOut[c][l];
+  }
+#else
+  for (size_t r = 0; r < count; ++r) {
+    float a[In], b[In], result[Out];
+    for (size_t c = 0; c < In; ++c) {
+      a[c] = from[r * In + c];
+      b[c] = to[r * In + c];
+    }
+    kernel(a, b, result);
+    for (size_t c = 0; c < Out; ++c)
+      out[r * Out + c] = result[c];
+  }
+#endif
+}
+
+math137::Matrix4f toMatrix(const float (&m)[3][3]) {
+  math137::Matrix4f result = math137::MatrixUtils::Identity();
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 3; ++c)
+      result.setValue(r, c, m[r][c]);
+  return result;
+}
+
+} // namespace
+
+namespace Rotation {
+math137::Quaternion eulerToQuaternion(const math137::Vector3f &angles, EulerOrder order) {
+  const float in[3] = {angles.x(), angles.y(), angles.z()};
+  float q[4];
+  eulerToQuaternionKernel(in, axesOf(order), q);
+  return math137::Quaternion{q[0], q[1], q[2], q[3]};
+}
+
+math137::Matrix4f eulerToMatrix(const math137::Vector3f &angles, EulerOrder order) {
+  const float in[3] = {angles.x(), angles.y(), angles.z()};
+  float m[3][3];
+  eulerToMatrixKernel(in, axesOf(order), m);
+  return toMatrix(m);
+}
+
+math137::Vector3f quaternionToEuler(const math137::Quaternion &q, EulerOrder order) {
+  const float in[4] = {q.a, q.b, q.c, q.d};
+  float m[3][3], angles[3];
+  quaternionToMatrixKernel(in, m);
+  matrixToEulerKernel(m, axesOf(order), angles);
+  return {angles[0], angles[1], angles[2]};
+}
+
+math137::Vector3f matrixToEuler(const math137::Matrix4f &m, EulerOrder order) {
+  float in[3][3], angles[3];
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 3; ++c)
+      in[r][c] = m.getValue(r, c);
+  matrixToEulerKernel(in, axesOf(order), angles);
+  return {angles[0], angles[1], angles[2]};
+}
+
+math137::Matrix4f quaternionToMatrix(const math137::Quaternion &q) {
+  const float in[4] = {q.a, q.b, q.c, q.d};
+  float m[3][3];
+  quaternionToMatrixKernel(in, m);
+  return toMatrix(m);
+}
+
+math137::Quaternion matrixToQuaternion(const math137::Matrix4f &m) {
+  float q[4];
+  matrixToQuaternionKernel(m.data(), q);
+  return {q[0], q[1], q[2], q[3]};
+}
+
+math137::Quaternion nlerp(const math137::Quaternion &from, const math137::Quaternion &to,
+                          float alpha) {
+  const float f[4] = {from.a, from.b, from.c, from.d}, t[4] = {to.a, to.b, to.c, to.d};
+  float q[4];
+  nlerpKernel(f, t, alpha, q);
+  return {q[0], q[1], q[2], q[3]};
+}
+
+math137::Quaternion slerp(const math137::Quaternion &from, const math137::Quaternion &to,
+                          float alpha) {
+  const float f[4] = {from.a, from.b, from.c, from.d}, t[4] = {to.a, to.b, to.c, to.d};
+  float q[4];
+  slerpKernel(f, t, alpha, q);
+  return {q[0], q[1], q[2], q[3]};
+}
+
+math137::Vector3f eulerLerp(const math137::Vector3f &from, const math137::Vector3f &to,
+                            float alpha) {
+  const float f[3] = {from.x(), from.y(), from.z()}, t[3] = {to.x(), to.y(), to.z()};
+  float angles[3];
+  eulerLerpKernel(f, t, alpha, angles);
+  return {angles[0], angles[1], angles[2]};
+}
+
+void eulerToQuaternion(std::span<const float> angles, std::span<float> quaternions,
+                       EulerOrder order) {
+  const Axes &axes = axesOf(order);
+  runBatch<3, 4>(angles, quaternions,
+                 [&axes](const auto &in, auto &out) { eulerToQuaternionKernel(in, axes, out); });
+}
+
+void eulerToMatrix(std::span<const float> angles, std::span<float> matrices, EulerOrder order) {
+  const Axes &axes = axesOf(order);
+  runBatch<3, 16>(angles, matrices, [&axes](const auto &in, auto &out) {
+    std::remove_cvref_t<decltype(in[0])> m[3][3];
+    eulerToMatrixKernel(in, axes, m);
+    storeMatrix(m, out);
+  });
+}
+
+void quaternionToEuler(std::span<const float> quaternions, std::span<float> angles,
+                       EulerOrder order) {
+  const Axes &axes = axesOf(order);
+  runBatch<4, 3>(quaternions, angles, [&axes](const auto &in, auto &out) {
+    std::remove_cvref_t<decltype(in[0])> m[3][3];
+    quaternionToMatrixKernel(in, m);
+    matrixToEulerKernel(m, axes, out);
+  });
+}
+
+void quaternionToMatrix(std::span<const float> quaternions, std::span<float> matrices) {
+  runBatch<4, 16>(quaternions, matrices, [](const auto &in, auto &out) {
+    std::remove_cvref_t<decltype(in[0])> m[3][3];
+    quaternionToMatrixKernel(in, m);
+    storeMatrix(m, out);
+  });
+}
+
+void matrixToQuaternion(std::span<const float> matrices, std::span<float> quaternions) {
+  if (matrices.size() % 16 != 0 || quaternions.size() < matrices.size() / 16 * 4)
+    throw std::invalid_argument("Rotation batch sizes do not match");
+  for (size_t i = 0, j = 0; i < matrices.size(); i += 16, j += 4) {
+    float q[4];
+    matrixToQuaternionKernel(&matrices[i], q);
+    std::copy_n(q, 4, &quaternions[j]);
+  }
+}
+
+void nlerp(std::span<const float> from, std::span<const float> to, float alpha,
+           std::span<float> quaternions) {
+  runPairBatch<4, 4>(from, to, quaternions, [alpha](const auto &f, const auto &t, auto &q) {
+    nlerpKernel(f, t, std::remove_cvref_t<decltype(q[0])>(alpha), q);
+  });
+}
+
+void slerp(std::span<const float> from, std::span<const float> to, float alpha,
+           std::span<float> quaternions) {
+  runPairBatch<4, 4>(from, to, quaternions, [alpha](const auto &f, const auto &t, auto &q) {
+    slerpKernel(f, t, std::remove_cvref_t<decltype(q[0])>(alpha), q);
+  });
+}
+
+void eulerLerp(std::span<const float> from, std::span<const float> to, float alpha,
+               std::span<float> angles) {
+  runPairBatch<3, 3>(from, to, angles, [alpha](const auto &f, const auto &t, auto &a) {
+    eulerLerpKernel(f, t, std::remove_cvref_t<decltype(a[0])>(alpha), a);
+  });
+}
+} // namespace Rotation
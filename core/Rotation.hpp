@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Matrix.hpp"
+#include "Quaternion.hpp"
+#include "Vector.hpp"
+#include <cstdint>
+#include <span>
+
+// Axis sequences about fixed axes, angles[n] turns about the n-th axis of
+// the name and is applied n-th. XYZ is Rz * Ry * Rx, the convention of the
+// Euler panels. The last six repeat their first axis.
+enum class EulerOrder : uint8_t {
+  XYZ,
+  XZY,
+  YXZ,
+  YZX,
+  ZXY,
+  ZYX,
+  XYX,
+  XZX,
+  YXY,
+  YZY,
+  ZXZ,
+  ZYZ
+};
+
+// Closed form conversions between Euler angles, quaternions (a b c d, a
+// being the scalar) and rotation matrices. The scalar and batch versions
+// share their kernels, the batch ones run four rotations per SSE register.
+namespace Rotation {
+constexpr int c_orderCount = 12;
+
+math137::Quaternion eulerToQuaternion(const math137::Vector3f &angles,
+                                      EulerOrder order = EulerOrder::XYZ);
+math137::Matrix4f eulerToMatrix(const math137::Vector3f &angles,
+                                EulerOrder order = EulerOrder::XYZ);
+math137::Vector3f quaternionToEuler(const math137::Quaternion &q,
+                                    EulerOrder order = EulerOrder::XYZ);
+math137::Vector3f matrixToEuler(const math137::Matrix4f &m,
+                                EulerOrder order = EulerOrder::XYZ);
+math137::Matrix4f quaternionToMatrix(const math137::Quaternion &q);
+math137::Quaternion matrixToQuaternion(const math137::Matrix4f &m);
+
+// The panels' interpolations at alpha in [0, 1]. Both quaternion paths take
+// the shorter way round and return unit quaternions, the Euler one moves
+// every angle the shorter way round on its own.
+math137::Quaternion nlerp(const math137::Quaternion &from, const math137::Quaternion &to,
+                          float alpha);
+math137::Quaternion slerp(const math137::Quaternion &from, const math137::Quaternion &to,
+                          float alpha);
+math137::Vector3f eulerLerp(const math137::Vector3f &from, const math137::Vector3f &to,
+                            float alpha);
+
+// Packed batches: 3 angles, 4 quaternion components or 16 row-major matrix
+// elements per rotation. Quaternions need not be normalized.
+void eulerToQuaternion(std::span<const float> angles,
+                       std::span<float> quaternions,
+                       EulerOrder order = EulerOrder::XYZ);
+void eulerToMatrix(std::span<const float> angles, std::span<float> matrices,
+                   EulerOrder order = EulerOrder::XYZ);
+void quaternionToEuler(std::span<const float> quaternions,
+                       std::span<float> angles,
+                       EulerOrder order = EulerOrder::XYZ);
+void quaternionToMatrix(std::span<const float> quaternions,
+                        std::span<float> matrices);
+// one rotation at a time, the same results as the single version
+void matrixToQuaternion(std::span<const float> matrices,
+                        std::span<float> quaternions);
+// element-wise interpolation of two packed batches at one alpha
+void nlerp(std::span<const float> from, std::span<const float> to, float alpha,
+           std::span<float> quaternions);
+void slerp(std::span<const float> from, std::span<const float> to, float alpha,
+           std::span<float> quaternions);
+void eulerLerp(std::span<const float> from, std::span<const float> to, float alpha,
+               std::span<float> angles);
+} // namespace Rotation
@@ -1,11 +1,35 @@
 #include "Scene.hpp"
+#include "Rotation.hpp"
 #include <imgui.h>
 #include <cmath>
 #include <MatrixUtils.hpp>
-#include <iostream>
+#include <algorithm>
 
-Scene::Scene(bool quat)
-    : m_cursor(), m_ground(), m_useQuat(quat)
+namespace
+{
+// distance between two poses: the position change plus the arc the axis tips
+// sweep, so pure rotations still spread the samples out. The rotation angle
+// comes from the Frobenius norm of the difference, |A - B| = 2 sqrt(2)
+// sin(angle / 2), which unlike the trace stays accurate for small steps.
+float stepLength(const math137::Matrix4f &a, const math137::Matrix4f &b)
+{
+    float dx = b.getValue(0, 3) - a.getValue(0, 3);
+    float dy = b.getValue(1, 3) - a.getValue(1, 3);
+    float dz = b.getValue(2, 3) - a.getValue(2, 3);
+    float norm = 0.0f;
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 3; ++c)
+        {
+            float d = b.getValue(r, c) - a.getValue(r, c);
+            norm += d * d;
+        }
+    float angle = 2.0f * asinf(std::min(sqrtf(norm) / (2.0f * static_cast<float>(M_SQRT2)), 1.0f));
+    return sqrtf(dx * dx + dy * dy + dz * dz) + angle * Cursor::cursorLength;
+}
+} // namespace
+
+Scene::Scene(InterpolationMethod method)
+    : m_cursor(), m_method(method)
 {
 }
 
@@ -21,25 +45,112 @@ void Scene::update(float dt)
         alpha = 0.0f;
     if (alpha > 1.0f)
         alpha = 1.0f;
-    // call the selected interpolation method
-    if (!m_useQuat)
+    if (m_stream)
+        evaluateStream(m_elapsedTime);
+    else
+        interpolate(playbackAlpha(alpha));
+
+    // clamp elapsed to duration
+    if (m_elapsedTime >= m_t)
     {
-        interpolateEuler(alpha);
+        m_elapsedTime = m_t;
+    }
+}
+
+void Scene::setStream(std::shared_ptr<TrackStream> stream)
+{
+    m_stream = std::move(stream);
+    m_keys = {};
+    m_keyBounds = m_stream->getTrack().bounds;
+    m_t = m_stream->getTrack().duration;
+    m_chunk = SIZE_MAX;
+    m_loadedSegment = SIZE_MAX;
+    invalidate();
+}
+
+void Scene::clearTrack()
+{
+    m_keys = {};
+    m_stream.reset();
+    m_chunk = SIZE_MAX;
+    m_loadedSegment = SIZE_MAX;
+    invalidate();
+}
+
+void Scene::loadSegment(size_t segment)
+{
+    if (segment == m_loadedSegment)
+        return;
+    m_loadedSegment = segment;
+    const Keyframe &a = m_keys[segment];
+    const Keyframe &b = m_keys[std::min(segment + 1, m_keys.size() - 1)];
+    m_startPos = {a.position[0], a.position[1], a.position[2]};
+    m_endPos = {b.position[0], b.position[1], b.position[2]};
+    m_startQuat = {a.quaternion[0], a.quaternion[1], a.quaternion[2], a.quaternion[3]};
+    m_endQuat = {b.quaternion[0], b.quaternion[1], b.quaternion[2], b.quaternion[3]};
+    m_startEuler = {a.euler[0], a.euler[1], a.euler[2]};
+    m_endEuler = {b.euler[0], b.euler[1], b.euler[2]};
+}
+
+void Scene::evaluateTrack(float time)
+{
+    // playback moves forward, so walk from the current segment and only
+    // search when time jumped backwards
+    size_t last = m_keys.size() - 1;
+    if (m_loadedSegment == SIZE_MAX || time < m_keys[m_segment].time)
+    {
+        auto it = std::upper_bound(m_keys.begin(), m_keys.end(), time,
+                                   [](float t, const Keyframe &key) { return t < key.time; });
+        m_segment = it == m_keys.begin() ? 0 : static_cast<size_t>(it - m_keys.begin()) - 1;
     }
-    else if (m_useSpherical)
+    while (m_segment + 1 < last && m_keys[m_segment + 1].time <= time)
+        ++m_segment;
+    loadSegment(m_segment);
+
+    float alpha = 1.0f;
+    if (m_segment < last)
     {
-        interpolateSpherical(alpha);
+        float t0 = m_keys[m_segment].time;
+        float t1 = m_keys[m_segment + 1].time;
+        if (t1 > t0)
+            alpha = std::clamp((time - t0) / (t1 - t0), 0.0f, 1.0f);
     }
-    else
+    interpolate(alpha);
+}
+
+void Scene::evaluateStream(float time)
+{
+    m_stream->setPlayhead(time);
+    size_t chunk;
+    std::span<const Keyframe> keys = m_stream->find(time, chunk);
+    if (keys.empty())
+        return;
+    if (chunk != m_chunk)
     {
-        interpolateLinear(alpha);
+        m_chunk = chunk;
+        m_keys = keys;
+        m_segment = 0;
+        m_loadedSegment = SIZE_MAX;
     }
+    evaluateTrack(time);
+}
 
-    // clamp elapsed to duration
-    if (m_elapsedTime >= m_t)
+void Scene::interpolate(float alpha)
+{
+    // call the selected interpolation method
+    switch (m_method)
     {
-        m_elapsedTime = m_t;
+    case InterpolationMethod::LINEAR:
+        interpolateLinear(alpha);
+        break;
+    case InterpolationMethod::SPHERICAL:
+        interpolateSpherical(alpha);
+        break;
+    case InterpolationMethod::EULER:
+        interpolateEuler(alpha);
+        break;
     }
+    m_cursor.recalculateModelMatrix();
 }
 
 void Scene::interpolateLinear(float alpha)
@@ -51,27 +162,8 @@ void Scene::interpolateLinear(float alpha)
     pos.z(m_startPos.z() + (m_endPos.z() - m_startPos.z()) * alpha);
     m_cursor.setPosition(pos);
     
-    math137::Quaternion q1 = m_startQuat;
-    math137::Quaternion q2 = m_endQuat;
-
-    // compute dot product
-    float dot = q1.a * q2.a + q1.b * q2.b + q1.c * q2.c + q1.d * q2.d;
-
-    // if dot < 0, the quaternions have opposite handed-ness and slerp won't take
-    // the shorter path. Fix by reversing one quaternion.
-    if (dot < 0.0f)
-    {
-        dot = -dot;
-        q2.a = -q2.a;
-        q2.b = -q2.b;
-        q2.c = -q2.c;
-        q2.d = -q2.d;
-    }
-    
     // rotation: normalized linear interpolation (nlerp)
-    math137::Quaternion qr = q1 * (1.0f - alpha) + q2 * alpha;
-    qr.normalize();
-    m_cursor.setRotation(math137::MatrixUtils::FromQuaternion(qr));
+    m_cursor.setRotation(math137::MatrixUtils::FromQuaternion(Rotation::nlerp(m_startQuat, m_endQuat, alpha)));
 }
 
 void Scene::interpolateSpherical(float alpha)
@@ -84,57 +176,11 @@ void Scene::interpolateSpherical(float alpha)
     m_cursor.setPosition(pos);
 
     // rotation: spherical linear interpolation (slerp)
-    math137::Quaternion q1 = m_startQuat;
-    math137::Quaternion q2 = m_endQuat;
-
-    // compute dot product
-    float dot = q1.a * q2.a + q1.b * q2.b + q1.c * q2.c + q1.d * q2.d;
-
-    // if dot < 0, the quaternions have opposite handed-ness and slerp won't take
-    // the shorter path. Fix by reversing one quaternion.
-    if (dot < 0.0f)
-    {
-        dot = -dot;
-        q2.a = -q2.a;
-        q2.b = -q2.b;
-        q2.c = -q2.c;
-        q2.d = -q2.d;
-    }
-
-    math137::Quaternion qr;
-    // standard slerp
-    float theta_0 = acosf(dot);    // angle between input quaternions
-    float theta = theta_0 * alpha; // angle at t
-
-    // q3 = (q2 - q1 * dot) normalized
-    math137::Quaternion q3 = q2 + (q1 * (-dot));
-    q3.normalize();
-
-    float s0 = cosf(theta);
-    float s1 = sinf(theta);
-
-    qr = q1 * s0 + q3 * s1;
-    qr.normalize();
-
-    m_cursor.setRotation(math137::MatrixUtils::FromQuaternion(qr));
+    m_cursor.setRotation(math137::MatrixUtils::FromQuaternion(Rotation::slerp(m_startQuat, m_endQuat, alpha)));
 }
 
 void Scene::interpolateEuler(float alpha)
 {
-  auto eulerToQuaternion = [](float roll, float pitch, float yaw) {
-    float cr = std::cos(roll * 0.5f);
-    float sr = std::sin(roll * 0.5f);
-    float cp = std::cos(pitch * 0.5f);
-    float sp = std::sin(pitch * 0.5f);
-    float cy = std::cos(yaw * 0.5f);
-    float sy = std::sin(yaw * 0.5f);
-    math137::Quaternion q;
-    q.a = cr * cp * cy + sr * sp * sy;
-    q.b = sr * cp * cy - cr * sp * sy;
-    q.c = cr * sp * cy + sr * cp * sy;
-    q.d = cr * cp * sy - sr * sp * cy;
-    return q;
-  };
     // position still interpolated linearly
     math137::Vector3f pos;
     pos.x(m_startPos.x() + (m_endPos.x() - m_startPos.x()) * alpha);
@@ -143,74 +189,117 @@ void Scene::interpolateEuler(float alpha)
     m_cursor.setPosition(pos);
 
     // interpolate Euler angles component-wise with wrap-around handling
-    auto interpAngle = [](float a0, float a1, float t)
-    {
-        float delta = a1 - a0;
-        delta = fmodf(delta + M_PI, 2.0f * static_cast<float>(M_PI));
-        if (delta < 0)
-            delta += 2.0f * static_cast<float>(M_PI);
-        delta -= static_cast<float>(M_PI);
-
-        return a0 + delta * t;
-    };
-
-    float ax = interpAngle(m_startEuler.x(), m_endEuler.x(), alpha);
-    float ay = interpAngle(m_startEuler.y(), m_endEuler.y(), alpha);
-    float az = interpAngle(m_startEuler.z(), m_endEuler.z(), alpha);
-    std::cout << "Interpolated Euler angles: (" << ax << ", " << ay << ", " << az << ")\n";
+    m_cursor.setRotation(Rotation::eulerToMatrix(Rotation::eulerLerp(m_startEuler, m_endEuler, alpha)));
+}
 
-    m_cursor.setRotation(math137::MatrixUtils::RotateZ(az) *
-                         math137::MatrixUtils::RotateY(ay) *
-                         math137::MatrixUtils::RotateX(ax));
+std::shared_ptr<const GhostSamples> Scene::getGhosts(int intermediateFrames, GhostSpacing spacing)
+{
+    if (m_stream)
+        return nullptr;
+    intermediateFrames = std::max(intermediateFrames, 0);
+    if (!m_ghosts || intermediateFrames != m_ghostFrames || spacing != m_ghostSpacing)
+        buildGhosts(intermediateFrames, spacing);
+    return m_ghosts;
 }
 
-void Scene::renderSamples(std::unique_ptr<Renderer> &renderer, int intermediateFrames)
+void Scene::buildGhosts(int intermediateFrames, GhostSpacing spacing)
 {
-    if (intermediateFrames < 0)
-        intermediateFrames = 0;
+    // sampling moves the cursor, a scratch copy leaves the live pose alone
+    Scene sampler = *this;
     int totalSamples = intermediateFrames + 2; // include start and end
+    std::vector<float> alphas(totalSamples);
+    for (int i = 0; i < totalSamples; ++i)
+        alphas[i] = static_cast<float>(i) / static_cast<float>(totalSamples - 1);
 
-    // save current cursor transform
-    math137::Vector3f savedPos = m_cursor.getPosition();
-    math137::Matrix4f savedRot = m_cursor.getRotation();
+    if (spacing == GhostSpacing::ARC_LENGTH)
+    {
+        // evenly spaced distances, inverted through the table
+        const ArcLengthTable &arcLength = getArcLength();
+        for (float &alpha : alphas)
+            alpha = arcLength.alphaAt(alpha);
+    }
 
-    for (int i = 0; i < totalSamples; ++i)
+    auto ghosts = std::make_shared<GhostSamples>();
+    ghosts->models.reserve(totalSamples);
+    ghosts->instances.reserve(totalSamples * 3);
+    for (float alpha : alphas)
     {
-        float alpha = 0.0f;
-        if (totalSamples > 1)
-            alpha = static_cast<float>(i) / static_cast<float>(totalSamples - 1);
-
-        // apply chosen interpolation to set m_cursor
-        if (!m_useQuat)
-            interpolateEuler(alpha);
-        else if (m_useSpherical)
-            interpolateSpherical(alpha);
-        else
-            interpolateLinear(alpha);
-
-        // render the cursor at this sample
-        m_cursor.render(renderer);
+        sampler.interpolate(alpha);
+        ghosts->models.push_back(sampler.getModel());
+        Cursor::appendInstances(sampler.getModel(), 0, ghosts->instances);
     }
+    m_ghosts = std::move(ghosts);
+    m_ghostFrames = intermediateFrames;
+    m_ghostSpacing = spacing;
+}
 
-    // restore saved cursor transform
-    m_cursor.setPosition(savedPos);
-    m_cursor.setRotation(savedRot);
+const ArcLengthTable &Scene::getArcLength()
+{
+    if (m_arcLength)
+        return *m_arcLength;
+    auto table = std::make_shared<ArcLengthTable>();
+    size_t steps = std::max(m_arcLengthSteps, ArcLengthTable::c_minSteps);
+    table->build(steps, [this, steps](size_t first, size_t last, float *lengths)
+    {
+        // every chunk samples its own copy and evaluates the start of its
+        // first step itself, so it never waits on a neighbour
+        Scene sampler = *this;
+        sampler.interpolate(static_cast<float>(first) / static_cast<float>(steps));
+        math137::Matrix4f previous = sampler.getModel();
+        for (size_t step = first; step < last; ++step)
+        {
+            sampler.interpolate(static_cast<float>(step + 1) / static_cast<float>(steps));
+            lengths[step - first] = stepLength(previous, sampler.getModel());
+            previous = sampler.getModel();
+        }
+    });
+    m_arcLength = std::move(table);
+    return *m_arcLength;
 }
 
-void Scene::render(std::unique_ptr<Renderer> &renderer)
+float Scene::playbackAlpha(float fraction)
 {
-    m_cursor.render(renderer);
-    m_ground.render(renderer);
+    if (!m_constantSpeed || m_stream)
+        return fraction;
+    return getArcLength().alphaAt(fraction);
+}
+
+BoundingSphere Scene::getTrackBounds() const
+{
+    if (m_stream)
+        return {m_keyBounds.center, m_keyBounds.radius + Cursor::boundingRadius};
+
+    // positions are always interpolated linearly, so the track is a segment
+    float dx = m_endPos.x() - m_startPos.x();
+    float dy = m_endPos.y() - m_startPos.y();
+    float dz = m_endPos.z() - m_startPos.z();
+    math137::Vector3f center{m_startPos.x() + dx * 0.5f, m_startPos.y() + dy * 0.5f,
+                             m_startPos.z() + dz * 0.5f};
+    float radius = 0.5f * sqrtf(dx * dx + dy * dy + dz * dz) + Cursor::boundingRadius;
+    return {center, radius};
 }
 
 void Scene::start()
 {
     m_elapsedTime = 0.0f;
+    if (m_stream)
+    {
+        evaluateStream(0.0f);
+        return;
+    }
     m_cursor.setPosition(m_startPos);
-    if(m_useQuat)
+    if(m_method != InterpolationMethod::EULER)
         m_cursor.setRotation(math137::MatrixUtils::FromQuaternion(m_startQuat));
     else
-        m_cursor.setRotation(math137::MatrixUtils::RotateZ(m_startEuler.z()) *
-                             math137::MatrixUtils::RotateY(m_startEuler.y()) *
-                             math137::MatrixUtils::RotateX(m_startEuler.x()));
+        m_cursor.setRotation(Rotation::eulerToMatrix(m_startEuler));
+    m_cursor.recalculateModelMatrix();
+}
+
+void Scene::seek(float time)
+{
+    m_elapsedTime = std::clamp(time, 0.0f, m_t);
+    if (m_stream)
+        evaluateStream(m_elapsedTime);
+    else if (m_t > 0.0f)
+        interpolate(playbackAlpha(m_elapsedTime / m_t));
 }
@@ -1,32 +1,80 @@
 #pragma once
+#include "ArcLengthTable.hpp"
 #include "Cursor.hpp"
-#include "Ground.hpp"
+#include "TrackFile.hpp"
+#include "TrackStream.hpp"
+#include <memory>
+#include <span>
+#include <vector>
+
+enum class InterpolationMethod { LINEAR, SPHERICAL, EULER };
+
+// where ghost frames sit along the track: evenly in time, or evenly in the
+// distance the cursor covers, position plus the arc its axis tips sweep
+enum class GhostSpacing { TIME, ARC_LENGTH };
+
+// start, end and intermediate poses of a track. Never modified once built,
+// so every snapshot can share it until something it depends on changes.
+struct GhostSamples {
+    std::vector<math137::Matrix4f> models;
+    // the same poses as axis instances, ready for CursorBatch
+    std::vector<CursorInstance> instances;
+};
 
 class Scene {
 public:
-    Scene(bool quat);
+    Scene(InterpolationMethod method);
     void update(float dt);
-    void render(std::unique_ptr<Renderer>& renderer);
     void renderMenu();
-    void renderSamples(std::unique_ptr<Renderer>& renderer, int intermediateFrames);
-    inline void setStartPosition(const math137::Vector3f& pos) { m_startPos = pos; }
-    inline void setStartQuaternion(const math137::Quaternion& rot) { m_startQuat = rot; }
-    inline void setEndEuler(const math137::Vector3f& rot) { m_endEuler = rot; }
-    inline void setEndPosition(const math137::Vector3f& pos) { m_endPos = pos; }
-    inline void setEndQuaternion(const math137::Quaternion& rot) { m_endQuat = rot; }
-    inline void setStartEuler(const math137::Vector3f& rot) { m_startEuler = rot; }
-    inline void setT(float t) { m_t = t; }
+    // rebuilt only when the endpoints, method, track or arguments changed,
+    // null for streamed tracks, sampling those end to end would page in all
+    // of them
+    std::shared_ptr<const GhostSamples> getGhosts(int intermediateFrames, GhostSpacing spacing);
+    inline const math137::Matrix4f& getModel() const { return m_cursor.getModel(); }
+    inline void setStartPosition(const math137::Vector3f& pos) { m_startPos = pos; invalidate(); }
+    inline void setStartQuaternion(const math137::Quaternion& rot) { m_startQuat = rot; invalidate(); }
+    inline void setEndEuler(const math137::Vector3f& rot) { m_endEuler = rot; invalidate(); }
+    inline void setEndPosition(const math137::Vector3f& pos) { m_endPos = pos; invalidate(); }
+    inline void setEndQuaternion(const math137::Quaternion& rot) { m_endQuat = rot; invalidate(); }
+    inline void setStartEuler(const math137::Vector3f& rot) { m_startEuler = rot; invalidate(); }
+    inline void setT(float t) { m_t = t; invalidate(); }
+    // plays a track one resident chunk at a time, the pose is held while the
+    // chunk under the playhead is still being read
+    void setStream(std::shared_ptr<TrackStream> stream);
+    void clearTrack();
     void start();
-    inline void setUseSphericalInterpolation(bool v) { m_useSpherical = v; }
+    void seek(float time);
+    inline float getElapsedTime() const { return m_elapsedTime; }
+    inline float getDuration() const { return m_t; }
+    // plays the start/end pair at a constant distance per second, mapping
+    // time through a table of the distance covered. Streamed tracks keep
+    // their own timing.
+    inline void setConstantSpeed(bool constantSpeed) { m_constantSpeed = constantSpeed; }
+    inline bool getConstantSpeed() const { return m_constantSpeed; }
+    // resolution of the table, see ArcLengthTable::stepsForBudget
+    inline void setArcLengthSteps(size_t steps) { m_arcLengthSteps = steps; invalidate(); }
+    inline void setMethod(InterpolationMethod method) { m_method = method; invalidate(); }
+    inline InterpolationMethod getMethod() const { return m_method; }
+    // encloses every pose of the cursor between the start and end
+    BoundingSphere getTrackBounds() const;
 
 private:
     Cursor m_cursor;
-    Ground m_ground;
 
     // interpolation helpers
+    void interpolate(float alpha);
     void interpolateLinear(float alpha);
     void interpolateSpherical(float alpha);
     void interpolateEuler(float alpha);
+    void evaluateTrack(float time);
+    void evaluateStream(float time);
+    void loadSegment(size_t segment);
+    void buildGhosts(int intermediateFrames, GhostSpacing spacing);
+    // built on first use after anything the track depends on changed
+    const ArcLengthTable &getArcLength();
+    // alpha the cursor is at after the given fraction of the duration
+    float playbackAlpha(float fraction);
+    inline void invalidate() { m_ghosts.reset(); m_arcLength.reset(); }
 
     math137::Vector3f m_startPos{0.0f, 0.0f, 0.0f};
     math137::Vector3f m_startEuler{0.0f, 0.0f, 0.0f};
@@ -36,6 +84,23 @@ private:
     math137::Quaternion m_endQuat{1.0f, 0.0f, 0.0f, 0.0f};
     float m_t{0.0f};
     float m_elapsedTime{0.0f};
-    bool m_useSpherical{false};
-    bool m_useQuat{true};
+    InterpolationMethod m_method;
+
+    // the resident chunk of the stream being played
+    std::span<const Keyframe> m_keys;
+    BoundingSphere m_keyBounds{};
+    size_t m_segment{0};
+    size_t m_loadedSegment{SIZE_MAX};
+    std::shared_ptr<TrackStream> m_stream;
+    size_t m_chunk{SIZE_MAX};
+
+    // reset by anything the samples depend on
+    std::shared_ptr<const GhostSamples> m_ghosts;
+    int m_ghostFrames{0};
+    GhostSpacing m_ghostSpacing{GhostSpacing::TIME};
+
+    // shared with the scratch copies that sample the track
+    std::shared_ptr<const ArcLengthTable> m_arcLength;
+    size_t m_arcLengthSteps{ArcLengthTable::c_defaultSteps};
+    bool m_constantSpeed{false};
 };
\ No newline at end of file
@@ -6,13 +6,37 @@
 #include <stdexcept>
 #include <string>
 
-Shader::Shader(std::string vertexPath, std::string fragmentPath) {
+ShaderSource ShaderSource::readCompute(const std::string &computePath) {
+  return {{}, {}, Shader::getShaderCode(computePath)};
+}
 
-  std::string vertexCode = getShaderCode(vertexPath);
-  std::string fragmentCode = getShaderCode(fragmentPath);
+ShaderSource ShaderSource::read(const std::string &vertexPath,
+                                const std::string &fragmentPath) {
+  return {Shader::getShaderCode(vertexPath),
+          Shader::getShaderCode(fragmentPath), {}};
+}
 
-  const char *vs = vertexCode.c_str();
-  const char *fs = fragmentCode.c_str();
+Shader::Shader(const ShaderSource &source) {
+  m_id = glCreateProgram();
+  if (!source.compute.empty()) {
+    const char *cs = source.compute.c_str();
+
+    uint32_t cId;
+    cId = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(cId, 1, &cs, NULL);
+    glCompileShader(cId);
+    checkCompileErrors(cId, "Compute");
+
+    glAttachShader(m_id, cId);
+    glLinkProgram(m_id);
+    checkCompileErrors(m_id, "Program");
+
+    glDeleteShader(cId);
+    return;
+  }
+
+  const char *vs = source.vertex.c_str();
+  const char *fs = source.fragment.c_str();
 
   uint32_t vId, fId;
   vId = glCreateShader(GL_VERTEX_SHADER);
@@ -25,7 +49,6 @@ Shader::Shader(std::string vertexPath, std::string fragmentPath) {
   glCompileShader(fId);
   checkCompileErrors(fId, "Fragment");
 
-  m_id = glCreateProgram();
   glAttachShader(m_id, vId);
   glAttachShader(m_id, fId);
   glLinkProgram(m_id);
@@ -34,6 +57,13 @@ Shader::Shader(std::string vertexPath, std::string fragmentPath) {
   glDeleteShader(vId);
   glDeleteShader(fId);
 }
+
+Shader::Shader(std::string computePath)
+    : Shader(ShaderSource::readCompute(computePath)) {}
+
+Shader::Shader(std::string vertexPath, std::string fragmentPath)
+    : Shader(ShaderSource::read(vertexPath, fragmentPath)) {}
+
 Shader::Shader(std::string vertexShaderPath, std::string fragmentShaderPath,
                std::string tessalationControlPath,
                std::string tessalationEvaluationPath) {
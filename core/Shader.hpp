@@ -6,70 +6,99 @@
 #include <cstdint>
 #include <string>
 
-enum class ShaderType { OBJECT };
+enum class ShaderType { OBJECT, INSTANCED, SELECT, TRAIL };
+
+// Code of a compute shader, or of a vertex and fragment shader pair, read
+// ahead so the compile is all that is left for the context thread.
+struct ShaderSource {
+  std::string vertex;
+  std::string fragment;
+  std::string compute;
+
+  static ShaderSource readCompute(const std::string &computePath);
+  static ShaderSource read(const std::string &vertexPath,
+                           const std::string &fragmentPath);
+};
 
 class Shader {
 public:
+  explicit Shader(const ShaderSource &source);
+  Shader(std::string computeShaderPath);
   Shader(std::string vertexShaderPath, std::string fragmentShaderPath);
   Shader(std::string vertexShaderPath, std::string fragmentShaderPath,
          std::string tessalationControlPath,
          std::string tessalationEvaluationPath);
   inline void use() const { glUseProgram(m_id); };
 
-  inline void setBool(const std::string &name, bool value) const {
-    glUniform1i(glGetUniformLocation(m_id, name.c_str()), (int)value);
+  inline void setBool(const char *name, bool value) const {
+    glUniform1i(glGetUniformLocation(m_id, name), (int)value);
+  }
+  inline void setUInt(const char *name, uint32_t value) const {
+    glUniform1ui(glGetUniformLocation(m_id, name), value);
   }
-  inline void setUInt(const std::string &name, uint32_t value) const {
-    glUniform1ui(glGetUniformLocation(m_id, name.c_str()), value);
+  inline void setInt(const char *name, int value) const {
+    glUniform1i(glGetUniformLocation(m_id, name), value);
   }
-  inline void setInt(const std::string &name, int value) const {
-    glUniform1i(glGetUniformLocation(m_id, name.c_str()), value);
+  inline void setFloat(const char *name, float value) const {
+    glUniform1f(glGetUniformLocation(m_id, name), value);
   }
-  inline void setFloat(const std::string &name, float value) const {
-    glUniform1f(glGetUniformLocation(m_id, name.c_str()), value);
+  inline void setFloatArray(const char *name, const float *values,
+                            int count) const {
+    glUniform1fv(glGetUniformLocation(m_id, name), count, values);
   }
-  inline void setVec2(const std::string &name,
+  inline void setVec4Array(const char *name, const float *values,
+                           int count) const {
+    glUniform4fv(glGetUniformLocation(m_id, name), count, values);
+  }
+  inline void setVec2(const char *name,
                       const math137::Vector2f &value) const {
-    glUniform2fv(glGetUniformLocation(m_id, name.c_str()), 1, value.data());
+    glUniform2fv(glGetUniformLocation(m_id, name), 1, value.data());
   }
-  inline void setVec2(const std::string &name, float x, float y) const {
-    glUniform2f(glGetUniformLocation(m_id, name.c_str()), x, y);
+  inline void setVec2(const char *name, float x, float y) const {
+    glUniform2f(glGetUniformLocation(m_id, name), x, y);
   }
-  inline void setVec3(const std::string &name,
+  inline void setVec3(const char *name,
                       const math137::Vector3f &value) const {
-    glUniform3fv(glGetUniformLocation(m_id, name.c_str()), 1, value.data());
+    glUniform3fv(glGetUniformLocation(m_id, name), 1, value.data());
   }
-  inline void setVec3(const std::string &name, float x, float y,
+  inline void setVec3(const char *name, float x, float y,
                       float z) const {
-    glUniform3f(glGetUniformLocation(m_id, name.c_str()), x, y, z);
+    glUniform3f(glGetUniformLocation(m_id, name), x, y, z);
   }
-  inline void setVec4(const std::string &name,
+  inline void setVec4(const char *name,
                       const math137::Vector4f &value) const {
-    glUniform4fv(glGetUniformLocation(m_id, name.c_str()), 1, value.data());
+    glUniform4fv(glGetUniformLocation(m_id, name), 1, value.data());
   }
-  inline void setVec4(const std::string &name, float x, float y, float z,
+  inline void setVec4(const char *name, float x, float y, float z,
                       float w) const {
-    glUniform4f(glGetUniformLocation(m_id, name.c_str()), x, y, z, w);
+    glUniform4f(glGetUniformLocation(m_id, name), x, y, z, w);
   }
-  inline void setMat2(const std::string &name,
+  inline void setMat2(const char *name,
                       const math137::Matrix<float, 2, 2> &mat) const {
-    glUniformMatrix2fv(glGetUniformLocation(m_id, name.c_str()), 1, GL_TRUE,
+    glUniformMatrix2fv(glGetUniformLocation(m_id, name), 1, GL_TRUE,
                        mat.data());
   }
-  inline void setMat3(const std::string &name,
+  inline void setMat3(const char *name,
                       const math137::Matrix<float, 3, 3> &mat) const {
-    glUniformMatrix3fv(glGetUniformLocation(m_id, name.c_str()), 1, GL_TRUE,
+    glUniformMatrix3fv(glGetUniformLocation(m_id, name), 1, GL_TRUE,
                        mat.data());
   }
-  inline void setMat4(const std::string &name,
+  inline void setMat4(const char *name,
                       const math137::Matrix4f &mat) const {
-    glUniformMatrix4fv(glGetUniformLocation(m_id, name.c_str()), 1, GL_TRUE,
+    glUniformMatrix4fv(glGetUniformLocation(m_id, name), 1, GL_TRUE,
                        mat.data());
   }
+  inline void setMat4Array(const char *name, const float *values,
+                           int count) const {
+    glUniformMatrix4fv(glGetUniformLocation(m_id, name), count,
+                       GL_TRUE, values);
+  }
 
 private:
+  friend struct ShaderSource;
+
   void checkCompileErrors(uint32_t shader, std::string type);
-  std::string getShaderCode(std::string filePath);
+  static std::string getShaderCode(std::string filePath);
 
   uint32_t m_id;
 };
@@ -0,0 +1,108 @@
+#include "Simd.hpp"
+#include <stdexcept>
+
+namespace {
+void checkSizes(size_t in, size_t out, size_t inStride, size_t outStride) {
+  if (in % inStride != 0 || in / inStride != out / outStride || out % outStride != 0)
+    throw std::invalid_argument("Batch sizes do not match");
+}
+
+#if SIMD_AVX
+// two rows of out per 256 bit register, lane l of every step broadcasts
+// a[row + l][k] against row k of b held in both lanes
+inline void multiplyMatrixAvx(const float *a, const __m256 (&b)[4], float *out) {
+  for (int r = 0; r < 4; r += 2) {
+    __m256 rows = _mm256_loadu_ps(a + r * 4);
+    __m256 sum = _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0x00), b[0]);
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0x55), b[1]));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0xaa), b[2]));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0xff), b[3]));
+    _mm256_storeu_ps(out + r * 4, sum);
+  }
+}
+
+inline void broadcastRows(const float *b, __m256 (&rows)[4]) {
+  for (int k = 0; k < 4; ++k)
+    rows[k] = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(b + k * 4));
+}
+#endif
+} // namespace
+
+namespace Simd {
+void multiplyMatrices(std::span<const float> a, std::span<const float> b, std::span<float> out) {
+  checkSizes(a.size(), out.size(), 16, 16);
+  checkSizes(b.size(), out.size(), 16, 16);
+  for (size_t i = 0; i < out.size(); i += 16) {
+#if SIMD_AVX
+    __m256 rows[4];
+    broadcastRows(&b[i], rows);
+    multiplyMatrixAvx(&a[i], rows, &out[i]);
+#else
+    multiplyMatrix(&a[i], &b[i], &out[i]);
+#endif
+  }
+}
+
+void multiplyMatrices(const math137::Matrix4f &left, std::span<const float> b,
+                      std::span<float> out) {
+  checkSizes(b.size(), out.size(), 16, 16);
+  const float *a = left.data();
+  for (size_t i = 0; i < out.size(); i += 16) {
+#if SIMD_AVX
+    __m256 rows[4];
+    broadcastRows(&b[i], rows);
+    multiplyMatrixAvx(a, rows, &out[i]);
+#else
+    multiplyMatrix(a, &b[i], &out[i]);
+#endif
+  }
+}
+
+void translateMatrices(std::span<const float> translations, std::span<const float> matrices,
+                       std::span<float> out) {
+  checkSizes(translations.size(), out.size(), 3, 16);
+  checkSizes(matrices.size(), out.size(), 16, 16);
+  for (size_t i = 0, t = 0; i < out.size(); i += 16, t += 3)
+    translateMatrix(&translations[t], &matrices[i], &out[i]);
+}
+
+void transformPoints(const math137::Matrix4f &m, std::span<const float> points,
+                     std::span<float> out) {
+  checkSizes(points.size(), out.size(), 3, 3);
+  const float *e = m.data();
+  size_t count = points.size() / 3;
+  size_t i = 0;
+#if SIMD_SSE
+  // a point is the sum of the columns scaled by its coordinates, all three
+  // rows at once
+  __m128 columns[4];
+  for (int c = 0; c < 4; ++c)
+    columns[c] = _mm_setr_ps(e[c], e[4 + c], e[8 + c], 0.0f);
+  // four floats are stored per point, the fourth is overwritten by the
+  // next, so the last point is left to the loop below
+  for (; i + 1 < count; ++i) {
+    const float *p = &points[i * 3];
+    __m128 sum = _mm_add_ps(_mm_mul_ps(columns[0], _mm_set1_ps(p[0])),
+                            _mm_mul_ps(columns[1], _mm_set1_ps(p[1])));
+    sum = _mm_add_ps(sum, _mm_mul_ps(columns[2], _mm_set1_ps(p[2])));
+    sum = _mm_add_ps(sum, columns[3]);
+    _mm_storeu_ps(&out[i * 3], sum);
+  }
+#endif
+  for (; i < count; ++i) {
+    const float *p = &points[i * 3];
+    float *o = &out[i * 3];
+    float x = p[0], y = p[1], z = p[2];
+    for (int r = 0; r < 3; ++r)
+      o[r] = e[r * 4] * x + e[r * 4 + 1] * y + e[r * 4 + 2] * z + e[r * 4 + 3];
+  }
+}
+
+void multiplyQuaternions(std::span<const float> a, std::span<const float> b,
+                         std::span<float> out) {
+  checkSizes(a.size(), out.size(), 4, 4);
+  checkSizes(b.size(), out.size(), 4, 4);
+  for (size_t i = 0; i < out.size(); i += 4)
+    multiplyQuaternion(&a[i], &b[i], &out[i]);
+}
+} // namespace Simd
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Matrix.hpp"
+#include <cstddef>
+#include <span>
+
+// SIMD_SCALAR, set by -DINTERPOLATION_SIMD=SCALAR, keeps every kernel of the
+// project on plain loops, to compare against or for targets without SSE2
+#if !defined(SIMD_SCALAR) &&                                                    \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define SIMD_SSE 1
+#else
+#define SIMD_SSE 0
+#endif
+#if SIMD_SSE && defined(__AVX__)
+#include <immintrin.h>
+#define SIMD_AVX 1
+#else
+#define SIMD_AVX 0
+#endif
+
+// Kernels on the raw floats of row-major 4x4 matrices, the layout of
+// math137::Matrix4f and of the packed batches of Rotation, and of
+// quaternions stored a b c d, a being the scalar. The single versions are
+// inline for the per-cursor paths, the batch ones also use AVX when the
+// build enables it.
+namespace Simd {
+#if SIMD_AVX
+constexpr const char *c_backend = "AVX";
+#elif SIMD_SSE
+constexpr const char *c_backend = "SSE";
+#else
+constexpr const char *c_backend = "scalar";
+#endif
+
+// out = a * b, out must not alias either
+inline void multiplyMatrix(const float *a, const float *b, float *out) {
+#if SIMD_SSE
+  __m128 rows[4] = {_mm_loadu_ps(b), _mm_loadu_ps(b + 4), _mm_loadu_ps(b + 8),
+                    _mm_loadu_ps(b + 12)};
+  for (int r = 0; r < 4; ++r) {
+    __m128 row = _mm_mul_ps(_mm_set1_ps(a[r * 4]), rows[0]);
+    row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[r * 4 + 1]), rows[1]));
+    row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[r * 4 + 2]), rows[2]));
+    row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[r * 4 + 3]), rows[3]));
+    _mm_storeu_ps(out + r * 4, row);
+  }
+#else
+  for (int r = 0; r < 4; ++r)
+    for (int c = 0; c < 4; ++c)
+      out[r * 4 + c] = a[r * 4] * b[c] + a[r * 4 + 1] * b[4 + c] + a[r * 4 + 2] * b[8 + c] +
+                       a[r * 4 + 3] * b[12 + c];
+#endif
+}
+
+// Translate(t) * m without the full product, every row but the last gains
+// t times the last one, out may alias m
+inline void translateMatrix(const float *t, const float *m, float *out) {
+#if SIMD_SSE
+  __m128 last = _mm_loadu_ps(m + 12);
+  for (int r = 0; r < 3; ++r)
+    _mm_storeu_ps(out + r * 4,
+                  _mm_add_ps(_mm_loadu_ps(m + r * 4), _mm_mul_ps(_mm_set1_ps(t[r]), last)));
+  _mm_storeu_ps(out + 12, last);
+#else
+  for (int c = 0; c < 4; ++c) {
+    float last = m[12 + c];
+    for (int r = 0; r < 3; ++r)
+      out[r * 4 + c] = m[r * 4 + c] + t[r] * last;
+    out[12 + c] = last;
+  }
+#endif
+}
+
+// Hamilton product a * b, out must not alias either
+inline void multiplyQuaternion(const float *a, const float *b, float *out) {
+#if SIMD_SSE
+  // every component is a0 * b plus the other three of a times b shuffled,
+  // with the signs of the product table
+  __m128 v = _mm_loadu_ps(b);
+  __m128 r = _mm_mul_ps(_mm_set1_ps(a[0]), v);
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(a[1]), _mm_setr_ps(-1, 1, -1, 1)),
+                               _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1))));
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(a[2]), _mm_setr_ps(-1, 1, 1, -1)),
+                               _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2))));
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(a[3]), _mm_setr_ps(-1, -1, 1, 1)),
+                               _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3))));
+  _mm_storeu_ps(out, r);
+#else
+  out[0] = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+  out[1] = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+  out[2] = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+  out[3] = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+#endif
+}
+
+inline math137::Matrix4f toMatrix(const float (&m)[16]) {
+  math137::Matrix4f matrix;
+  for (int i = 0; i < 16; ++i)
+    matrix.setValue(i / 4, i % 4, m[i]);
+  return matrix;
+}
+
+inline math137::Matrix4f multiply(const math137::Matrix4f &a, const math137::Matrix4f &b) {
+  float out[16];
+  multiplyMatrix(a.data(), b.data(), out);
+  return toMatrix(out);
+}
+
+inline math137::Matrix4f translate(float x, float y, float z, const math137::Matrix4f &m) {
+  const float t[3] = {x, y, z};
+  float out[16];
+  translateMatrix(t, m.data(), out);
+  return toMatrix(out);
+}
+
+// Packed batches, 16 floats per matrix, 4 per quaternion and 3 per point or
+// translation. Each output element may not alias an input.
+// out[i] = a[i] * b[i]
+void multiplyMatrices(std::span<const float> a, std::span<const float> b, std::span<float> out);
+// out[i] = left * b[i], as for the descendants of one node
+void multiplyMatrices(const math137::Matrix4f &left, std::span<const float> b,
+                      std::span<float> out);
+// out[i] = Translate(translations[i]) * matrices[i], in place if out is
+// matrices
+void translateMatrices(std::span<const float> translations, std::span<const float> matrices,
+                       std::span<float> out);
+// out[i] = m * (points[i], 1), the w row is ignored
+void transformPoints(const math137::Matrix4f &m, std::span<const float> points,
+                     std::span<float> out);
+// out[i] = a[i] * b[i]
+void multiplyQuaternions(std::span<const float> a, std::span<const float> b,
+                         std::span<float> out);
+} // namespace Simd
@@ -0,0 +1,213 @@
+#include "Simulation.hpp"
+#include <algorithm>
+#include <chrono>
+
+Simulation::Simulation(float tickRate, bool threaded) : m_tickRate(tickRate) {
+  if (threaded)
+    m_thread = std::jthread([this](std::stop_token stop) { run(stop); });
+}
+
+Simulation::~Simulation() {
+  if (m_thread.joinable()) {
+    m_thread.request_stop();
+    m_thread.join();
+  }
+}
+
+void Simulation::advance(double dt) {
+  // whole ticks only, so the result depends on the clock and not on how it
+  // was sliced into frames
+  double step = 1.0 / std::max(m_tickRate.load(), 1.0f);
+  m_accumulator += dt;
+  while (m_accumulator >= step) {
+    m_accumulator -= step;
+    tick(static_cast<float>(step));
+  }
+}
+
+void Simulation::addPanel(InterpolationMethod method) {
+  enqueue([this, method]() {
+    auto scene = std::make_unique<Scene>(method);
+    scene->setConstantSpeed(m_constantSpeed);
+    scene->setArcLengthSteps(m_arcLengthSteps);
+    std::unique_ptr<Skeleton> skeleton;
+    if (m_skeletonJoints > 0)
+      skeleton = std::make_unique<Skeleton>(Skeleton::procedural(m_skeletonJoints));
+    m_panels.push_back({m_nextId++, std::move(scene), std::move(skeleton)});
+  });
+}
+
+void Simulation::removePanel(uint32_t id) {
+  enqueue([this, id]() {
+    std::erase_if(m_panels, [id](const Panel &panel) { return panel.id == id; });
+  });
+}
+
+void Simulation::setMethod(uint32_t id, InterpolationMethod method) {
+  enqueue([this, id, method]() {
+    for (Panel &panel : m_panels) {
+      if (panel.id == id) {
+        panel.scene->setMethod(method);
+        panel.scene->start();
+      }
+    }
+  });
+}
+
+void Simulation::setTrack(const TrackParameters &track) {
+  enqueue([this, track]() {
+    for (Panel &panel : m_panels) {
+      Scene &scene = *panel.scene;
+      scene.setStartPosition(track.startPos);
+      scene.setEndPosition(track.endPos);
+      scene.setStartEuler(track.startEuler);
+      scene.setEndEuler(track.endEuler);
+      scene.setStartQuaternion(track.startQuat);
+      scene.setEndQuaternion(track.endQuat);
+      scene.setT(track.duration);
+      scene.clearTrack();
+      scene.start();
+    }
+    m_stream.reset();
+  });
+}
+
+void Simulation::playTrack(std::shared_ptr<const TrackFile> file,
+                           size_t index) {
+  enqueue([this, file, index]() {
+    m_stream = std::make_shared<TrackStream>(file, index);
+    for (Panel &panel : m_panels) {
+      panel.scene->setStream(m_stream);
+      panel.scene->start();
+    }
+  });
+}
+
+void Simulation::seek(float time) {
+  enqueue([this, time]() {
+    for (Panel &panel : m_panels)
+      panel.scene->seek(time);
+  });
+}
+
+void Simulation::setGhostFrames(bool show, int intermediateFrames) {
+  enqueue([this, show, intermediateFrames]() {
+    m_showGhosts = show;
+    m_intermediateFrames = intermediateFrames;
+  });
+}
+
+void Simulation::setGhostSpacing(GhostSpacing spacing) {
+  enqueue([this, spacing]() { m_ghostSpacing = spacing; });
+}
+
+void Simulation::setConstantSpeed(bool constantSpeed) {
+  enqueue([this, constantSpeed]() {
+    m_constantSpeed = constantSpeed;
+    // same time, but the pose at it moves
+    for (Panel &panel : m_panels) {
+      panel.scene->setConstantSpeed(constantSpeed);
+      panel.scene->seek(panel.scene->getElapsedTime());
+    }
+  });
+}
+
+void Simulation::setArcLengthBudget(size_t bytes) {
+  enqueue([this, bytes]() {
+    m_arcLengthSteps = ArcLengthTable::stepsForBudget(bytes);
+    for (Panel &panel : m_panels)
+      panel.scene->setArcLengthSteps(m_arcLengthSteps);
+  });
+}
+
+void Simulation::setSkeleton(size_t joints) {
+  enqueue([this, joints]() {
+    m_skeletonJoints = joints;
+    // built once, every panel poses its own copy
+    Skeleton rig = joints > 0 ? Skeleton::procedural(joints) : Skeleton();
+    for (Panel &panel : m_panels)
+      panel.skeleton = joints > 0 ? std::make_unique<Skeleton>(rig) : nullptr;
+  });
+}
+
+const SimulationSnapshot &Simulation::acquire() {
+  m_snapshots.update();
+  return m_snapshots.front();
+}
+
+void Simulation::enqueue(std::function<void()> command) {
+  std::lock_guard lock(m_commandMutex);
+  m_commands.push_back(std::move(command));
+}
+
+void Simulation::applyCommands() {
+  {
+    std::lock_guard lock(m_commandMutex);
+    std::swap(m_commands, m_executing);
+  }
+  for (auto &command : m_executing)
+    command();
+  m_executing.clear();
+}
+
+void Simulation::publish() {
+  SimulationSnapshot &snapshot = m_snapshots.back();
+  snapshot.tick = m_tick;
+  snapshot.time = m_panels.empty() ? 0.0f : m_panels[0].scene->getElapsedTime();
+  snapshot.duration = m_panels.empty() ? 0.0f : m_panels[0].scene->getDuration();
+  snapshot.streaming = m_stream != nullptr;
+  if (m_stream)
+    snapshot.stream = m_stream->getStats();
+  snapshot.panels.resize(m_panels.size());
+  for (size_t i = 0; i < m_panels.size(); ++i) {
+    const Scene &scene = *m_panels[i].scene;
+    PanelSnapshot &panel = snapshot.panels[i];
+    panel.id = m_panels[i].id;
+    panel.method = scene.getMethod();
+    panel.model = scene.getModel();
+    panel.track = scene.getTrackBounds();
+    // only samples again after the track or the settings changed
+    panel.ghosts = nullptr;
+    if (m_showGhosts)
+      panel.ghosts = m_panels[i].scene->getGhosts(m_intermediateFrames, m_ghostSpacing);
+    // keeps the capacity of the snapshot it reuses
+    panel.skeleton.clear();
+    if (m_panels[i].skeleton)
+      m_panels[i].skeleton->appendInstances(0, panel.skeleton);
+  }
+  m_snapshots.publish();
+}
+
+void Simulation::tick(float dt) {
+  applyCommands();
+  for (Panel &panel : m_panels) {
+    Scene &scene = *panel.scene;
+    scene.update(dt);
+    if (panel.skeleton) {
+      float duration = scene.getDuration();
+      float alpha = duration > 0.0f ? scene.getElapsedTime() / duration : 0.0f;
+      panel.skeleton->evaluate(alpha, scene.getMethod(), scene.getModel());
+    }
+  }
+  ++m_tick;
+  publish();
+}
+
+void Simulation::run(std::stop_token stop) {
+  using clock = std::chrono::steady_clock;
+  auto previous = clock::now();
+  auto next = previous;
+  while (!stop.stop_requested()) {
+    auto now = clock::now();
+    float dt = std::chrono::duration<float>(now - previous).count();
+    previous = now;
+    tick(dt);
+
+    // fixed rate, but never try to catch up on ticks lost to a hitch
+    next += std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<float>(1.0f / std::max(m_tickRate.load(), 1.0f)));
+    if (next < now)
+      next = now;
+    std::this_thread::sleep_until(next);
+  }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Frustum.hpp"
+#include "Scene.hpp"
+#include "Skeleton.hpp"
+#include "TrackFile.hpp"
+#include "TrackStream.hpp"
+#include "TripleBuffer.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct TrackParameters {
+  math137::Vector3f startPos;
+  math137::Vector3f endPos;
+  math137::Vector3f startEuler;
+  math137::Vector3f endEuler;
+  math137::Quaternion startQuat;
+  math137::Quaternion endQuat;
+  float duration;
+};
+
+struct PanelSnapshot {
+  uint32_t id;
+  InterpolationMethod method;
+  math137::Matrix4f model;
+  BoundingSphere track;
+  // null unless ghost frames are enabled, shared with the scene's cache
+  std::shared_ptr<const GhostSamples> ghosts;
+  // axis instances of the panel's rig, empty without one
+  std::vector<CursorInstance> skeleton;
+};
+
+struct SimulationSnapshot {
+  std::vector<PanelSnapshot> panels;
+  uint64_t tick;
+  // playhead of the first panel, they all play in lockstep
+  float time;
+  float duration;
+  bool streaming;
+  TrackStream::Stats stream;
+};
+
+// Advances every scene on its own thread. The UI talks to it through queued
+// commands applied at the start of a tick, the renderer reads the transforms
+// of the latest finished tick through a triple buffer. Without the thread
+// the owner drives it with advance, which makes runs reproducible.
+class Simulation {
+public:
+  Simulation(float tickRate = 240.0f, bool threaded = true);
+  ~Simulation();
+  Simulation(const Simulation &) = delete;
+  Simulation &operator=(const Simulation &) = delete;
+
+  void addPanel(InterpolationMethod method);
+  void removePanel(uint32_t id);
+  void setMethod(uint32_t id, InterpolationMethod method);
+  void setTrack(const TrackParameters &track);
+  // every panel plays the same track of the file, streamed through a chunk
+  // cache that lives until another track or start/end pair replaces it
+  void playTrack(std::shared_ptr<const TrackFile> file, size_t index);
+  void seek(float time);
+  void setGhostFrames(bool show, int intermediateFrames);
+  void setGhostSpacing(GhostSpacing spacing);
+  void setConstantSpeed(bool constantSpeed);
+  // memory each panel may spend on its arc length table
+  void setArcLengthBudget(size_t bytes);
+  // every panel carries a procedural rig of this many joints on its cursor,
+  // posed by the panel's method, 0 removes it
+  void setSkeleton(size_t joints);
+  inline void setTickRate(float tickRate) { m_tickRate.store(tickRate); }
+  inline float getTickRate() const { return m_tickRate.load(); }
+
+  // unthreaded only, runs every tick that fits into dt at the tick rate
+  void advance(double dt);
+
+  // render thread only, never blocks
+  const SimulationSnapshot &acquire();
+
+private:
+  struct Panel {
+    uint32_t id;
+    std::unique_ptr<Scene> scene;
+    std::unique_ptr<Skeleton> skeleton;
+  };
+
+  void enqueue(std::function<void()> command);
+  void applyCommands();
+  void publish();
+  void tick(float dt);
+  void run(std::stop_token stop);
+
+  // owned by the simulation thread once it runs
+  std::vector<Panel> m_panels;
+  uint32_t m_nextId{0};
+  std::shared_ptr<TrackStream> m_stream;
+  bool m_showGhosts{false};
+  int m_intermediateFrames{0};
+  GhostSpacing m_ghostSpacing{GhostSpacing::TIME};
+  bool m_constantSpeed{false};
+  size_t m_arcLengthSteps{ArcLengthTable::c_defaultSteps};
+  size_t m_skeletonJoints{0};
+  uint64_t m_tick{0};
+  double m_accumulator{0.0};
+
+  std::mutex m_commandMutex;
+  std::vector<std::function<void()>> m_commands;
+  std::vector<std::function<void()>> m_executing;
+
+  TripleBuffer<SimulationSnapshot> m_snapshots;
+  std::atomic<float> m_tickRate;
+  std::jthread m_thread;
+};
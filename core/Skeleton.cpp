@@ -0,0 +1,188 @@
+#include "Skeleton.hpp"
+#include "Random.hpp"
+#include "Rotation.hpp"
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace {
+// joints per chunk handed to a worker, smaller levels run on the caller
+constexpr size_t c_grain = 1024;
+constexpr uint32_t c_noParent = UINT32_MAX;
+
+// uniform in [-1, 1)
+float signedUnit(uint64_t &state) {
+  return static_cast<float>(Random::splitMix(state) >> 40) * 0x1.0p-23f - 1.0f;
+}
+
+// what the thread pool loops need, passed by pointer so the loop bodies
+// stay small enough for std::function to hold without allocating
+struct Evaluation {
+  float alpha;
+  InterpolationMethod method;
+  size_t first;
+  float root[16];
+};
+} // namespace
+
+Skeleton::Skeleton(std::span<const JointDesc> joints) {
+  size_t count = joints.size();
+  std::vector<uint32_t> depth(count);
+  uint32_t levels = 0;
+  for (size_t i = 0; i < count; ++i) {
+    int32_t parent = joints[i].parent;
+    if (parent >= static_cast<int32_t>(i) || parent < -1)
+      throw std::invalid_argument("Joint " + std::to_string(i) +
+                                  " does not follow its parent");
+    depth[i] = parent < 0 ? 0 : depth[parent] + 1;
+    levels = std::max(levels, depth[i] + 1);
+  }
+
+  // counting sort by depth, stable so siblings keep their order
+  m_levels.assign(levels + 1, 0);
+  for (uint32_t d : depth)
+    ++m_levels[d + 1];
+  for (uint32_t l = 0; l < levels; ++l)
+    m_levels[l + 1] += m_levels[l];
+  std::vector<uint32_t> next(m_levels.begin(), m_levels.end() - 1);
+  m_slot.resize(count);
+  for (size_t i = 0; i < count; ++i)
+    m_slot[i] = next[depth[i]]++;
+
+  m_parent.resize(count);
+  m_offset.resize(count * 3);
+  m_startEuler.resize(count * 3);
+  m_endEuler.resize(count * 3);
+  m_startQuat.resize(count * 4);
+  m_endQuat.resize(count * 4);
+  for (size_t i = 0; i < count; ++i) {
+    const JointDesc &joint = joints[i];
+    uint32_t s = m_slot[i];
+    m_parent[s] = joint.parent < 0 ? c_noParent : m_slot[joint.parent];
+    const math137::Vector3f *vectors[3] = {&joint.offset, &joint.startEuler, &joint.endEuler};
+    float *targets[3] = {&m_offset[s * 3], &m_startEuler[s * 3], &m_endEuler[s * 3]};
+    for (int v = 0; v < 3; ++v) {
+      targets[v][0] = vectors[v]->x();
+      targets[v][1] = vectors[v]->y();
+      targets[v][2] = vectors[v]->z();
+    }
+    const math137::Quaternion *quats[2] = {&joint.startQuat, &joint.endQuat};
+    float *quatTargets[2] = {&m_startQuat[s * 4], &m_endQuat[s * 4]};
+    for (int q = 0; q < 2; ++q) {
+      quatTargets[q][0] = quats[q]->a;
+      quatTargets[q][1] = quats[q]->b;
+      quatTargets[q][2] = quats[q]->c;
+      quatTargets[q][3] = quats[q]->d;
+    }
+  }
+
+  // sized once, evaluating never allocates
+  m_pose.resize(count * 4);
+  m_local.resize(count * 16);
+  m_world.resize(count * 16);
+  m_instances.resize(count * 3);
+}
+
+Skeleton Skeleton::procedural(size_t joints, uint64_t seed) {
+  // three children per joint, shorter bones further out
+  std::vector<JointDesc> descs(joints);
+  uint64_t state = seed;
+  std::vector<uint32_t> depth(joints, 0);
+  for (size_t i = 0; i < joints; ++i) {
+    JointDesc &joint = descs[i];
+    joint.parent = i == 0 ? -1 : static_cast<int32_t>((i - 1) / 3);
+    if (i > 0)
+      depth[i] = depth[joint.parent] + 1;
+    float length = i == 0 ? 0.0f : 0.6f * powf(0.7f, static_cast<float>(depth[i]));
+    joint.offset = {length * 0.4f * signedUnit(state), length, length * 0.4f * signedUnit(state)};
+    joint.startEuler = {0.6f * signedUnit(state), 0.6f * signedUnit(state),
+                        0.6f * signedUnit(state)};
+    joint.endEuler = {1.2f * signedUnit(state), 1.2f * signedUnit(state),
+                      1.2f * signedUnit(state)};
+    joint.startQuat = Rotation::eulerToQuaternion(joint.startEuler);
+    joint.endQuat = Rotation::eulerToQuaternion(joint.endEuler);
+  }
+  return Skeleton(descs);
+}
+
+void Skeleton::evaluate(float alpha, InterpolationMethod method, const math137::Matrix4f &root) {
+  evaluate(alpha, method, root, ThreadPool::shared());
+}
+
+void Skeleton::evaluate(float alpha, InterpolationMethod method, const math137::Matrix4f &root,
+                        ThreadPool &pool) {
+  Evaluation evaluation{alpha, method, 0, {}};
+  for (int r = 0; r < 4; ++r)
+    for (int c = 0; c < 4; ++c)
+      evaluation.root[r * 4 + c] = root.getValue(r, c);
+
+  const Evaluation *e = &evaluation;
+  pool.parallelFor(getJointCount(), c_grain, [this, e](size_t first, size_t last) {
+    evaluateLocal(first, last, e->alpha, e->method);
+  });
+  // every level only reads the ones before it
+  for (size_t level = 0; level + 1 < m_levels.size(); ++level) {
+    evaluation.first = m_levels[level];
+    pool.parallelFor(m_levels[level + 1] - m_levels[level], c_grain,
+                     [this, e](size_t first, size_t last) {
+                       evaluateLevel(e->first + first, e->first + last, e->root);
+                     });
+  }
+}
+
+void Skeleton::evaluateLocal(size_t first, size_t last, float alpha, InterpolationMethod method) {
+  size_t count = last - first;
+  std::span<float> local(&m_local[first * 16], count * 16);
+  if (method == InterpolationMethod::EULER) {
+    std::span<float> angles(&m_pose[first * 3], count * 3);
+    Rotation::eulerLerp(std::span(m_startEuler).subspan(first * 3, count * 3),
+                        std::span(m_endEuler).subspan(first * 3, count * 3), alpha, angles);
+    Rotation::eulerToMatrix(angles, local);
+  } else {
+    std::span<float> quats(&m_pose[first * 4], count * 4);
+    auto from = std::span(m_startQuat).subspan(first * 4, count * 4);
+    auto to = std::span(m_endQuat).subspan(first * 4, count * 4);
+    if (method == InterpolationMethod::LINEAR)
+      Rotation::nlerp(from, to, alpha, quats);
+    else
+      Rotation::slerp(from, to, alpha, quats);
+    Rotation::quaternionToMatrix(quats, local);
+  }
+  for (size_t j = first; j < last; ++j)
+    for (int r = 0; r < 3; ++r)
+      m_local[j * 16 + r * 4 + 3] = m_offset[j * 3 + r];
+}
+
+void Skeleton::evaluateLevel(size_t first, size_t last, const float *root) {
+  for (size_t j = first; j < last; ++j) {
+    uint32_t parent = m_parent[j];
+    Simd::multiplyMatrix(parent == c_noParent ? root : &m_world[parent * 16], &m_local[j * 16],
+                         &m_world[j * 16]);
+  }
+  // the local poses of these joints are used up, their slots take the
+  // world rotations
+  size_t count = last - first;
+  std::span<float> rotations(&m_pose[first * 4], count * 4);
+  Rotation::matrixToQuaternion(std::span(m_world).subspan(first * 16, count * 16), rotations);
+  for (size_t j = first; j < last; ++j)
+    Cursor::writeInstances(&m_world[j * 16], &m_pose[j * 4], 0, &m_instances[j * 3]);
+}
+
+math137::Matrix4f Skeleton::getWorld(uint32_t slot) const {
+  math137::Matrix4f world;
+  for (int r = 0; r < 4; ++r)
+    for (int c = 0; c < 4; ++c)
+      world.setValue(r, c, m_world[slot * 16 + r * 4 + c]);
+  return world;
+}
+
+void Skeleton::appendInstances(int viewport, std::vector<CursorInstance> &instances) const {
+  size_t first = instances.size();
+  instances.insert(instances.end(), m_instances.begin(), m_instances.end());
+  if (viewport != 0)
+    for (size_t i = first; i < instances.size(); ++i)
+      instances[i].viewport = viewport;
+}
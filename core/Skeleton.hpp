@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Cursor.hpp"
+#include "Scene.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+// a joint as described, its parent must come before it
+struct JointDesc {
+  // index of the parent joint, -1 for a root
+  int32_t parent;
+  // origin in the parent's frame
+  math137::Vector3f offset;
+  // local rotation track, played like a panel's start/end pair
+  math137::Vector3f startEuler;
+  math137::Vector3f endEuler;
+  math137::Quaternion startQuat;
+  math137::Quaternion endQuat;
+};
+
+// A rig of cursor gizmos. Joints are stored as arrays per attribute, sorted
+// by depth so every level is a contiguous range whose parents are all in
+// the levels before it. Evaluating interpolates every local rotation in one
+// batch, then composes the world matrices a level at a time, each level
+// split over the shared thread pool, and every chunk packs the axis
+// instances of its joints as soon as their matrices are done.
+class Skeleton {
+public:
+  Skeleton() = default;
+  explicit Skeleton(std::span<const JointDesc> joints);
+
+  // a tree of the given size branching from one root, for the benchmark and
+  // the demo rig
+  static Skeleton procedural(size_t joints, uint64_t seed = 137);
+
+  // places the roots with root, alpha runs from the start to the end of
+  // every joint's track
+  void evaluate(float alpha, InterpolationMethod method, const math137::Matrix4f &root);
+  // the same on a given pool, for measuring thread counts
+  void evaluate(float alpha, InterpolationMethod method, const math137::Matrix4f &root,
+                ThreadPool &pool);
+  // the axis instances of every joint as last evaluated, a copy
+  void appendInstances(int viewport, std::vector<CursorInstance> &instances) const;
+  // three per joint in the stored order, for viewport 0
+  inline std::span<const CursorInstance> getInstances() const { return m_instances; }
+
+  inline size_t getJointCount() const { return m_parent.size(); }
+  inline size_t getLevelCount() const { return m_levels.empty() ? 0 : m_levels.size() - 1; }
+  // position of a described joint in the stored order
+  inline uint32_t getSlot(size_t joint) const { return m_slot[joint]; }
+  // row-major, 16 floats per joint in the stored order
+  inline std::span<const float> getWorld() const { return m_world; }
+  math137::Matrix4f getWorld(uint32_t slot) const;
+
+private:
+  void evaluateLocal(size_t first, size_t last, float alpha, InterpolationMethod method);
+  void evaluateLevel(size_t first, size_t last, const float *root);
+
+  // stored order, parent slots precede their children
+  std::vector<uint32_t> m_parent;
+  std::vector<uint32_t> m_slot;
+  // first slot of every level, then the joint count
+  std::vector<uint32_t> m_levels;
+  // packed per joint: 3 offset floats, 3 angles, 4 quaternion components
+  std::vector<float> m_offset;
+  std::vector<float> m_startEuler;
+  std::vector<float> m_endEuler;
+  std::vector<float> m_startQuat;
+  std::vector<float> m_endQuat;
+
+  // evaluation scratch and results, m_pose holds the local poses and then
+  // the world rotations the instances are packed from
+  std::vector<float> m_pose;
+  std::vector<float> m_local;
+  std::vector<float> m_world;
+  std::vector<CursorInstance> m_instances;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// Capacity must be a power of two, one slot is kept free to tell full from
+// empty.
+template <typename T, size_t Capacity> class SpscQueue {
+  static_assert((Capacity & (Capacity - 1)) == 0,
+                "capacity must be a power of two");
+
+public:
+  // returns false and drops the value when the queue is full
+  inline bool push(const T &value) {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    size_t next = (head + 1) & (Capacity - 1);
+    if (next == m_tail.load(std::memory_order_acquire))
+      return false;
+    m_slots[head] = value;
+    m_head.store(next, std::memory_order_release);
+    return true;
+  }
+
+  inline bool pop(T &value) {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire))
+      return false;
+    value = m_slots[tail];
+    m_tail.store((tail + 1) & (Capacity - 1), std::memory_order_release);
+    return true;
+  }
+
+private:
+  std::array<T, Capacity> m_slots;
+  alignas(64) std::atomic<size_t> m_head{0};
+  alignas(64) std::atomic<size_t> m_tail{0};
+};
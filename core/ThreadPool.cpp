@@ -0,0 +1,92 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <utility>
+
+ThreadPool::ThreadPool(unsigned workers) {
+  m_workers.reserve(workers);
+  for (unsigned i = 0; i < workers; ++i)
+    m_workers.emplace_back([this](std::stop_token stop) { work(stop); });
+}
+
+ThreadPool::~ThreadPool() {
+  for (std::jthread &worker : m_workers)
+    worker.request_stop();
+}
+
+ThreadPool &ThreadPool::shared() {
+  static ThreadPool pool;
+  return pool;
+}
+
+unsigned ThreadPool::defaultWorkers() {
+  return std::max(std::thread::hardware_concurrency(), 1u) - 1;
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain,
+                             const std::function<void(size_t, size_t)> &body) {
+  grain = std::max<size_t>(grain, 1);
+  size_t chunks = (count + grain - 1) / grain;
+  if (chunks <= 1 || m_workers.empty()) {
+    for (size_t begin = 0; begin < count; begin += grain)
+      body(begin, std::min(begin + grain, count));
+    return;
+  }
+
+  std::lock_guard submit(m_submitMutex);
+  {
+    // a worker that woke up late for the previous loop may still be
+    // looking at its state
+    std::unique_lock lock(m_mutex);
+    m_finished.wait(lock, [this] { return m_active == 0; });
+    m_body = &body;
+    m_count = count;
+    m_grain = grain;
+    m_chunks = chunks;
+    m_chunksDone = 0;
+    m_error = nullptr;
+    m_next.store(0, std::memory_order_relaxed);
+    ++m_generation;
+  }
+  m_wake.notify_all();
+
+  size_t done = runChunks();
+  std::unique_lock lock(m_mutex);
+  m_chunksDone += done;
+  m_finished.wait(lock, [this] { return m_chunksDone == m_chunks && m_active == 0; });
+  m_body = nullptr;
+  if (m_error)
+    std::rethrow_exception(std::exchange(m_error, nullptr));
+}
+
+size_t ThreadPool::runChunks() {
+  size_t done = 0;
+  for (;;) {
+    size_t chunk = m_next.fetch_add(1, std::memory_order_relaxed);
+    if (chunk >= m_chunks)
+      return done;
+    size_t begin = chunk * m_grain;
+    try {
+      (*m_body)(begin, std::min(begin + m_grain, m_count));
+    } catch (...) {
+      std::lock_guard lock(m_mutex);
+      if (!m_error)
+        m_error = std::current_exception();
+    }
+    ++done;
+  }
+}
+
+void ThreadPool::work(std::stop_token stop) {
+  std::unique_lock lock(m_mutex);
+  uint64_t seen = m_generation;
+  while (m_wake.wait(lock, stop, [&] { return m_generation != seen; })) {
+    seen = m_generation;
+    ++m_active;
+    lock.unlock();
+    size_t done = runChunks();
+    lock.lock();
+    m_chunksDone += done;
+    --m_active;
+    m_finished.notify_all();
+  }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of workers for data parallel loops. parallelFor splits a range
+// into chunks, runs them on the workers and the calling thread and returns
+// once all are done, so callers keep plain sequential ownership of their
+// data. One loop runs at a time, concurrent callers wait their turn, so a
+// body must not start another loop.
+class ThreadPool {
+public:
+  // one thread less than the hardware has, the caller works too
+  explicit ThreadPool(unsigned workers = defaultWorkers());
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // created on first use and shared by everything in the process
+  static ThreadPool &shared();
+  static unsigned defaultWorkers();
+
+  // workers plus the calling thread
+  inline unsigned getThreadCount() const {
+    return static_cast<unsigned>(m_workers.size()) + 1;
+  }
+
+  // runs body(begin, end) over [0, count) in chunks of at most grain
+  // elements, the first exception a chunk throws is rethrown here
+  void parallelFor(size_t count, size_t grain,
+                   const std::function<void(size_t, size_t)> &body);
+
+private:
+  void work(std::stop_token stop);
+  size_t runChunks();
+
+  std::mutex m_submitMutex;
+  std::mutex m_mutex;
+  std::condition_variable_any m_wake;
+  std::condition_variable m_finished;
+  // the current loop, written under m_mutex while no worker is active
+  const std::function<void(size_t, size_t)> *m_body{nullptr};
+  size_t m_count{0};
+  size_t m_grain{1};
+  size_t m_chunks{0};
+  std::atomic<size_t> m_next{0};
+  size_t m_chunksDone{0};
+  unsigned m_active{0};
+  uint64_t m_generation{0};
+  std::exception_ptr m_error;
+  std::vector<std::jthread> m_workers;
+};
@@ -0,0 +1,327 @@
+#include "TrackFile.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+TrackFile::TrackFile(const std::string &path) {
+  map(path);
+  try {
+    validate();
+  } catch (...) {
+    unmap();
+    throw;
+  }
+}
+
+TrackFile::~TrackFile() { unmap(); }
+
+TrackView TrackFile::getTrack(size_t index) const {
+  if (index >= getTrackCount())
+    throw std::out_of_range("Track index out of range");
+  const IndexEntry &entry = m_index[index];
+  auto keys = reinterpret_cast<const Keyframe *>(m_data + entry.keyOffset);
+  std::span<const TrackChunk> chunks;
+  if (m_upgradedChunks.empty())
+    chunks = {reinterpret_cast<const TrackChunk *>(m_data + entry.chunkOffset),
+              entry.chunkCount};
+  else
+    chunks = m_upgradedChunks[index];
+  return {std::string_view(entry.name, strnlen(entry.name, sizeof(entry.name))),
+          {keys, entry.keyCount},
+          chunks,
+          entry.duration,
+          {{entry.boundsCenter[0], entry.boundsCenter[1], entry.boundsCenter[2]},
+           entry.boundsRadius}};
+}
+
+void TrackFile::map(const std::string &path) {
+#ifdef _WIN32
+  m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                       OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+  if (m_file == INVALID_HANDLE_VALUE) {
+    m_file = nullptr;
+    throw std::runtime_error("Failed to open track file " + path);
+  }
+  LARGE_INTEGER size;
+  GetFileSizeEx(m_file, &size);
+  m_size = static_cast<size_t>(size.QuadPart);
+  if (m_size < sizeof(Header)) {
+    unmap();
+    throw std::runtime_error("Track file too small " + path);
+  }
+  m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (m_mapping)
+    m_data = static_cast<const std::byte *>(
+        MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+  if (!m_data) {
+    unmap();
+    throw std::runtime_error("Failed to map track file " + path);
+  }
+  SYSTEM_INFO system;
+  GetSystemInfo(&system);
+  m_pageSize = system.dwPageSize;
+#else
+  m_fd = open(path.c_str(), O_RDONLY);
+  if (m_fd < 0)
+    throw std::runtime_error("Failed to open track file " + path);
+  struct stat info;
+  if (fstat(m_fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < sizeof(Header)) {
+    unmap();
+    throw std::runtime_error("Track file too small " + path);
+  }
+  m_size = static_cast<size_t>(info.st_size);
+  m_pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+  if (data == MAP_FAILED) {
+    unmap();
+    throw std::runtime_error("Failed to map track file " + path);
+  }
+  m_data = static_cast<const std::byte *>(data);
+  // playback jumps between tracks, read-ahead would only inflate residency
+  madvise(data, m_size, MADV_RANDOM);
+#endif
+  m_header = reinterpret_cast<const Header *>(m_data);
+}
+
+void TrackFile::unmap() {
+#ifdef _WIN32
+  if (m_data)
+    UnmapViewOfFile(m_data);
+  if (m_mapping)
+    CloseHandle(m_mapping);
+  if (m_file)
+    CloseHandle(m_file);
+  m_mapping = m_file = nullptr;
+#else
+  if (m_data)
+    munmap(const_cast<std::byte *>(m_data), m_size);
+  if (m_fd >= 0)
+    close(m_fd);
+  m_fd = -1;
+#endif
+  m_data = nullptr;
+  m_header = nullptr;
+  m_index = nullptr;
+}
+
+void TrackFile::prefetch(const void *begin, size_t size) const {
+  size_t offset = static_cast<size_t>(static_cast<const std::byte *>(begin) - m_data);
+  size_t first = offset / m_pageSize * m_pageSize;
+  size_t last = std::min(offset + size, m_size);
+#ifdef _WIN32
+  // no portable read-ahead hint, the caller touches the pages anyway
+  (void)first;
+  (void)last;
+#else
+  madvise(const_cast<std::byte *>(m_data) + first, last - first, MADV_WILLNEED);
+#endif
+}
+
+void TrackFile::release(const void *begin, size_t size) const {
+  size_t offset = static_cast<size_t>(static_cast<const std::byte *>(begin) - m_data);
+  size_t first = (offset + m_pageSize - 1) / m_pageSize * m_pageSize;
+  size_t last = (offset + size) / m_pageSize * m_pageSize;
+  if (last <= first)
+    return;
+#ifdef _WIN32
+  // unlocking pages that were never locked drops them from the working set
+  VirtualUnlock(const_cast<std::byte *>(m_data) + first, last - first);
+#else
+  // the mapping is read-only, so dropped pages are simply read again, and
+  // the page cache copy goes too or residency would only move there
+  madvise(const_cast<std::byte *>(m_data) + first, last - first, MADV_DONTNEED);
+  posix_fadvise(m_fd, static_cast<off_t>(first), static_cast<off_t>(last - first),
+                POSIX_FADV_DONTNEED);
+#endif
+}
+
+void TrackFile::validate() {
+  if (std::memcmp(m_header->magic, c_magic, sizeof(c_magic)) != 0)
+    throw std::runtime_error("Not a track file");
+  uint32_t version = m_header->version;
+  if (version != 1 && version != c_version)
+    throw std::runtime_error("Unsupported track file version " +
+                             std::to_string(version));
+  size_t entrySize = version == 1 ? sizeof(IndexEntryV1) : sizeof(IndexEntry);
+  if (m_header->fileSize != m_size || m_header->indexOffset % c_alignment ||
+      m_header->indexOffset > m_size ||
+      (m_size - m_header->indexOffset) / entrySize < m_header->trackCount)
+    throw std::runtime_error("Corrupt track file index");
+
+  if (version == 1) {
+    auto legacy =
+        reinterpret_cast<const IndexEntryV1 *>(m_data + m_header->indexOffset);
+    m_upgradedIndex.resize(m_header->trackCount);
+    for (uint32_t i = 0; i < m_header->trackCount; ++i) {
+      IndexEntry &entry = m_upgradedIndex[i];
+      std::memset(&entry, 0, sizeof(entry));
+      std::memcpy(entry.name, legacy[i].name, sizeof(entry.name));
+      entry.keyOffset = legacy[i].keyOffset;
+      entry.keyCount = legacy[i].keyCount;
+      entry.duration = legacy[i].duration;
+      std::memcpy(entry.boundsCenter, legacy[i].boundsCenter,
+                  sizeof(entry.boundsCenter));
+      entry.boundsRadius = legacy[i].boundsRadius;
+    }
+    m_index = m_upgradedIndex.data();
+  } else {
+    m_index =
+        reinterpret_cast<const IndexEntry *>(m_data + m_header->indexOffset);
+  }
+
+  for (uint32_t i = 0; i < m_header->trackCount; ++i) {
+    const IndexEntry &entry = m_index[i];
+    if (entry.keyOffset % c_alignment || entry.keyOffset > m_size ||
+        (m_size - entry.keyOffset) / sizeof(Keyframe) < entry.keyCount)
+      throw std::runtime_error("Corrupt track " + std::to_string(i));
+    if (version == 1) {
+      // reads only the boundary keys, a page per chunk
+      auto keys = reinterpret_cast<const Keyframe *>(m_data + entry.keyOffset);
+      m_upgradedChunks.push_back(buildChunks({keys, entry.keyCount}, c_chunkKeys));
+      continue;
+    }
+    if (entry.chunkOffset % c_alignment || entry.chunkOffset > m_size ||
+        (m_size - entry.chunkOffset) / sizeof(TrackChunk) < entry.chunkCount ||
+        (entry.keyCount == 0) != (entry.chunkCount == 0))
+      throw std::runtime_error("Corrupt track " + std::to_string(i));
+    // as buildChunks lays them out: in order, neighbours sharing their boundary
+    // key and time, the last one ending on the last key. Whether the times match
+    // the keys is checked by TrackStream as it loads each chunk
+    auto chunks = reinterpret_cast<const TrackChunk *>(m_data + entry.chunkOffset);
+    for (uint32_t c = 0; c < entry.chunkCount; ++c) {
+      const TrackChunk &chunk = chunks[c];
+      bool single = entry.keyCount == 1;
+      if (chunk.keyCount < (single ? 1u : 2u) || chunk.firstKey >= entry.keyCount ||
+          entry.keyCount - chunk.firstKey < chunk.keyCount ||
+          !(single ? chunk.startTime == chunk.endTime : chunk.startTime < chunk.endTime))
+        throw std::runtime_error("Corrupt track " + std::to_string(i));
+      if (c == 0 ? chunk.firstKey != 0
+                 : chunk.firstKey != chunks[c - 1].firstKey + chunks[c - 1].keyCount - 1 ||
+                       chunk.startTime != chunks[c - 1].endTime)
+        throw std::runtime_error("Corrupt track " + std::to_string(i));
+    }
+    if (entry.chunkCount > 0) {
+      const TrackChunk &last = chunks[entry.chunkCount - 1];
+      if (last.firstKey + last.keyCount != entry.keyCount || last.endTime != entry.duration)
+        throw std::runtime_error("Corrupt track " + std::to_string(i));
+    }
+  }
+}
+
+std::vector<TrackChunk> TrackFile::buildChunks(std::span<const Keyframe> keys,
+                                               uint32_t chunkKeys) {
+  // a chunk needs at least one segment
+  chunkKeys = std::max(chunkKeys, 2u);
+  std::vector<TrackChunk> chunks;
+  uint32_t count = static_cast<uint32_t>(keys.size());
+  for (uint32_t first = 0; first < count;) {
+    uint32_t size = std::min(chunkKeys, count - first);
+    chunks.push_back({keys[first].time, keys[first + size - 1].time, first, size});
+    if (first + size == count)
+      break;
+    first += size - 1;
+  }
+  return chunks;
+}
+
+void TrackFile::save(const std::string &path, std::span<const TrackData> tracks,
+                     uint32_t chunkKeys) {
+  auto align = [](uint64_t offset) {
+    return (offset + c_alignment - 1) / c_alignment * c_alignment;
+  };
+
+  // keyframes first, then the chunk tables and the index, so tracks can be
+  // written in one pass
+  std::vector<IndexEntry> index(tracks.size());
+  std::vector<std::vector<TrackChunk>> chunks(tracks.size());
+  uint64_t offset = align(sizeof(Header));
+  for (size_t i = 0; i < tracks.size(); ++i) {
+    const TrackData &track = tracks[i];
+    // playback binary searches the key times, written so a NaN fails too
+    for (size_t k = 1; k < track.keys.size(); ++k)
+      if (!(track.keys[k].time > track.keys[k - 1].time))
+        throw std::invalid_argument("Key times of track " + track.name +
+                                    " do not strictly increase");
+    IndexEntry &entry = index[i];
+    std::memset(&entry, 0, sizeof(entry));
+    std::memcpy(entry.name, track.name.data(),
+                std::min(track.name.size(), sizeof(entry.name) - 1));
+    entry.keyOffset = offset;
+    entry.keyCount = static_cast<uint32_t>(track.keys.size());
+    entry.duration = track.keys.empty() ? 0.0f : track.keys.back().time;
+
+    // bounding box center and the farthest key from it
+    float lo[3] = {INFINITY, INFINITY, INFINITY};
+    float hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (const Keyframe &key : track.keys)
+      for (int c = 0; c < 3; ++c) {
+        lo[c] = std::min(lo[c], key.position[c]);
+        hi[c] = std::max(hi[c], key.position[c]);
+      }
+    float radius = 0.0f;
+    for (int c = 0; c < 3 && !track.keys.empty(); ++c)
+      entry.boundsCenter[c] = 0.5f * (lo[c] + hi[c]);
+    for (const Keyframe &key : track.keys) {
+      float dx = key.position[0] - entry.boundsCenter[0];
+      float dy = key.position[1] - entry.boundsCenter[1];
+      float dz = key.position[2] - entry.boundsCenter[2];
+      radius = std::max(radius, sqrtf(dx * dx + dy * dy + dz * dz));
+    }
+    entry.boundsRadius = radius;
+
+    offset = align(offset + track.keys.size() * sizeof(Keyframe));
+  }
+  for (size_t i = 0; i < tracks.size(); ++i) {
+    chunks[i] = buildChunks(tracks[i].keys, chunkKeys);
+    index[i].chunkOffset = offset;
+    index[i].chunkCount = static_cast<uint32_t>(chunks[i].size());
+    offset = align(offset + chunks[i].size() * sizeof(TrackChunk));
+  }
+
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, c_magic, sizeof(c_magic));
+  header.version = c_version;
+  header.trackCount = static_cast<uint32_t>(tracks.size());
+  header.indexOffset = offset;
+  header.fileSize = offset + index.size() * sizeof(IndexEntry);
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file)
+    throw std::runtime_error("Failed to create track file " + path);
+  auto pad = [&file]() {
+    static const char zeros[c_alignment] = {};
+    uint64_t position = static_cast<uint64_t>(file.tellp());
+    file.write(zeros, (c_alignment - position % c_alignment) % c_alignment);
+  };
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  pad();
+  for (const TrackData &track : tracks) {
+    file.write(reinterpret_cast<const char *>(track.keys.data()),
+               track.keys.size() * sizeof(Keyframe));
+    pad();
+  }
+  for (const std::vector<TrackChunk> &table : chunks) {
+    file.write(reinterpret_cast<const char *>(table.data()),
+               table.size() * sizeof(TrackChunk));
+    pad();
+  }
+  file.write(reinterpret_cast<const char *>(index.data()),
+             index.size() * sizeof(IndexEntry));
+  if (!file)
+    throw std::runtime_error("Failed to write track file " + path);
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Frustum.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One pose of a track. Both rotation forms are stored so quaternion and
+// Euler panels can play the same data.
+struct Keyframe {
+  float time;
+  float position[3];
+  // a, b, c, d as in math137::Quaternion
+  float quaternion[4];
+  float euler[3];
+  float padding;
+};
+static_assert(sizeof(Keyframe) == 48);
+
+// A run of keys covering [startTime, endTime]. Consecutive chunks share
+// their boundary key so every segment can be evaluated from one chunk.
+struct TrackChunk {
+  float startTime;
+  float endTime;
+  uint32_t firstKey;
+  uint32_t keyCount;
+};
+static_assert(sizeof(TrackChunk) == 16);
+
+// Points straight into the mapped file, valid while the TrackFile lives.
+struct TrackView {
+  std::string_view name;
+  std::span<const Keyframe> keys;
+  std::span<const TrackChunk> chunks;
+  float duration;
+  BoundingSphere bounds;
+};
+
+// Input for TrackFile::save.
+struct TrackData {
+  std::string name;
+  std::vector<Keyframe> keys;
+};
+
+// Read-only, memory mapped animation file. Layout, little endian, every
+// section aligned to c_alignment bytes:
+//   Header
+//   IndexEntry[trackCount] at Header::indexOffset
+//   Keyframe[keyCount] per track at IndexEntry::keyOffset
+//   TrackChunk[chunkCount] per track at IndexEntry::chunkOffset
+// Opening maps the file and validates the index only, keyframes are paged
+// in by the OS as tracks are played and their order is checked by
+// TrackStream a chunk at a time. Version 1 files have no chunk tables,
+// theirs are built from the boundary keys when the file is opened.
+class TrackFile {
+public:
+  static constexpr uint32_t c_version = 2;
+  static constexpr size_t c_alignment = 64;
+  // 192 KiB of keys per chunk
+  static constexpr uint32_t c_chunkKeys = 4096;
+
+  explicit TrackFile(const std::string &path);
+  ~TrackFile();
+  TrackFile(const TrackFile &) = delete;
+  TrackFile &operator=(const TrackFile &) = delete;
+
+  inline size_t getTrackCount() const { return m_header->trackCount; }
+  TrackView getTrack(size_t index) const;
+
+  // paging hints for streaming, prefetch widens the range to whole pages,
+  // release only drops the pages that lie entirely inside it
+  void prefetch(const void *begin, size_t size) const;
+  void release(const void *begin, size_t size) const;
+
+  // throws std::invalid_argument unless the key times of every track strictly
+  // increase
+  static void save(const std::string &path, std::span<const TrackData> tracks,
+                   uint32_t chunkKeys = c_chunkKeys);
+  static std::vector<TrackChunk> buildChunks(std::span<const Keyframe> keys,
+                                             uint32_t chunkKeys);
+
+private:
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t trackCount;
+    uint64_t indexOffset;
+    uint64_t fileSize;
+    uint8_t reserved[32];
+  };
+  static_assert(sizeof(Header) == 64);
+
+  struct IndexEntry {
+    char name[32];
+    uint64_t keyOffset;
+    uint64_t chunkOffset;
+    uint32_t keyCount;
+    uint32_t chunkCount;
+    float duration;
+    float boundsCenter[3];
+    float boundsRadius;
+    uint32_t reserved;
+  };
+  static_assert(sizeof(IndexEntry) == 80);
+
+  struct IndexEntryV1 {
+    char name[32];
+    uint64_t keyOffset;
+    uint32_t keyCount;
+    float duration;
+    float boundsCenter[3];
+    float boundsRadius;
+  };
+  static_assert(sizeof(IndexEntryV1) == 64);
+
+  static constexpr char c_magic[8] = {'I', '1', '3', '7', 'T', 'R', 'K', '\0'};
+
+  void map(const std::string &path);
+  void unmap();
+  void validate();
+
+  const std::byte *m_data{nullptr};
+  size_t m_size{0};
+  const Header *m_header{nullptr};
+  const IndexEntry *m_index{nullptr};
+  // only used for version 1 files
+  std::vector<IndexEntry> m_upgradedIndex;
+  std::vector<std::vector<TrackChunk>> m_upgradedChunks;
+  size_t m_pageSize{4096};
+#ifdef _WIN32
+  void *m_file{nullptr};
+  void *m_mapping{nullptr};
+#else
+  int m_fd{-1};
+#endif
+};
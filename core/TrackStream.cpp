@@ -0,0 +1,164 @@
+#include "TrackStream.hpp"
+#include <algorithm>
+
+namespace {
+// one read per page is enough to fault a chunk in, smaller than any page size
+constexpr size_t c_touchStride = 4096;
+} // namespace
+
+TrackStream::TrackStream(std::shared_ptr<const TrackFile> file, size_t index,
+                         size_t capacity)
+    : m_file(std::move(file)), m_track(m_file->getTrack(index)),
+      m_chunks(m_track.chunks.begin(), m_track.chunks.end()),
+      m_capacity(std::max<size_t>(capacity, 4)), m_readAhead(m_capacity / 4),
+      m_ready(std::make_unique<std::atomic<bool>[]>(m_chunks.size())),
+      m_lastUse(m_chunks.size(), 0), m_rejected(m_chunks.size(), false) {
+  m_resident.reserve(m_capacity);
+  // the first pass loads the start of the track without waiting for a reader
+  m_generation.store(1);
+  m_thread = std::jthread([this](std::stop_token stop) { run(stop); });
+}
+
+TrackStream::~TrackStream() {
+  m_thread.request_stop();
+  m_thread.join();
+  for (size_t chunk : m_resident) {
+    std::span<const Keyframe> keys = keysOf(chunk);
+    m_file->release(keys.data(), keys.size_bytes());
+  }
+}
+
+void TrackStream::setPlayhead(float time) {
+  if (m_chunks.empty())
+    return;
+  size_t chunk = chunkAt(time);
+  if (chunk == m_target.load(std::memory_order_relaxed))
+    return;
+  m_target.store(chunk);
+  {
+    std::lock_guard lock(m_mutex);
+    m_generation.fetch_add(1);
+  }
+  m_wake.notify_one();
+}
+
+std::span<const Keyframe> TrackStream::find(float time, size_t &chunk) {
+  if (m_chunks.empty())
+    return {};
+  chunk = chunkAt(time);
+  if (!m_ready[chunk].load(std::memory_order_acquire)) {
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return {};
+  }
+  return keysOf(chunk);
+}
+
+TrackStream::Stats TrackStream::getStats() const {
+  return {m_residentCount.load(std::memory_order_relaxed), m_capacity,
+          m_loads.load(std::memory_order_relaxed),
+          m_evictions.load(std::memory_order_relaxed),
+          m_misses.load(std::memory_order_relaxed),
+          m_rejectedCount.load(std::memory_order_relaxed)};
+}
+
+size_t TrackStream::chunkAt(float time) const {
+  auto it = std::upper_bound(
+      m_chunks.begin(), m_chunks.end(), time,
+      [](float t, const TrackChunk &chunk) { return t < chunk.startTime; });
+  return it == m_chunks.begin() ? 0 : static_cast<size_t>(it - m_chunks.begin()) - 1;
+}
+
+std::span<const Keyframe> TrackStream::keysOf(size_t chunk) const {
+  return m_track.keys.subspan(m_chunks[chunk].firstKey, m_chunks[chunk].keyCount);
+}
+
+void TrackStream::run(std::stop_token stop) {
+  while (!stop.stop_requested()) {
+    uint64_t generation;
+    {
+      std::unique_lock lock(m_mutex);
+      if (!m_wake.wait(lock, stop,
+                       [this] { return m_generation.load() != m_serviced; }))
+        return;
+      generation = m_serviced = m_generation.load();
+    }
+    size_t target = m_target.load();
+
+    auto visit = [&](size_t chunk) {
+      if (chunk >= m_chunks.size())
+        return;
+      m_lastUse[chunk] = ++m_clock;
+      if (m_ready[chunk].load(std::memory_order_relaxed) || m_rejected[chunk])
+        return;
+      while (m_resident.size() >= m_capacity && evict(target))
+        ;
+      load(chunk);
+    };
+    // the chunk under the playhead first, then ahead of it with one chunk
+    // behind for scrubbing back, restarting as soon as the playhead moves on
+    visit(target);
+    for (size_t step = 1; step <= m_readAhead; ++step) {
+      if (m_generation.load() != generation || stop.stop_requested())
+        break;
+      visit(target + step);
+      if (step == 1)
+        visit(target - 1);
+    }
+  }
+}
+
+void TrackStream::load(size_t chunk) {
+  std::span<const Keyframe> keys = keysOf(chunk);
+  m_file->prefetch(keys.data(), keys.size_bytes());
+  // the hint is asynchronous, reading every page makes sure the chunk is in
+  // memory before readers are let in
+  auto bytes = reinterpret_cast<const volatile std::byte *>(keys.data());
+  for (size_t offset = 0; offset < keys.size_bytes(); offset += c_touchStride)
+    (void)bytes[offset];
+  (void)bytes[keys.size_bytes() - 1];
+
+  // sampling binary searches the chunk table and then the key times, a chunk
+  // that disagrees with its table entry or is out of order stays a miss
+  // instead of playing the wrong keys, written so a NaN fails too
+  bool valid = keys.front().time == m_chunks[chunk].startTime &&
+               keys.back().time == m_chunks[chunk].endTime;
+  for (size_t k = 1; valid && k < keys.size(); ++k)
+    valid = keys[k].time > keys[k - 1].time;
+  if (!valid) {
+    m_rejected[chunk] = true;
+    m_rejectedCount.fetch_add(1, std::memory_order_relaxed);
+    m_file->release(keys.data(), keys.size_bytes());
+    return;
+  }
+
+  m_resident.push_back(chunk);
+  m_residentCount.store(m_resident.size(), std::memory_order_relaxed);
+  m_loads.fetch_add(1, std::memory_order_relaxed);
+  m_ready[chunk].store(true, std::memory_order_release);
+}
+
+bool TrackStream::evict(size_t target) {
+  // least recently used chunk outside the window being read
+  auto victim = m_resident.end();
+  for (auto it = m_resident.begin(); it != m_resident.end(); ++it) {
+    size_t chunk = *it;
+    if (chunk + 1 >= target && chunk <= target + m_readAhead)
+      continue;
+    if (victim == m_resident.end() || m_lastUse[chunk] < m_lastUse[*victim])
+      victim = it;
+  }
+  if (victim == m_resident.end())
+    return false;
+
+  size_t chunk = *victim;
+  m_ready[chunk].store(false, std::memory_order_release);
+  // the boundary keys are shared with the neighbouring chunks
+  std::span<const Keyframe> keys = keysOf(chunk);
+  if (keys.size() > 2)
+    m_file->release(keys.data() + 1, (keys.size() - 2) * sizeof(Keyframe));
+  *victim = m_resident.back();
+  m_resident.pop_back();
+  m_residentCount.store(m_resident.size(), std::memory_order_relaxed);
+  m_evictions.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
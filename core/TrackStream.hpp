@@ -0,0 +1,77 @@
+#pragma once
+
+#include "TrackFile.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Plays one track of a file without ever holding more than a fixed number
+// of its chunks in memory. A prefetch thread pages in the chunks ahead of
+// the playhead, or around it after a seek, and releases the least recently
+// used ones once over budget. Readers only see chunks that are resident, so
+// a slow disk shows up as a held pose rather than a stalled frame.
+class TrackStream {
+public:
+  static constexpr size_t c_defaultCapacity = 32;
+
+  struct Stats {
+    size_t resident;
+    size_t capacity;
+    uint64_t loads;
+    uint64_t evictions;
+    uint64_t misses;
+    // chunks whose key times do not strictly increase, never played
+    uint64_t rejected;
+  };
+
+  TrackStream(std::shared_ptr<const TrackFile> file, size_t index,
+              size_t capacity = c_defaultCapacity);
+  ~TrackStream();
+  TrackStream(const TrackStream &) = delete;
+  TrackStream &operator=(const TrackStream &) = delete;
+
+  inline const TrackView &getTrack() const { return m_track; }
+  // wakes the prefetcher only when the playhead enters another chunk
+  void setPlayhead(float time);
+  // keys of the chunk covering time, empty while it is still being read
+  std::span<const Keyframe> find(float time, size_t &chunk);
+  Stats getStats() const;
+
+private:
+  size_t chunkAt(float time) const;
+  std::span<const Keyframe> keysOf(size_t chunk) const;
+  void run(std::stop_token stop);
+  void load(size_t chunk);
+  bool evict(size_t target);
+
+  std::shared_ptr<const TrackFile> m_file;
+  TrackView m_track;
+  // copied so looking up a chunk never touches the mapping
+  std::vector<TrackChunk> m_chunks;
+  size_t m_capacity;
+  size_t m_readAhead;
+  std::unique_ptr<std::atomic<bool>[]> m_ready;
+
+  // owned by the prefetch thread
+  std::vector<size_t> m_resident;
+  std::vector<uint64_t> m_lastUse;
+  std::vector<bool> m_rejected;
+  uint64_t m_clock{0};
+
+  std::atomic<size_t> m_target{0};
+  std::atomic<uint64_t> m_generation{0};
+  std::atomic<size_t> m_residentCount{0};
+  std::atomic<uint64_t> m_loads{0};
+  std::atomic<uint64_t> m_evictions{0};
+  std::atomic<uint64_t> m_misses{0};
+  std::atomic<uint64_t> m_rejectedCount{0};
+  std::mutex m_mutex;
+  std::condition_variable_any m_wake;
+  uint64_t m_serviced{0};
+  std::jthread m_thread;
+};
@@ -0,0 +1,102 @@
+#include "Trail.hpp"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// below this a point would only repeat the last one
+constexpr float c_minStep = 1e-4f;
+} // namespace
+
+Trail::Trail(uint32_t capacity) : m_capacity(std::max(capacity, 2u)) {
+  glCreateBuffers(1, &m_buffer);
+  glNamedBufferData(m_buffer, m_capacity * sizeof(Point), nullptr, GL_DYNAMIC_DRAW);
+  // the points come from the storage buffer, the VAO only has to exist
+  glCreateVertexArrays(1, &m_vao);
+  m_pending.reserve(64);
+}
+
+Trail::~Trail() {
+  glDeleteBuffers(1, &m_buffer);
+  glDeleteVertexArrays(1, &m_vao);
+}
+
+void Trail::push(const math137::Matrix4f &model) {
+  Point point{{model.getValue(0, 3), model.getValue(1, 3), model.getValue(2, 3), 1.0f},
+              {model.getValue(0, 1), model.getValue(1, 1), model.getValue(2, 1), 0.0f}};
+  if (m_hasLast) {
+    float moved = 0.0f;
+    for (int i = 0; i < 3; ++i)
+      moved = std::max({moved, std::abs(point.position[i] - m_last.position[i]),
+                        std::abs(point.axis[i] - m_last.axis[i])});
+    if (moved < c_minStep)
+      return;
+  }
+  m_last = point;
+  m_hasLast = true;
+  m_pending.push_back(point);
+}
+
+size_t Trail::upload() {
+  size_t count = m_pending.size();
+  if (count == 0)
+    return 0;
+  const Point *points = m_pending.data();
+  if (count > m_capacity) {
+    points += count - m_capacity;
+    count = m_capacity;
+  }
+
+  // the new points start after the newest one and wrap at most once
+  uint32_t write = (m_first + m_size) % m_capacity;
+  size_t head = std::min<size_t>(count, m_capacity - write);
+  glNamedBufferSubData(m_buffer, write * sizeof(Point), head * sizeof(Point), points);
+  if (count > head)
+    glNamedBufferSubData(m_buffer, 0, (count - head) * sizeof(Point), points + head);
+
+  size_t total = m_size + count;
+  if (total > m_capacity) {
+    m_first = static_cast<uint32_t>((m_first + total - m_capacity) % m_capacity);
+    m_size = m_capacity;
+  } else {
+    m_size = static_cast<uint32_t>(total);
+  }
+  m_pending.clear();
+  return count * sizeof(Point);
+}
+
+void Trail::clear() {
+  m_first = 0;
+  m_size = 0;
+  m_pending.clear();
+  m_hasLast = false;
+}
+
+void Trail::render(const std::unique_ptr<Renderer> &renderer, int viewport,
+                   const math137::Vector4f &color, float halfWidth) const {
+  if (m_size < 2)
+    return;
+  renderer->setShader(ShaderType::TRAIL);
+  const Shader &shader = renderer->getShader();
+  shader.setInt("viewportIndex", viewport);
+  shader.setInt("first", static_cast<int>(m_first));
+  shader.setInt("count", static_cast<int>(m_size));
+  shader.setInt("capacity", static_cast<int>(m_capacity));
+  shader.setFloat("halfWidth", halfWidth);
+  shader.setVec4("color", color);
+
+  glBindVertexArray(m_vao);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_buffer);
+  // blended over the scene without hiding what is drawn after it
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glDepthMask(GL_FALSE);
+  if (halfWidth > 0.0f)
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, static_cast<GLsizei>(m_size * 2));
+  else
+    glDrawArrays(GL_LINE_STRIP, 0, static_cast<GLsizei>(m_size));
+  glDepthMask(GL_TRUE);
+  glDisable(GL_BLEND);
+  glBindVertexArray(0);
+  renderer->setShader(ShaderType::OBJECT);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Matrix.hpp"
+#include "Renderer.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// The path a cursor traced, kept on the GPU in a ring buffer of its last
+// positions and orientations. New points reach the buffer with at most two
+// sub-range updates, so a frame costs the same for any trail length, and
+// the whole ring is drawn in one call straight from the buffer.
+class Trail {
+public:
+  static constexpr uint32_t c_defaultCapacity = 4096;
+
+  explicit Trail(uint32_t capacity = c_defaultCapacity);
+  ~Trail();
+  Trail(const Trail &) = delete;
+  Trail &operator=(const Trail &) = delete;
+
+  // records the cursor's origin and its Y axis, unless it has not moved
+  // since the last point
+  void push(const math137::Matrix4f &model);
+  // writes the points pushed since the last call, returns the bytes sent
+  size_t upload();
+  void clear();
+  // a line strip, or a ribbon across the Y axis when halfWidth is above 0
+  void render(const std::unique_ptr<Renderer> &renderer, int viewport,
+              const math137::Vector4f &color, float halfWidth) const;
+
+  inline uint32_t getSize() const { return m_size; }
+  inline uint32_t getCapacity() const { return m_capacity; }
+
+private:
+  // mirrors Point in trail.vs
+  struct Point {
+    float position[4];
+    float axis[4];
+  };
+
+  uint32_t m_buffer;
+  uint32_t m_vao;
+  uint32_t m_capacity;
+  // slot of the oldest point and the number of valid ones
+  uint32_t m_first{0};
+  uint32_t m_size{0};
+  // pushed since the last upload, only its last m_capacity points survive
+  std::vector<Point> m_pending;
+  bool m_hasLast{false};
+  Point m_last{};
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer, single consumer handoff of the latest value.
+// The writer fills back() and publishes it, the reader picks up the newest
+// published slot with update() and reads it through front(). Neither side
+// ever waits for the other, stale slots are recycled so containers inside T
+// keep their capacity.
+template <typename T> class TripleBuffer {
+public:
+  // writer side
+  inline T &back() { return m_slots[m_back]; }
+  inline void publish() {
+    uint8_t previous =
+        m_middle.exchange(m_back | c_fresh, std::memory_order_acq_rel);
+    m_back = previous & c_indexMask;
+  }
+
+  // reader side, returns false when nothing new was published
+  inline bool update() {
+    if (!(m_middle.load(std::memory_order_relaxed) & c_fresh))
+      return false;
+    uint8_t previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+    m_front = previous & c_indexMask;
+    return true;
+  }
+  inline const T &front() const { return m_slots[m_front]; }
+
+private:
+  static constexpr uint8_t c_indexMask = 0x3;
+  static constexpr uint8_t c_fresh = 0x4;
+
+  std::array<T, 3> m_slots;
+  // index of the slot between writer and reader, plus the fresh flag
+  alignas(64) std::atomic<uint8_t> m_middle{1};
+  alignas(64) uint8_t m_back{0};
+  alignas(64) uint8_t m_front{2};
+};
@@ -1,9 +1,14 @@
 #include "Window.hpp"
+#ifdef COUNT_ALLOCATIONS
+#include "AllocationCounter.hpp"
+#endif
 #include "GLFW/glfw3.h"
 #include "ImGuiFileDialog.h"
 #include "MatrixUtils.hpp"
 #include "Quaternion.hpp"
+#include "Frustum.hpp"
 #include "Renderer.hpp"
+#include "Rotation.hpp"
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
@@ -11,142 +16,74 @@
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <string>
 #include <utility>
 
-#define DEBUG 1
-
-GLenum glCheckError_(const char *file, int line)
+static const char *c_methodNames[] = {"Linear (nlerp)", "Spherical (slerp)",
+                                      "Euler"};
+
+// the path the cursor has taken, a ribbon as wide as a quarter of its axes
+static const math137::Vector4f c_trailColor{1.0f, 0.8f, 0.2f, 0.9f};
+static constexpr float c_trailHalfWidth = 0.125f * Cursor::cursorLength;
+// pixels the mouse may move between press and release for a click
+static constexpr double c_clickSlop = 3.0;
+// context thread time a frame may spend on asset uploads, at least one runs
+static constexpr std::chrono::duration<double> c_uploadBudget{0.004};
+// drawn frames that may still fill caches before allocations count as misses
+static constexpr uint64_t c_allocationWarmupFrames = 60;
+
+// FNV-1a over every pose drawn this frame, equal hashes mean equal output
+static uint64_t hashPoses(const SimulationSnapshot &snapshot)
 {
-  GLenum errorCode;
-  while ((errorCode = glGetError()) != GL_NO_ERROR)
-  {
-    std::string error;
-    switch (errorCode)
-    {
-    case GL_INVALID_ENUM:
-      error = "INVALID_ENUM";
-      break;
-    case GL_INVALID_VALUE:
-      error = "INVALID_VALUE";
-      break;
-    case GL_INVALID_OPERATION:
-      error = "INVALID_OPERATION";
-      break;
-    case GL_STACK_OVERFLOW:
-      error = "STACK_OVERFLOW";
-      break;
-    case GL_STACK_UNDERFLOW:
-      error = "STACK_UNDERFLOW";
-      break;
-    case GL_OUT_OF_MEMORY:
-      error = "OUT_OF_MEMORY";
-      break;
-    case GL_INVALID_FRAMEBUFFER_OPERATION:
-      error = "INVALID_FRAMEBUFFER_OPERATION";
-      break;
-    }
-    std::cout << error << " | " << file << " (" << line << ")" << std::endl;
-  }
-  return errorCode;
-}
-
-void APIENTRY glDebugOutput(GLenum source, GLenum type, unsigned int id,
-                            GLenum severity, GLsizei length,
-                            const char *message, const void *userParam)
-{
-  // ignore non-significant error/warning codes
-  if (id == 131169 || id == 131185 || id == 131218 || id == 131204)
-    return;
-
-  std::cout << "---------------" << std::endl;
-  std::cout << "Debug message (" << id << "): " << message << std::endl;
-
-  switch (source)
-  {
-  case GL_DEBUG_SOURCE_API:
-    std::cout << "Source: API";
-    break;
-  case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
-    std::cout << "Source: Window System";
-    break;
-  case GL_DEBUG_SOURCE_SHADER_COMPILER:
-    std::cout << "Source: Shader Compiler";
-    break;
-  case GL_DEBUG_SOURCE_THIRD_PARTY:
-    std::cout << "Source: Third Party";
-    break;
-  case GL_DEBUG_SOURCE_APPLICATION:
-    std::cout << "Source: Application";
-    break;
-  case GL_DEBUG_SOURCE_OTHER:
-    std::cout << "Source: Other";
-    break;
-  }
-  std::cout << std::endl;
-
-  switch (type)
+  uint64_t hash = 14695981039346656037ull;
+  auto add = [&hash](const math137::Matrix4f &model) {
+    auto bytes = reinterpret_cast<const unsigned char *>(model.data());
+    for (size_t i = 0; i < 16 * sizeof(float); ++i)
+      hash = (hash ^ bytes[i]) * 1099511628211ull;
+  };
+  for (const PanelSnapshot &panel : snapshot.panels)
   {
-  case GL_DEBUG_TYPE_ERROR:
-    std::cout << "Type: Error";
-    break;
-  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
-    std::cout << "Type: Deprecated Behaviour";
-    break;
-  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
-    std::cout << "Type: Undefined Behaviour";
-    break;
-  case GL_DEBUG_TYPE_PORTABILITY:
-    std::cout << "Type: Portability";
-    break;
-  case GL_DEBUG_TYPE_PERFORMANCE:
-    std::cout << "Type: Performance";
-    break;
-  case GL_DEBUG_TYPE_MARKER:
-    std::cout << "Type: Marker";
-    break;
-  case GL_DEBUG_TYPE_PUSH_GROUP:
-    std::cout << "Type: Push Group";
-    break;
-  case GL_DEBUG_TYPE_POP_GROUP:
-    std::cout << "Type: Pop Group";
-    break;
-  case GL_DEBUG_TYPE_OTHER:
-    std::cout << "Type: Other";
-    break;
+    add(panel.model);
+    if (panel.ghosts)
+      for (const math137::Matrix4f &ghost : panel.ghosts->models)
+        add(ghost);
   }
-  std::cout << std::endl;
-
-  switch (severity)
-  {
-  case GL_DEBUG_SEVERITY_HIGH:
-    std::cout << "Severity: high";
-    break;
-  case GL_DEBUG_SEVERITY_MEDIUM:
-    std::cout << "Severity: medium";
-    break;
-  case GL_DEBUG_SEVERITY_LOW:
-    std::cout << "Severity: low";
-    break;
-  case GL_DEBUG_SEVERITY_NOTIFICATION:
-    std::cout << "Severity: notification";
-    break;
-  }
-  std::cout << std::endl;
-  std::cout << std::endl;
+  return hash;
 }
 
-#define glCheckError() glCheckError_(__FILE__, __LINE__)
-
-Window::Window(uint16_t width, uint16_t height, std::string title)
+Window::Window(uint16_t width, uint16_t height, std::string title,
+               const RecordingOptions &recording, GlDebugMode glDebug)
     : m_camera(1.f, {0.0f, 0.0f, 0.0f}), m_t(0.f), m_height(height),
-      m_width(width), m_clicked(false)
+      m_width(width), m_clicked(false), m_pacer(60.0)
 {
+  m_startTime = std::chrono::steady_clock::now();
+  // file reads and mesh generation overlap with creating the context, the
+  // uploads are pumped by draw so the first frames show a loading screen
+  m_loader = std::make_unique<AssetLoader>();
+  m_loader->load("shaders", [this] {
+    return [this, sources = Renderer::readSources()] {
+      m_renderer = std::make_unique<Renderer>(sources);
+    };
+  });
+  m_loader->load("cursor meshes", [this] {
+    return [this, geometry = CursorBatch::generateGeometry()] {
+      m_cursorBatch = std::make_unique<CursorBatch>(*m_meshPool, geometry);
+    };
+  });
+  m_loader->load("ground grid", [this] {
+    return [this, grid = Ground::getGrid()] {
+      m_ground = std::make_unique<Ground>(*m_meshPool, grid);
+    };
+  });
+
   glfwInit();
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  GlDebug::hintContext(glDebug);
   m_window = std::unique_ptr<GLFWwindow, GLFWwindowDeleter>(
       glfwCreateWindow(width, height, title.c_str(), NULL, NULL));
   if (m_window.get() == NULL)
@@ -155,13 +92,45 @@ Window::Window(uint16_t width, uint16_t height, std::string title)
   }
   glfwMakeContextCurrent(m_window.get());
   glewInit();
+  m_glDebug = std::make_unique<GlDebug>(glDebug, std::cerr);
+  // the framebuffer may differ from the window size on high DPI screens
+  glfwGetFramebufferSize(m_window.get(), &m_width, &m_height);
+
+  if (!recording.replayPath.empty())
+    m_replayer = std::make_unique<Replayer>(recording.replayPath);
+  else if (!recording.recordPath.empty())
+    m_recorder = std::make_unique<Recorder>(recording.recordPath);
+  if (!recording.frameLogPath.empty())
+  {
+    m_frameLog.open(recording.frameLogPath, std::ios::trunc);
+    if (!m_frameLog)
+      throw std::runtime_error("Failed to create frame log " + recording.frameLogPath);
+    m_frameLog << "frame,time,wall_ms,tick,pose_hash\n";
+  }
 
-  m_renderer = std::make_unique<Renderer>();
-  m_sceneQuat = std::make_unique<Scene>(true);
-  m_sceneEuler = std::make_unique<Scene>(false);
-  // initial projection will be set per-viewport in draw()
-  m_renderer->setProjection(math137::MatrixUtils::Projection(
-      M_PI_4, (float)m_width / m_height, 0.1f, 100.f));
+  if (m_replayer)
+  {
+    // replays run as fast as they can
+    m_pacer.setTargetRate(0.0);
+    m_pacer.setPresentMode(PresentMode::UNLOCKED);
+  }
+  else
+  {
+    if (const GLFWvidmode *mode = glfwGetVideoMode(glfwGetPrimaryMonitor()))
+      m_pacer.setTargetRate(mode->refreshRate);
+    m_pacer.setPresentMode(PresentMode::VSYNC);
+  }
+
+  // a replay steps the simulation on the recorded clock so every run of the
+  // same log produces the same poses
+  m_simulation = std::make_unique<Simulation>(240.0f, !m_replayer);
+  m_simulation->addPanel(InterpolationMethod::LINEAR);
+  m_simulation->addPanel(InterpolationMethod::EULER);
+  m_meshPool = std::make_unique<MeshPool>();
+  m_resolution = std::make_unique<DynamicResolution>();
+  // resolution follows GPU timings, which would make replays diverge
+  if (m_replayer)
+    m_resolution->setEnabled(false);
 
   IMGUI_CHECKVERSION();
   ImGui::CreateContext();
@@ -178,206 +147,787 @@ Window::Window(uint16_t width, uint16_t height, std::string title)
   glfwSetMouseButtonCallback(m_window.get(), mouseButtonCallback);
   glfwSetCursorPosCallback(m_window.get(), cursorPositionCallback);
   glfwSetFramebufferSizeCallback(m_window.get(), resizeWindowCallback);
-#if DEBUG
-  glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
-  glEnable(GL_DEBUG_OUTPUT);
-  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-  glDebugMessageCallback(glDebugOutput, nullptr);
-  glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr,
-                        GL_TRUE);
-
-#endif // 0
+  // every replayed frame has to draw the scene for the log to match
+  if (m_replayer)
+    m_loader->finish();
 }
 
 Window::~Window()
 {
+  // pending uploads refer to members released below
+  m_loader.reset();
   ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplGlfw_Shutdown();
   ImGui::DestroyContext();
+  m_simulation.reset();
+  // GL objects must be released while the context is still alive
+  m_resolution.reset();
+  m_trails.clear();
+  m_ground.reset();
+  m_cursorBatch.reset();
+  m_meshPool.reset();
+  m_renderer.reset();
+  m_glDebug.reset();
   glfwTerminate();
 }
 
 void Window::update(bool &running)
 {
   running = !glfwWindowShouldClose(m_window.get());
+  m_loading = !m_renderer || !m_cursorBatch || !m_ground;
+  if (m_replayer)
+  {
+    // events are still polled to keep the window responsive, but the input
+    // comes from the log
+    glfwPollEvents();
+    if (!m_replayer->next(m_replayFrame))
+    {
+      m_replayFinished = true;
+      running = false;
+      return;
+    }
+    for (const InputEvent &event : m_replayFrame.inputs)
+      m_inputQueue.push(event);
+    processInput();
+    return;
+  }
+  // sleep first so the events polled below are as fresh as possible
+  m_pacer.waitForFrame();
   glfwPollEvents();
+  if (m_loading)
+  {
+    // the loading screen takes no input, and a replay loads before its
+    // first frame, so none of this is recorded
+    InputEvent event;
+    while (m_inputQueue.pop(event))
+    {
+    }
+    return;
+  }
+  if (m_recorder)
+    m_recorder->beginFrame(glfwGetTime());
+  processInput();
 }
 
-void Window::draw()
+double Window::now() const
 {
-  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  float t = glfwGetTime();
-  float dt = (m_t == 0.0f) ? 0.0f : (t - m_t);
+  return m_replayer ? m_replayFrame.time : glfwGetTime();
+}
 
-  // advance scene state
-  if (m_sceneQuat) m_sceneQuat->update(dt);
-  if (m_sceneEuler) m_sceneEuler->update(dt);
+void Window::processInput()
+{
+  // coalesce everything that arrived since the last frame into one camera
+  // update, so the view is recomputed once however fast the mouse reports
+  float dx = 0.0f, dy = 0.0f, distanceDelta = 0.0f;
+  double oldest = -1.0;
+  InputEvent event;
+  while (m_inputQueue.pop(event))
+  {
+    if (m_recorder)
+      m_recorder->input(event);
+    if (oldest < 0.0)
+      oldest = event.timestamp;
+    switch (event.type)
+    {
+    case InputEventType::CURSOR_MOVE:
+      if (m_clicked)
+      {
+        dx += m_cursorX - event.x;
+        dy += m_cursorY - event.y;
+      }
+      m_cursorX = event.x;
+      m_cursorY = event.y;
+      break;
+    case InputEventType::SCROLL:
+      distanceDelta += 0.8f * event.y;
+      break;
+    case InputEventType::MOUSE_BUTTON:
+      m_clicked = (event.button == GLFW_MOUSE_BUTTON_1 && event.action == GLFW_PRESS);
+      if (m_clicked)
+      {
+        m_pressX = m_cursorX;
+        m_pressY = m_cursorY;
+      }
+      // releasing where it was pressed selects, a drag only turns the camera
+      else if (event.button == GLFW_MOUSE_BUTTON_1 &&
+               std::abs(m_cursorX - m_pressX) + std::abs(m_cursorY - m_pressY) <= c_clickSlop)
+        m_pickPending = true;
+      break;
+    }
+  }
+  if (oldest < 0.0)
+    return;
 
-  int halfW = m_width / 2;
-  m_renderer->setView(m_camera.getView());
+  if (dx != 0.0f || dy != 0.0f || distanceDelta != 0.0f)
+    m_camera.applyInput(dx, dy, distanceDelta);
+  m_inputLatency.applied = now() - oldest;
+  m_pendingInputTime = oldest;
+}
 
-  glViewport(0, 0, halfW, m_height);
-  m_renderer->setProjection(math137::MatrixUtils::Projection(
-      M_PI_4, (float)halfW / (float)m_height, 0.1f, 100.f));
-  if (m_showAllFrames) m_sceneQuat->renderSamples(m_renderer, m_intermediateFrames);
-  m_sceneQuat->render(m_renderer);
+void Window::updateTrails(const SimulationSnapshot &snapshot)
+{
+  m_trailUploadBytes = 0;
+  if (!m_showTrail)
+    return;
+  std::erase_if(m_trails, [&snapshot](const auto &entry) {
+    return std::none_of(snapshot.panels.begin(), snapshot.panels.end(),
+                        [&entry](const PanelSnapshot &panel) { return panel.id == entry.first; });
+  });
+  bool restarted = snapshot.time < m_trailTime;
+  m_trailTime = snapshot.time;
+  for (const PanelSnapshot &panel : snapshot.panels)
+  {
+    std::unique_ptr<Trail> &trail = m_trails[panel.id];
+    if (!trail)
+      trail = std::make_unique<Trail>(static_cast<uint32_t>(m_trailLength));
+    else if (restarted)
+      trail->clear();
+    trail->push(panel.model);
+    m_trailUploadBytes += trail->upload();
+  }
+}
+
+void Window::updatePicking(const SimulationSnapshot &snapshot)
+{
+  std::erase_if(m_pickables, [&snapshot](const auto &entry) {
+    return std::none_of(snapshot.panels.begin(), snapshot.panels.end(),
+                        [&entry](const PanelSnapshot &panel) { return panel.id == entry.first; });
+  });
+  if (m_selection && !m_pickables.contains(m_selection->panel))
+    m_selection.reset();
+  auto origin = [](const math137::Matrix4f &model) {
+    return math137::Vector3f{model.getValue(0, 3), model.getValue(1, 3), model.getValue(2, 3)};
+  };
+  for (const PanelSnapshot &panel : snapshot.panels)
+  {
+    Pickables &pickables = m_pickables[panel.id];
+    size_t joints = panel.skeleton.size() / 3;
+    BoundingSphere cursor{origin(panel.model), Cursor::boundingRadius};
+    bool changed = pickables.bvh.empty() || pickables.ghosts != panel.ghosts || pickables.joints != joints;
+    if (changed)
+    {
+      // its object indices no longer mean the same
+      if (m_selection && m_selection->panel == panel.id)
+        m_selection.reset();
+      pickables.ghosts = panel.ghosts;
+      pickables.joints = joints;
+      pickables.bounds.assign(1, cursor);
+      if (panel.ghosts)
+        for (const math137::Matrix4f &model : panel.ghosts->models)
+          pickables.bounds.push_back({origin(model), Cursor::boundingRadius});
+      pickables.bounds.resize(pickables.bounds.size() + joints);
+    }
+    else
+    {
+      pickables.bounds[0] = cursor;
+    }
+    // a joint's three axis instances share its origin
+    BoundingSphere *jointBounds = pickables.bounds.data() + pickables.bounds.size() - joints;
+    for (size_t j = 0; j < joints; ++j)
+    {
+      const float *origin = panel.skeleton[j * 3].translation;
+      jointBounds[j] = {{origin[0], origin[1], origin[2]}, Cursor::boundingRadius};
+    }
+
+    if (changed)
+      pickables.bvh.build(pickables.bounds);
+    else if (joints > 0)
+      pickables.bvh.refit(pickables.bounds);
+    else
+      pickables.bvh.move(0, cursor);
+  }
+}
 
-  glViewport(halfW, 0, m_width - halfW, m_height);
-  m_renderer->setProjection(math137::MatrixUtils::Projection(
-      M_PI_4, (float)(m_width - halfW) / (float)m_height, 0.1f, 100.f));
-  if (m_showAllFrames) m_sceneEuler->renderSamples(m_renderer, m_intermediateFrames);
-  m_sceneEuler->render(m_renderer);
+void Window::pick(const SimulationSnapshot &snapshot)
+{
+  m_pickPending = false;
+  m_selection.reset();
+  int windowWidth, windowHeight;
+  glfwGetWindowSize(m_window.get(), &windowWidth, &windowHeight);
+  if (windowWidth <= 0 || windowHeight <= 0)
+    return;
+  // the viewports tile the render target from its bottom left corner
+  float x = static_cast<float>(m_cursorX / windowWidth) * m_resolution->getWidth();
+  float y = static_cast<float>(1.0 - m_cursorY / windowHeight) * m_resolution->getHeight();
+  for (size_t i = 0; i < m_viewports.size() && i < snapshot.panels.size(); ++i)
+  {
+    const Viewport &vp = m_viewports[i];
+    if (x < vp.x || x >= vp.x + vp.width || y < vp.y || y >= vp.y + vp.height)
+      continue;
+    auto found = m_pickables.find(snapshot.panels[i].id);
+    if (found == m_pickables.end())
+      return;
+    // through the pixel on the near plane, from view space into the world
+    float ndcX = 2.0f * (x - vp.x) / vp.width - 1.0f;
+    float ndcY = 2.0f * (y - vp.y) / vp.height - 1.0f;
+    float view[3] = {ndcX / vp.projection.getValue(0, 0), ndcY / vp.projection.getValue(1, 1), -1.0f};
+    math137::Matrix4f inverseView = m_camera.getInverseView();
+    float direction[3];
+    for (int r = 0; r < 3; ++r)
+      direction[r] = inverseView.getValue(r, 0) * view[0] + inverseView.getValue(r, 1) * view[1] +
+                     inverseView.getValue(r, 2) * view[2];
+    Ray ray{{inverseView.getValue(0, 3), inverseView.getValue(1, 3), inverseView.getValue(2, 3)},
+            {direction[0], direction[1], direction[2]}};
+
+    auto from = std::chrono::steady_clock::now();
+    RayHit hit = found->second.bvh.pick(ray);
+    m_pickTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - from).count();
+    if (hit.object != Bvh::c_noHit)
+      m_selection = Selection{found->first, hit.object, hit.distance};
+    return;
+  }
+}
+
+void Window::draw()
+{
+  if (m_replayFinished)
+    return;
+  m_loader->pump(c_uploadBudget);
+  if (m_loading)
+  {
+    drawLoading();
+    return;
+  }
+  auto frameStart = std::chrono::steady_clock::now();
+#ifdef COUNT_ALLOCATIONS
+  AllocationCount allocationsBefore = allocationCount();
+#endif
+  m_frameArena.reset();
+  float t = now();
+  if (m_replayer)
+    m_simulation->advance(t - m_t);
+
+  // scenes advance on the simulation thread, draw its latest finished tick
+  const SimulationSnapshot &snapshot = m_simulation->acquire();
+
+  m_renderer->setView(m_camera.getView());
+  m_renderer->setCamerPos(m_camera.getPosition());
+  m_cursorBatch->resetStats();
+  m_culledTracks = 0;
+  m_resolution->begin(m_width, m_height);
+  Renderer::tileViewports(snapshot.panels.size(), m_resolution->getWidth(),
+                          m_resolution->getHeight(), m_viewports);
+  updateTrails(snapshot);
+  updatePicking(snapshot);
+  if (m_pickPending)
+    pick(snapshot);
+
+  // panels are drawn in groups of as many viewports as one pass can address,
+  // each group costs a single instance upload and draw for all its cursors
+  // while the ground grid is broadcast to every viewport of the group
+  size_t groupSize = m_renderer->getMaxViewports();
+  for (size_t first = 0; first < snapshot.panels.size(); first += groupSize)
+  {
+    size_t count = std::min(groupSize, snapshot.panels.size() - first);
+    m_renderer->setViewports({m_viewports.data() + first, count});
+    for (size_t i = 0; i < count; ++i)
+    {
+      const PanelSnapshot &panel = snapshot.panels[first + i];
+      if (panel.ghosts)
+      {
+        // skip submitting the ghost frames of tracks that cannot be seen
+        const Viewport &vp = m_viewports[first + i];
+        Frustum frustum(vp.projection * m_renderer->getView());
+        if (!m_cursorBatch->getCulling() || frustum.isVisible(panel.track))
+          m_cursorBatch->addInstances(panel.ghosts->instances, i);
+        else
+          ++m_culledTracks;
+      }
+      m_cursorBatch->add(panel.model, i);
+      if (!panel.skeleton.empty())
+        m_cursorBatch->addInstances(panel.skeleton, i);
+    }
+    m_cursorBatch->flush(m_renderer);
+    if (m_showTrail)
+      for (size_t i = 0; i < count; ++i)
+        m_trails[snapshot.panels[first + i].id]->render(m_renderer, static_cast<int>(i), c_trailColor,
+                                                          m_trailRibbon ? c_trailHalfWidth : 0.0f);
+    m_ground->render(m_renderer);
+  }
+  m_resolution->end();
 
   glViewport(0, 0, m_width, m_height);
-  renderImgui(t - m_t);
+  renderImgui(t - m_t, snapshot);
+  // a no-op unless the debug mode is synchronous
+  glCheckError(*m_glDebug);
+  m_pacer.frameSubmitted();
   glfwSwapBuffers(m_window.get());
+  m_pacer.framePresented();
+  if (m_interactiveMs < 0.0)
+  {
+    m_interactiveMs = sinceStart();
+    // a replay loads everything before its first frame
+    if (m_firstFrameMs < 0.0)
+      m_firstFrameMs = m_interactiveMs;
+  }
+  // time from the oldest input of this frame to the buffer swap, a proxy
+  // for input to photon latency
+  if (m_pendingInputTime >= 0.0)
+  {
+    double presented = now() - m_pendingInputTime;
+    m_inputLatency.presented = presented;
+    m_inputLatency.maxPresented = std::max(m_inputLatency.maxPresented, presented);
+    m_pendingInputTime = -1.0;
+  }
+  if (m_frameLog.is_open())
+  {
+    double wall = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - frameStart).count();
+    m_frameLog << m_frame << ',' << t << ',' << wall << ',' << snapshot.tick << ','
+               << hashPoses(snapshot) << '\n';
+  }
+#ifdef COUNT_ALLOCATIONS
+  AllocationCount allocationsAfter = allocationCount();
+  m_frameAllocations = allocationsAfter.count - allocationsBefore.count;
+  m_frameAllocatedBytes = allocationsAfter.bytes - allocationsBefore.bytes;
+  if (m_frame >= c_allocationWarmupFrames && m_frameAllocations > 0)
+  {
+    ++m_allocatingFrames;
+    m_measuredAllocations += m_frameAllocations;
+  }
+#endif
+  ++m_frame;
   m_t = t;
 }
 
-void Window::renderImgui(float dt)
+void Window::drawLoading()
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, m_width, m_height);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+  ImGui_ImplOpenGL3_NewFrame();
+  ImGui_ImplGlfw_NewFrame();
+  ImGui::NewFrame();
+  ImGui::SetNextWindowPos(ImVec2(m_width * 0.5f, m_height * 0.5f), ImGuiCond_Always,
+                          ImVec2(0.5f, 0.5f));
+  ImGui::Begin("Loading", nullptr,
+               ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoCollapse);
+  float progress = static_cast<float>(m_loader->getCompleted()) /
+                   static_cast<float>(std::max<size_t>(m_loader->getQueued(), 1));
+  ImGui::ProgressBar(progress, ImVec2(240.0f, 0.0f));
+  ImGui::Text("%zu / %zu assets", m_loader->getCompleted(), m_loader->getQueued());
+  if (!m_loader->getLastCompleted().empty())
+    ImGui::Text("Loaded %s", m_loader->getLastCompleted().c_str());
+  ImGui::End();
+  ImGui::Render();
+  ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+  m_pacer.frameSubmitted();
+  glfwSwapBuffers(m_window.get());
+  m_pacer.framePresented();
+  if (m_firstFrameMs < 0.0)
+    m_firstFrameMs = sinceStart();
+}
+
+double Window::sinceStart() const
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_startTime)
+      .count();
+}
+
+void Window::renderImgui(float dt, const SimulationSnapshot &snapshot)
 {
-  auto eulerToQuaternion = [](float roll, float pitch, float yaw) {
-    float cr = std::cos(roll * 0.5f);
-    float sr = std::sin(roll * 0.5f);
-    float cp = std::cos(pitch * 0.5f);
-    float sp = std::sin(pitch * 0.5f);
-    float cy = std::cos(yaw * 0.5f);
-    float sy = std::sin(yaw * 0.5f);
-    math137::Quaternion q;
-    q.a = cr * cp * cy + sr * sp * sy;
-    q.b = sr * cp * cy - cr * sp * sy;
-    q.c = cr * sp * cy + sr * cp * sy;
-    q.d = cr * cp * sy - sr * sp * cy;
-    return q;
-  };
   // ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Always);
   // ImGui::SetNextWindowSize(ImVec2(100, m_height), ImGuiCond_Always);
   ImGui_ImplOpenGL3_NewFrame();
   ImGui_ImplGlfw_NewFrame();
   ImGui::NewFrame();
   ImGui::Begin("Info");
-  static float startPos[3] = {0.0f, 0.0f, 0.0f};
-  ImGui::InputFloat3("Cursor Start Position", startPos, "%.3f");
-  static float startEuler[3] = {0.0f, 0.0f, 0.0f};
-  static float startQuat[4] = {1.0f, 0.0f, 0.0f, 0.0f};
-  bool startEulerChanged = ImGui::InputFloat3("Cursor Start Rotation (Euler)", startEuler, "%.3f");
-  if (startEulerChanged) {
-    math137::Quaternion q = eulerToQuaternion(startEuler[0], startEuler[1], startEuler[2]);
-    q.normalize();
-    startQuat[0] = q.a;
-    startQuat[1] = q.b;
-    startQuat[2] = q.c;
-    startQuat[3] = q.d;
-  }
-  bool startQuatChanged = ImGui::InputFloat4("Cursor Start Rotation (Quat)", startQuat, "%.3f");
-  if (startQuatChanged) {
-    math137::Quaternion q{startQuat[0], startQuat[1], startQuat[2], startQuat[3]};
-    q.normalize();
-    // quaternion -> euler (X=roll, Y=pitch, Z=yaw) using Tait-Bryan angles
-    float w = q.a, x = q.b, y = q.c, z = q.d;
-    // roll (x-axis)
-    float sinr_cosp = 2.0f * (w * x + y * z);
-    float cosr_cosp = 1.0f - 2.0f * (x * x + y * y);
-    float roll = atan2f(sinr_cosp, cosr_cosp);
-    // pitch (y-axis)
-    float sinp = 2.0f * (w * y - z * x);
-    float pitch;
-    if (fabsf(sinp) >= 1.0f)
-      pitch = copysignf(M_PI_2, sinp);
-    else
-      pitch = asinf(sinp);
-    // yaw (z-axis)
-    float siny_cosp = 2.0f * (w * z + x * y);
-    float cosy_cosp = 1.0f - 2.0f * (y * y + z * z);
-    float yaw = atan2f(siny_cosp, cosy_cosp);
-    startEuler[0] = roll;
-    startEuler[1] = pitch;
-    startEuler[2] = yaw;
+  if (m_replayer)
+  {
+    // the log decides what the UI does, the widgets only display it
+    if (m_replayFrame.parameters)
+      m_ui = *m_replayFrame.parameters;
+    for (const UiAction &action : m_replayFrame.actions)
+      applyAction(action);
+    ImGui::Text("Replaying frame %llu / %zu", static_cast<unsigned long long>(m_frame),
+                m_replayer->getFrameCount());
+    ImGui::BeginDisabled();
   }
+  ImGui::InputFloat3("Cursor Start Position", m_ui.startPos, "%.3f");
+  bool startEulerChanged = ImGui::InputFloat3("Cursor Start Rotation (Euler)", m_ui.startEuler, "%.3f");
+  if (startEulerChanged)
+    Rotation::eulerToQuaternion(m_ui.startEuler, m_ui.startQuat);
+  bool startQuatChanged = ImGui::InputFloat4("Cursor Start Rotation (Quat)", m_ui.startQuat, "%.3f");
+  if (startQuatChanged)
+    Rotation::quaternionToEuler(m_ui.startQuat, m_ui.startEuler);
+  ImGui::Separator();
+  ImGui::InputFloat3("Cursor End Position", m_ui.endPos, "%.3f");
+  bool endEulerChanged = ImGui::InputFloat3("Cursor End Rotation (Euler)", m_ui.endEuler, "%.3f");
+  if (endEulerChanged)
+    Rotation::eulerToQuaternion(m_ui.endEuler, m_ui.endQuat);
+  bool endQuatChanged = ImGui::InputFloat4("Cursor End Rotation (Quat)", m_ui.endQuat, "%.3f");
+  if (endQuatChanged)
+    Rotation::quaternionToEuler(m_ui.endQuat, m_ui.endEuler);
   ImGui::Separator();
-  static float endPos[3] = {0.0f, 0.0f, 0.0f};
-  ImGui::InputFloat3("Cursor End Position", endPos, "%.3f");
-  static float endEuler[3] = {0.0f, 0.0f, 0.0f};
-  static float endQuat[4] = {1.0f, 0.0f, 0.0f, 0.0f};
-  bool endEulerChanged = ImGui::InputFloat3("Cursor End Rotation (Euler)", endEuler, "%.3f");
-  if (endEulerChanged) {
-    math137::Quaternion q = eulerToQuaternion(endEuler[0], endEuler[1], endEuler[2]);
-    q.normalize();
-    endQuat[0] = q.a;
-    endQuat[1] = q.b;
-    endQuat[2] = q.c;
-    endQuat[3] = q.d;
+  ImGui::InputFloat("Interpolation Duration (s)", &m_ui.duration, 0.1f, 10.0f, "%.3f");
+  bool showAllFrames = m_showAllFrames;
+  int intermediateFrames = m_intermediateFrames;
+  bool ghostsChanged = ImGui::Checkbox("Show All Frames", &showAllFrames);
+  ghostsChanged |= ImGui::InputInt("Intermediate Frames", &intermediateFrames);
+  if (ghostsChanged)
+    dispatch({UiActionType::GHOST_FRAMES, 0, intermediateFrames, showAllFrames ? 1.0f : 0.0f});
+  bool arcLengthGhosts = m_arcLengthGhosts;
+  if (ImGui::Checkbox("Space Frames by Arc Length", &arcLengthGhosts))
+    dispatch({UiActionType::GHOST_SPACING, 0, arcLengthGhosts, 0.0f});
+  bool constantSpeed = m_constantSpeed;
+  if (ImGui::Checkbox("Constant Speed", &constantSpeed))
+    dispatch({UiActionType::CONSTANT_SPEED, 0, constantSpeed, 0.0f});
+  int arcLengthBudgetKb = m_arcLengthBudgetKb;
+  if (ImGui::InputInt("Arc Length Table (KB)", &arcLengthBudgetKb, 8, 64, ImGuiInputTextFlags_EnterReturnsTrue))
+    dispatch({UiActionType::ARC_LENGTH_BUDGET, 0, std::max(arcLengthBudgetKb, 1), 0.0f});
+  bool showTrail = m_showTrail;
+  int trailLength = m_trailLength;
+  bool trailChanged = ImGui::Checkbox("Show Trail", &showTrail);
+  trailChanged |= ImGui::InputInt("Trail Length", &trailLength, 256, 4096, ImGuiInputTextFlags_EnterReturnsTrue);
+  if (trailChanged)
+    dispatch({UiActionType::TRAIL, 0, std::max(trailLength, 2), showTrail ? 1.0f : 0.0f});
+  bool trailRibbon = m_trailRibbon;
+  if (ImGui::Checkbox("Trail Ribbon", &trailRibbon))
+    dispatch({UiActionType::TRAIL_RIBBON, 0, trailRibbon, 0.0f});
+  if (m_showTrail)
+    ImGui::Text("Trail upload: %zu bytes", m_trailUploadBytes);
+  int skeletonJoints = m_skeletonJoints;
+  if (ImGui::InputInt("Skeleton Joints", &skeletonJoints, 100, 1000, ImGuiInputTextFlags_EnterReturnsTrue))
+    dispatch({UiActionType::SKELETON, 0, std::max(skeletonJoints, 0), 0.0f});
+  static const char *lodModes[] = {"Off", "CPU", "GPU"};
+  int lodMode = static_cast<int>(m_cursorBatch->getLodMode());
+  if (ImGui::Combo("Cursor LOD", &lodMode, lodModes, IM_ARRAYSIZE(lodModes)))
+    dispatch({UiActionType::LOD_MODE, 0, lodMode, 0.0f});
+  bool culling = m_cursorBatch->getCulling();
+  if (ImGui::Checkbox("Frustum Culling", &culling))
+    dispatch({UiActionType::CULLING, 0, culling, 0.0f});
+  const CursorBatch::Stats &stats = m_cursorBatch->getStats();
+  ImGui::Text("Axes submitted: %u, culled: %u, drawn: %u", stats.submitted, stats.culled, stats.drawn);
+  ImGui::Text("Instance upload: %llu KB", static_cast<unsigned long long>(stats.uploadedBytes / 1024));
+  ImGui::Text("Ghost tracks culled: %d", m_culledTracks);
+  if (m_cursorBatch->getLodMode() == LodMode::CPU)
+    ImGui::Text("LOD instances: %u / %u / %u / %u", stats.lods[0], stats.lods[1], stats.lods[2], stats.lods[3]);
+  ImGui::Separator();
+  for (const PanelSnapshot &panel : snapshot.panels)
+  {
+    ImGui::PushID(static_cast<int>(panel.id));
+    int method = static_cast<int>(panel.method);
+    if (ImGui::Combo("Panel", &method, c_methodNames, IM_ARRAYSIZE(c_methodNames)))
+      dispatch({UiActionType::SET_METHOD, panel.id, method, 0.0f});
+    ImGui::SameLine();
+    if (ImGui::Button("Remove"))
+      dispatch({UiActionType::REMOVE_PANEL, panel.id, 0, 0.0f});
+    ImGui::PopID();
   }
-  bool endQuatChanged = ImGui::InputFloat4("Cursor End Rotation (Quat)", endQuat, "%.3f");
-  if (endQuatChanged) {
-    math137::Quaternion q{endQuat[0], endQuat[1], endQuat[2], endQuat[3]};
-    q.normalize();
-    float w = q.a, x = q.b, y = q.c, z = q.d;
-    float sinr_cosp = 2.0f * (w * x + y * z);
-    float cosr_cosp = 1.0f - 2.0f * (x * x + y * y);
-    float roll = atan2f(sinr_cosp, cosr_cosp);
-    float sinp = 2.0f * (w * y - z * x);
-    float pitch;
-    if (fabsf(sinp) >= 1.0f)
-      pitch = copysignf(M_PI_2, sinp);
+  if (m_selection)
+  {
+    auto panel = std::find_if(snapshot.panels.begin(), snapshot.panels.end(),
+                              [this](const PanelSnapshot &p) { return p.id == m_selection->panel; });
+    const Pickables &pickables = m_pickables.at(m_selection->panel);
+    size_t ghosts = pickables.ghosts ? pickables.ghosts->models.size() : 0;
+    uint32_t object = m_selection->object;
+    if (object == 0)
+      ImGui::Text("Selected: cursor of panel %u at %.2f / %.2f s", m_selection->panel, snapshot.time,
+                  snapshot.duration);
+    else if (object <= ghosts)
+      ImGui::Text("Selected: ghost frame %u / %zu of panel %u", object - 1, ghosts, m_selection->panel);
     else
-      pitch = asinf(sinp);
-    float siny_cosp = 2.0f * (w * z + x * y);
-    float cosy_cosp = 1.0f - 2.0f * (y * y + z * z);
-    float yaw = atan2f(siny_cosp, cosy_cosp);
-    endEuler[0] = roll;
-    endEuler[1] = pitch;
-    endEuler[2] = yaw;
+      ImGui::Text("Selected: joint %zu of panel %u", object - 1 - ghosts, m_selection->panel);
+    const math137::Vector3f &center = pickables.bounds[object].center;
+    ImGui::Text("Position %.3f %.3f %.3f, %.2f from the camera", center.x(), center.y(), center.z(),
+                m_selection->distance);
+    if (panel != snapshot.panels.end())
+      ImGui::Text("%s track around %.3f %.3f %.3f, radius %.3f",
+                  c_methodNames[static_cast<int>(panel->method)], panel->track.center.x(),
+                  panel->track.center.y(), panel->track.center.z(), panel->track.radius);
   }
+  if (!m_pickables.empty())
+    ImGui::Text("Last pick: %.1f us", m_pickTime);
+  ImGui::Combo("New Panel", &m_ui.newMethod, c_methodNames, IM_ARRAYSIZE(c_methodNames));
+  if (ImGui::Button("Add Panel"))
+    dispatch({UiActionType::ADD_PANEL, 0, m_ui.newMethod, 0.0f});
+  float tickRate = m_simulation->getTickRate();
+  if (ImGui::InputFloat("Simulation Rate (Hz)", &tickRate, 10.0f, 100.0f, "%.0f"))
+    dispatch({UiActionType::TICK_RATE, 0, 0, tickRate});
+  ImGui::Text("Simulation tick: %llu", static_cast<unsigned long long>(snapshot.tick));
+  ImGui::Text("Input latency: applied %.2f ms, presented %.2f ms (max %.2f ms)",
+              m_inputLatency.applied * 1000.0, m_inputLatency.presented * 1000.0,
+              m_inputLatency.maxPresented * 1000.0);
+  if (m_droppedInputEvents > 0)
+    ImGui::Text("Dropped input events: %u", m_droppedInputEvents.load());
+  ImGui::Separator();
+  static const char *presentModes[] = {"VSync", "Adaptive VSync", "Unlocked"};
+  int presentMode = static_cast<int>(m_pacer.getPresentMode());
+  if (ImGui::Combo("Present Mode", &presentMode, presentModes, IM_ARRAYSIZE(presentModes)))
+    dispatch({UiActionType::PRESENT_MODE, 0, presentMode, 0.0f});
+  float targetRate = static_cast<float>(m_pacer.getTargetRate());
+  if (ImGui::InputFloat("Target Frame Rate (0 = off)", &targetRate, 1.0f, 10.0f, "%.0f"))
+    dispatch({UiActionType::TARGET_RATE, 0, 0, targetRate});
+  bool lateSampling = m_pacer.getLateSampling();
+  if (ImGui::Checkbox("Late Input Sampling", &lateSampling))
+    dispatch({UiActionType::LATE_SAMPLING, 0, lateSampling, 0.0f});
+  bool dynamicResolution = m_resolution->getEnabled();
+  if (ImGui::Checkbox("Dynamic Resolution", &dynamicResolution))
+    dispatch({UiActionType::DYNAMIC_RESOLUTION, 0, dynamicResolution, 0.0f});
+  float budget = static_cast<float>(m_resolution->getBudget());
+  if (ImGui::InputFloat("GPU Budget (ms)", &budget, 0.5f, 2.0f, "%.1f"))
+    dispatch({UiActionType::GPU_BUDGET, 0, 0, budget});
+  ImGui::Text("Scene GPU %.2f ms at %d%% (%dx%d)", m_resolution->getGpuTime(),
+              static_cast<int>(m_resolution->getScale() * 100.0f),
+              m_resolution->getWidth(), m_resolution->getHeight());
+  FramePacer::Stats pacing = m_pacer.getStats();
+  ImGui::Text("Frame %.2f ms, jitter %.2f ms, worst %.2f ms, work %.2f ms",
+              pacing.averageFrame, pacing.jitter, pacing.worstFrame, pacing.predictedWork);
+  ImGui::Text("Startup: first frame %.1f ms, interactive %.1f ms", m_firstFrameMs,
+              m_interactiveMs);
+  FrameArena::Stats arena = m_frameArena.getStats();
+  ImGui::Text("Frame arena %zu / %zu KB, peak %zu KB, overflows %llu", arena.used / 1024,
+              arena.capacity / 1024, arena.peak / 1024,
+              static_cast<unsigned long long>(arena.overflows));
+#ifdef COUNT_ALLOCATIONS
+  ImGui::Text("Heap allocations last frame: %llu (%llu bytes)",
+              static_cast<unsigned long long>(m_frameAllocations),
+              static_cast<unsigned long long>(m_frameAllocatedBytes));
+#endif
+  // not recorded, it changes what is logged and not what is drawn
+  static const char *glDebugModes[] = {"Off", "Async", "Sync"};
+  int glDebugMode = static_cast<int>(m_glDebug->getMode());
+  if (ImGui::Combo("GL Debug", &glDebugMode, glDebugModes, IM_ARRAYSIZE(glDebugModes)))
+    m_glDebug->setMode(static_cast<GlDebugMode>(glDebugMode));
+  GlDebug::Stats glDebug = m_glDebug->getStats();
+  ImGui::Text("GL messages %llu, repeats %llu, rate limited %llu, dropped %llu%s",
+              static_cast<unsigned long long>(glDebug.received),
+              static_cast<unsigned long long>(glDebug.repeats),
+              static_cast<unsigned long long>(glDebug.rateLimited),
+              static_cast<unsigned long long>(glDebug.dropped),
+              m_glDebug->hasDebugContext() ? "" : " (no debug context)");
   ImGui::Separator();
-  static float duration = 5.0f;
-  ImGui::InputFloat("Interpolation Duration (s)", &duration, 0.1f, 10.0f, "%.3f");
-  static bool useSpherical = false;
-  ImGui::Checkbox("Use Spherical Interpolation", &useSpherical);
-  ImGui::Checkbox("Show All Frames", &m_showAllFrames);
-  ImGui::InputInt("Intermediate Frames", &m_intermediateFrames);
 
   if (ImGui::Button("Start"))
+    dispatch({UiActionType::START, 0, 0, 0.0f});
+  ImGui::Separator();
+  if (ImGui::Button("Load Tracks"))
   {
-    // set Euler angles on the Euler scene
-    // normalize Euler angles into [-pi, pi]
-    math137::Quaternion startQ{startQuat[0], startQuat[1], startQuat[2], startQuat[3]};
-    startQ.normalize();
-    math137::Quaternion endQ{endQuat[0], endQuat[1], endQuat[2], endQuat[3]};
-    endQ.normalize();
-    startQuat[0] = startQ.a;
-    startQuat[1] = startQ.b;
-    startQuat[2] = startQ.c;
-    startQuat[3] = startQ.d;
-    endQuat[0] = endQ.a;
-    endQuat[1] = endQ.b;
-    endQuat[2] = endQ.c;
-    endQuat[3] = endQ.d;
-    m_sceneQuat->setStartPosition({startPos[0], startPos[1], startPos[2]});
-    m_sceneEuler->setStartPosition({startPos[0], startPos[1], startPos[2]});
-    m_sceneQuat->setEndPosition({endPos[0], endPos[1], endPos[2]});
-    m_sceneEuler->setEndPosition({endPos[0], endPos[1], endPos[2]});
-
-    m_sceneEuler->setStartEuler({startEuler[0], startEuler[1], startEuler[2]});
-    m_sceneEuler->setEndEuler({endEuler[0], endEuler[1], endEuler[2]});
-
-    m_sceneQuat->setStartQuaternion({startQuat[0], startQuat[1], startQuat[2], startQuat[3]});
-    m_sceneQuat->setEndQuaternion({endQuat[0], endQuat[1], endQuat[2], endQuat[3]});
-
-    m_sceneQuat->setUseSphericalInterpolation(useSpherical);
-
-    m_sceneEuler->setT(duration);
-    m_sceneQuat->setT(duration);
-
-    m_sceneQuat->start();
-    m_sceneEuler->start();
+    IGFD::FileDialogConfig config;
+    config.path = ".";
+    ImGuiFileDialog::Instance()->OpenDialog("LoadTracks", "Load Track File", ".trk", config);
+  }
+  ImGui::SameLine();
+  if (ImGui::Button("Save Tracks"))
+  {
+    IGFD::FileDialogConfig config;
+    config.path = ".";
+    config.flags = ImGuiFileDialogFlags_ConfirmOverwrite;
+    ImGuiFileDialog::Instance()->OpenDialog("SaveTracks", "Save Track File", ".trk", config);
+  }
+  if (ImGuiFileDialog::Instance()->Display("LoadTracks"))
+  {
+    if (ImGuiFileDialog::Instance()->IsOk())
+    {
+      // mapped and validated on a loader thread, a bad file is reported
+      // here rather than failing the load
+      m_loader->load("tracks", [this, path = ImGuiFileDialog::Instance()->GetFilePathName()]() -> AssetLoader::Upload {
+        try
+        {
+          auto file = std::make_shared<TrackFile>(path);
+          return [this, file] {
+            m_trackFile = file;
+            m_selectedTrack = 0;
+            m_trackError.clear();
+          };
+        }
+        catch (const std::exception &e)
+        {
+          return [this, error = std::string(e.what())] { m_trackError = error; };
+        }
+      });
+    }
+    ImGuiFileDialog::Instance()->Close();
+  }
+  if (ImGuiFileDialog::Instance()->Display("SaveTracks"))
+  {
+    if (ImGuiFileDialog::Instance()->IsOk() && m_ui.duration <= 0.0f)
+    {
+      // the end key would not come after the start key
+      m_trackError = "Interpolation duration must be positive to save a track";
+    }
+    else if (ImGuiFileDialog::Instance()->IsOk())
+    {
+      // the start/end pair from the fields above as a two key track
+      auto key = [](float time, const float *pos, const float *quat, const float *euler) {
+        return Keyframe{time,
+                        {pos[0], pos[1], pos[2]},
+                        {quat[0], quat[1], quat[2], quat[3]},
+                        {euler[0], euler[1], euler[2]},
+                        0.0f};
+      };
+      TrackData track{"ui", {key(0.0f, m_ui.startPos, m_ui.startQuat, m_ui.startEuler),
+                             key(m_ui.duration, m_ui.endPos, m_ui.endQuat, m_ui.endEuler)}};
+      try
+      {
+        TrackFile::save(ImGuiFileDialog::Instance()->GetFilePathName(), {&track, 1});
+        m_trackError.clear();
+      }
+      catch (const std::exception &e)
+      {
+        m_trackError = e.what();
+      }
+    }
+    ImGuiFileDialog::Instance()->Close();
+  }
+  if (!m_trackError.empty())
+    ImGui::TextUnformatted(m_trackError.c_str());
+  if (m_trackFile)
+  {
+    for (size_t i = 0; i < m_trackFile->getTrackCount(); ++i)
+    {
+      TrackView track = m_trackFile->getTrack(i);
+      ImGui::PushID(static_cast<int>(i));
+      const char *label = m_frameArena.format("%.*s (%zu keys)", static_cast<int>(track.name.size()),
+                                              track.name.data(), track.keys.size());
+      if (ImGui::Selectable(label, m_selectedTrack == static_cast<int>(i)))
+        m_selectedTrack = static_cast<int>(i);
+      ImGui::PopID();
+    }
+    if (ImGui::Button("Play Track") && m_trackFile->getTrackCount() > 0)
+      m_simulation->playTrack(m_trackFile, m_selectedTrack);
   }
+  if (snapshot.duration > 0.0f)
+  {
+    float playhead = snapshot.time;
+    if (ImGui::SliderFloat("Playhead", &playhead, 0.0f, snapshot.duration, "%.2f s"))
+      dispatch({UiActionType::SEEK, 0, 0, playhead});
+  }
+  if (snapshot.streaming)
+  {
+    const TrackStream::Stats &stream = snapshot.stream;
+    ImGui::Text("Chunks resident: %zu / %zu", stream.resident, stream.capacity);
+    ImGui::Text("Loads: %llu  Evictions: %llu  Stalled ticks: %llu",
+                static_cast<unsigned long long>(stream.loads),
+                static_cast<unsigned long long>(stream.evictions),
+                static_cast<unsigned long long>(stream.misses));
+    if (stream.rejected > 0)
+      ImGui::Text("Corrupt chunks skipped: %llu",
+                  static_cast<unsigned long long>(stream.rejected));
+  }
+  if (m_replayer)
+    ImGui::EndDisabled();
   ImGui::End();
   ImGui::Render();
   ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
+void Window::dispatch(const UiAction &action)
+{
+  if (m_recorder)
+  {
+    // Start consumes the parameters, record them right before it
+    if (action.type == UiActionType::START)
+      m_recorder->parameters(m_ui);
+    m_recorder->action(action);
+  }
+  applyAction(action);
+}
+
+void Window::applyAction(const UiAction &action)
+{
+  switch (action.type)
+  {
+  case UiActionType::START:
+  {
+    math137::Quaternion startQ{m_ui.startQuat[0], m_ui.startQuat[1], m_ui.startQuat[2], m_ui.startQuat[3]};
+    startQ.normalize();
+    math137::Quaternion endQ{m_ui.endQuat[0], m_ui.endQuat[1], m_ui.endQuat[2], m_ui.endQuat[3]};
+    endQ.normalize();
+    m_ui.startQuat[0] = startQ.a;
+    m_ui.startQuat[1] = startQ.b;
+    m_ui.startQuat[2] = startQ.c;
+    m_ui.startQuat[3] = startQ.d;
+    m_ui.endQuat[0] = endQ.a;
+    m_ui.endQuat[1] = endQ.b;
+    m_ui.endQuat[2] = endQ.c;
+    m_ui.endQuat[3] = endQ.d;
+    m_simulation->setTrack({{m_ui.startPos[0], m_ui.startPos[1], m_ui.startPos[2]},
+                            {m_ui.endPos[0], m_ui.endPos[1], m_ui.endPos[2]},
+                            {m_ui.startEuler[0], m_ui.startEuler[1], m_ui.startEuler[2]},
+                            {m_ui.endEuler[0], m_ui.endEuler[1], m_ui.endEuler[2]},
+                            {startQ.a, startQ.b, startQ.c, startQ.d},
+                            {endQ.a, endQ.b, endQ.c, endQ.d},
+                            m_ui.duration});
+    break;
+  }
+  case UiActionType::ADD_PANEL:
+    m_simulation->addPanel(static_cast<InterpolationMethod>(action.value));
+    break;
+  case UiActionType::REMOVE_PANEL:
+    m_simulation->removePanel(action.id);
+    break;
+  case UiActionType::SET_METHOD:
+    m_simulation->setMethod(action.id, static_cast<InterpolationMethod>(action.value));
+    break;
+  case UiActionType::GHOST_FRAMES:
+    m_showAllFrames = action.amount != 0.0f;
+    m_intermediateFrames = action.value;
+    m_simulation->setGhostFrames(m_showAllFrames, m_intermediateFrames);
+    break;
+  case UiActionType::GHOST_SPACING:
+    m_arcLengthGhosts = action.value != 0;
+    m_simulation->setGhostSpacing(m_arcLengthGhosts ? GhostSpacing::ARC_LENGTH : GhostSpacing::TIME);
+    break;
+  case UiActionType::CONSTANT_SPEED:
+    m_constantSpeed = action.value != 0;
+    m_simulation->setConstantSpeed(m_constantSpeed);
+    break;
+  case UiActionType::TRAIL:
+    // a new length only applies to trails created after dropping these
+    if (action.value != m_trailLength || action.amount == 0.0f)
+      m_trails.clear();
+    m_showTrail = action.amount != 0.0f;
+    m_trailLength = action.value;
+    break;
+  case UiActionType::TRAIL_RIBBON:
+    m_trailRibbon = action.value != 0;
+    break;
+  case UiActionType::SKELETON:
+    m_skeletonJoints = action.value;
+    m_simulation->setSkeleton(static_cast<size_t>(m_skeletonJoints));
+    break;
+  case UiActionType::ARC_LENGTH_BUDGET:
+    m_arcLengthBudgetKb = action.value;
+    m_simulation->setArcLengthBudget(static_cast<size_t>(m_arcLengthBudgetKb) * 1024);
+    break;
+  case UiActionType::LOD_MODE:
+    m_cursorBatch->setLodMode(static_cast<LodMode>(action.value));
+    break;
+  case UiActionType::CULLING:
+    m_cursorBatch->setCulling(action.value != 0);
+    break;
+  case UiActionType::TICK_RATE:
+    m_simulation->setTickRate(action.amount);
+    break;
+  case UiActionType::SEEK:
+    m_simulation->seek(action.amount);
+    break;
+  // pacing and resolution only change how fast frames come out, a replay
+  // keeps running unpaced at full resolution
+  case UiActionType::PRESENT_MODE:
+    if (!m_replayer)
+      m_pacer.setPresentMode(static_cast<PresentMode>(action.value));
+    break;
+  case UiActionType::TARGET_RATE:
+    if (!m_replayer)
+      m_pacer.setTargetRate(std::max(action.amount, 0.0f));
+    break;
+  case UiActionType::LATE_SAMPLING:
+    if (!m_replayer)
+      m_pacer.setLateSampling(action.value != 0);
+    break;
+  case UiActionType::DYNAMIC_RESOLUTION:
+    if (!m_replayer)
+      m_resolution->setEnabled(action.value != 0);
+    break;
+  case UiActionType::GPU_BUDGET:
+    m_resolution->setBudget(std::max(action.amount, 0.5f));
+    break;
+  }
+}
+
 void Window::keyInputCallback(GLFWwindow *window, int key, int scancode,
                               int action, int mods)
 {
@@ -390,11 +940,7 @@ void Window::cursorPositionCallback(GLFWwindow *window, double xpos,
 {
   ImGui_ImplGlfw_CursorPosCallback(window, xpos, ypos);
   Window *w = reinterpret_cast<Window *>(glfwGetWindowUserPointer(window));
-  static double x, y;
-  if (w->m_clicked)
-    w->m_camera.rotateCamera(x - xpos, y - ypos);
-  x = xpos;
-  y = ypos;
+  w->pushInput({InputEventType::CURSOR_MOVE, xpos, ypos, 0, 0, glfwGetTime()});
 }
 
 void Window::mouseButtonCallback(GLFWwindow *window, int button, int action,
@@ -404,9 +950,7 @@ void Window::mouseButtonCallback(GLFWwindow *window, int button, int action,
   if (ImGui::GetIO().WantCaptureMouse)
     return;
   Window *w = reinterpret_cast<Window *>(glfwGetWindowUserPointer(window));
-  double x, y;
-  glfwGetCursorPos(window, &x, &y);
-  w->m_clicked = (button == GLFW_MOUSE_BUTTON_1 && action == GLFW_PRESS);
+  w->pushInput({InputEventType::MOUSE_BUTTON, 0.0, 0.0, button, action, glfwGetTime()});
 }
 
 void Window::scrollInputCallback(GLFWwindow *window, double xOffset,
@@ -416,6 +960,22 @@ void Window::scrollInputCallback(GLFWwindow *window, double xOffset,
   if (ImGui::GetIO().WantCaptureMouse)
     return;
   Window *w = reinterpret_cast<Window *>(glfwGetWindowUserPointer(window));
-  w->m_camera.changeDistance(0.8f * yOffset);
+  w->pushInput({InputEventType::SCROLL, xOffset, yOffset, 0, 0, glfwGetTime()});
+}
+
+void Window::pushInput(const InputEvent &event)
+{
+  if (m_replayer)
+    return;
+  if (!m_inputQueue.push(event))
+    ++m_droppedInputEvents;
+}
+void Window::resizeWindowCallback(GLFWwindow *window, int width, int height)
+{
+  // minimized windows report an empty framebuffer, keep the last real size
+  if (width <= 0 || height <= 0)
+    return;
+  Window *w = reinterpret_cast<Window *>(glfwGetWindowUserPointer(window));
+  w->m_width = width;
+  w->m_height = height;
 }
-void Window::resizeWindowCallback(GLFWwindow *window, int width, int height) {}
@@ -1,14 +1,31 @@
 #pragma once
 
+#include "AssetLoader.hpp"
+#include "Bvh.hpp"
 #include "Camera.hpp"
 #include "Renderer.hpp"
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstdint>
+#include <fstream>
 #include <memory>
+#include <optional>
 #include <string>
-#include "Scene.hpp"
+#include <unordered_map>
+#include <vector>
+#include "CursorBatch.hpp"
+#include "DynamicResolution.hpp"
+#include "FrameArena.hpp"
+#include "FramePacer.hpp"
+#include "GlDebug.hpp"
+#include "InputQueue.hpp"
+#include "Recording.hpp"
+#include "Simulation.hpp"
+#include "Ground.hpp"
+#include "Trail.hpp"
 
 class GLFWwindowDeleter {
 public:
@@ -17,11 +34,17 @@ public:
 
 class Window {
 public:
-  Window(uint16_t width, uint16_t height, std::string title);
+  Window(uint16_t width, uint16_t height, std::string title,
+         const RecordingOptions &recording = {},
+         GlDebugMode glDebug = c_defaultGlDebugMode);
   ~Window();
 
   void update(bool &running);
   void draw();
+  // frames past the warmup whose draw reached the heap, with the
+  // allocations they made, always zero without COUNT_ALLOCATIONS
+  inline uint64_t getAllocatingFrames() const { return m_allocatingFrames; }
+  inline uint64_t getMeasuredAllocations() const { return m_measuredAllocations; }
 
 public:
   static void scrollInputCallback(GLFWwindow *window, double xOffset,
@@ -35,17 +58,116 @@ public:
   static void resizeWindowCallback(GLFWwindow *window, int width, int height);
 
 private:
-  void renderImgui(float dt);
+  void renderImgui(float dt, const SimulationSnapshot &snapshot);
+  // the frame shown until the renderer and the meshes are uploaded
+  void drawLoading();
+  // milliseconds since the constructor started
+  double sinceStart() const;
+  void processInput();
+  void pushInput(const InputEvent &event);
+  // appends every panel's pose to its trail, dropping the trails of removed
+  // panels and restarting all of them when the playhead jumped back
+  void updateTrails(const SimulationSnapshot &snapshot);
+  // keeps every panel's hierarchy in step with what it draws, rebuilt when
+  // the set of objects changed and refit when they only moved
+  void updatePicking(const SimulationSnapshot &snapshot);
+  // selects the nearest object under the mouse cursor
+  void pick(const SimulationSnapshot &snapshot);
+  // records the action when recording, then applies it
+  void dispatch(const UiAction &action);
+  void applyAction(const UiAction &action);
+  // the recorded clock during replay, glfwGetTime otherwise
+  double now() const;
+
+  // seconds from the oldest coalesced event to the camera update and to the
+  // buffer swap of the frame that used it
+  struct InputLatency {
+    double applied;
+    double presented;
+    double maxPresented;
+  };
+
+  // what a panel draws, in object order: the cursor, its ghost frames, then
+  // the joints of its rig
+  struct Pickables {
+    Bvh bvh;
+    std::vector<BoundingSphere> bounds;
+    std::shared_ptr<const GhostSamples> ghosts;
+    size_t joints{0};
+  };
+  struct Selection {
+    uint32_t panel;
+    uint32_t object;
+    float distance;
+  };
 
 private:
   std::unique_ptr<GLFWwindow, GLFWwindowDeleter> m_window;
+  std::unique_ptr<AssetLoader> m_loader;
+  std::chrono::steady_clock::time_point m_startTime;
+  // time to the first swap, loading screen or not, and to the first frame
+  // drawing the scene, negative until then
+  double m_firstFrameMs{-1.0};
+  double m_interactiveMs{-1.0};
+  // decided once per frame by update, so a frame is either recorded and
+  // drawn in full or neither, and replays line up with the recording
+  bool m_loading{true};
   std::unique_ptr<Renderer> m_renderer;
-  std::unique_ptr<Scene> m_sceneQuat;
-  std::unique_ptr<Scene> m_sceneEuler;
+  // one panel per scene, tiled in registration order
+  std::unique_ptr<Simulation> m_simulation;
+  std::vector<Viewport> m_viewports;
+  std::unique_ptr<MeshPool> m_meshPool;
+  std::unique_ptr<CursorBatch> m_cursorBatch;
+  std::unique_ptr<Ground> m_ground;
+  std::unique_ptr<DynamicResolution> m_resolution;
   Camera m_camera;
   float m_t;
   int m_height, m_width;
   bool m_clicked;
+  FramePacer m_pacer;
+  InputQueue m_inputQueue;
+  std::atomic<uint32_t> m_droppedInputEvents{0};
+  double m_cursorX{0.0}, m_cursorY{0.0};
+  double m_pendingInputTime{-1.0};
+  InputLatency m_inputLatency{};
   bool m_showAllFrames{false};
   int m_intermediateFrames{5};
+  bool m_arcLengthGhosts{false};
+  bool m_constantSpeed{false};
+  int m_skeletonJoints{0};
+  bool m_showTrail{false};
+  bool m_trailRibbon{false};
+  int m_trailLength{static_cast<int>(Trail::c_defaultCapacity)};
+  // by panel id
+  std::unordered_map<uint32_t, std::unique_ptr<Trail>> m_trails;
+  float m_trailTime{0.0f};
+  size_t m_trailUploadBytes{0};
+  // by panel id
+  std::unordered_map<uint32_t, Pickables> m_pickables;
+  std::optional<Selection> m_selection;
+  // a left click that did not drag, resolved by the next draw
+  bool m_pickPending{false};
+  double m_pressX{0.0}, m_pressY{0.0};
+  double m_pickTime{0.0};
+  int m_arcLengthBudgetKb{static_cast<int>(ArcLengthTable::c_defaultSteps * ArcLengthTable::c_bytesPerStep / 1024)};
+  int m_culledTracks{0};
+  std::shared_ptr<TrackFile> m_trackFile;
+  int m_selectedTrack{0};
+  std::string m_trackError;
+  UiParameters m_ui;
+  std::unique_ptr<GlDebug> m_glDebug;
+  std::unique_ptr<Recorder> m_recorder;
+  std::unique_ptr<Replayer> m_replayer;
+  ReplayFrame m_replayFrame{};
+  bool m_replayFinished{false};
+  std::ofstream m_frameLog;
+  uint64_t m_frame{0};
+  // transient data of the current frame, reset at the start of draw
+  FrameArena m_frameArena;
+  // heap allocations of the previous frame on all threads, only counted
+  // with COUNT_ALLOCATIONS
+  uint64_t m_frameAllocations{0};
+  uint64_t m_frameAllocatedBytes{0};
+  uint64_t m_allocatingFrames{0};
+  uint64_t m_measuredAllocations{0};
 };
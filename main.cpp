@@ -1,7 +1,55 @@
 #include "core/App.hpp"
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
 
-int main() {
-    App app;
-    app.run();
-    return 0;
+int main(int argc, char **argv) {
+    // --record <log>, --replay <log>, --frame-log <csv>,
+    // --gl-debug off|async|sync and --expect-zero-allocations
+    RecordingOptions recording;
+    GlDebugMode glDebug = c_defaultGlDebugMode;
+    std::string glDebugName;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--expect-zero-allocations") {
+            recording.expectZeroAllocations = true;
+            continue;
+        }
+        std::string *target = nullptr;
+        if (arg == "--record")
+            target = &recording.recordPath;
+        else if (arg == "--replay")
+            target = &recording.replayPath;
+        else if (arg == "--frame-log")
+            target = &recording.frameLogPath;
+        else if (arg == "--gl-debug")
+            target = &glDebugName;
+        if (!target || i + 1 == argc) {
+            std::cerr << "usage: " << argv[0]
+                      << " [--record <log> | --replay <log>] [--frame-log <csv>]"
+                         " [--gl-debug off|async|sync] [--expect-zero-allocations]\n";
+            return 1;
+        }
+        *target = argv[++i];
+    }
+
+    if (!glDebugName.empty()) {
+        try {
+            glDebug = parseGlDebugMode(glDebugName);
+        } catch (const std::invalid_argument &error) {
+            std::cerr << error.what() << "\n";
+            return 1;
+        }
+    }
+
+#ifndef COUNT_ALLOCATIONS
+    if (recording.expectZeroAllocations) {
+        std::cerr << "--expect-zero-allocations needs a build with "
+                     "INTERPOLATION_COUNT_ALLOCATIONS\n";
+        return 1;
+    }
+#endif
+
+    App app(recording, glDebug);
+    return app.run();
 }
\ No newline at end of file
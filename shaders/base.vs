@@ -1,13 +1,21 @@
 #version 460 core
+#extension GL_ARB_shader_viewport_layer_array : enable
 layout (location = 0) in vec3 aPos;
 
+const int MAX_VIEWPORTS = 16;
+
 uniform mat4 model;
 uniform mat4 view;
-uniform mat4 projection;
+uniform mat4 projection[MAX_VIEWPORTS];
+// index of the viewport to draw into, negative broadcasts one instance per viewport
+uniform int viewportIndex;
+uniform int viewportCount;
 
 void main()
 {
-	gl_Position = projection * view * model * vec4(aPos, 1.0f);
+	int index = viewportIndex < 0 ? gl_InstanceID % viewportCount : viewportIndex;
+	gl_Position = projection[index] * view * model * vec4(aPos, 1.0f);
+#ifdef GL_ARB_shader_viewport_layer_array
+	gl_ViewportIndex = index;
+#endif
 }
-
-
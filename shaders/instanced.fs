@@ -0,0 +1,8 @@
+#version 460 core
+in vec4 vColor;
+out vec4 fragColor;
+
+void main()
+{
+  fragColor = vColor;
+}
@@ -0,0 +1,40 @@
+#version 460 core
+#extension GL_ARB_shader_viewport_layer_array : enable
+layout (location = 0) in vec3 aPos;
+
+const int MAX_VIEWPORTS = 16;
+
+// mirrors CursorInstance: rotation holds a SNORM16 quaternion (x, y, z, w),
+// color RGBA8
+struct Instance
+{
+	vec3 translation;
+	uint color;
+	uvec2 rotation;
+	int viewport;
+	int padding;
+};
+
+layout (std430, binding = 0) readonly buffer Instances
+{
+	Instance instances[];
+};
+
+uniform mat4 view;
+uniform mat4 projection[MAX_VIEWPORTS];
+
+out vec4 vColor;
+
+void main()
+{
+	Instance instance = instances[gl_BaseInstance + gl_InstanceID];
+	vColor = unpackUnorm4x8(instance.color);
+	vec4 q = normalize(vec4(unpackSnorm2x16(instance.rotation.x), unpackSnorm2x16(instance.rotation.y)));
+	// q * p * q^-1 for a unit quaternion
+	vec3 t = 2.0f * cross(q.xyz, aPos);
+	vec3 position = aPos + q.w * t + cross(q.xyz, t) + instance.translation;
+	gl_Position = projection[instance.viewport] * view * vec4(position, 1.0f);
+#ifdef GL_ARB_shader_viewport_layer_array
+	gl_ViewportIndex = instance.viewport;
+#endif
+}
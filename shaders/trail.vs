@@ -0,0 +1,45 @@
+#version 460 core
+#extension GL_ARB_shader_viewport_layer_array : enable
+
+const int MAX_VIEWPORTS = 16;
+
+struct Point
+{
+	vec4 position;
+	// the cursor axis the ribbon spans
+	vec4 axis;
+};
+
+layout (std430, binding = 0) readonly buffer Points
+{
+	Point points[];
+};
+
+uniform mat4 view;
+uniform mat4 projection[MAX_VIEWPORTS];
+uniform int viewportIndex;
+// the ring: slot of the oldest point, valid points and slots
+uniform int first;
+uniform int count;
+uniform int capacity;
+// half the ribbon width, zero draws a line strip of one vertex per point
+uniform float halfWidth;
+uniform vec4 color;
+
+out vec4 vColor;
+
+void main()
+{
+	bool ribbon = halfWidth > 0.0;
+	int age = ribbon ? gl_VertexID / 2 : gl_VertexID;
+	Point point = points[(first + age) % capacity];
+	vec3 position = point.position.xyz;
+	if (ribbon)
+		position += point.axis.xyz * (gl_VertexID % 2 == 0 ? -halfWidth : halfWidth);
+	// fades out towards the oldest point
+	vColor = vec4(color.rgb, color.a * float(age + 1) / float(count));
+	gl_Position = projection[viewportIndex] * view * vec4(position, 1.0f);
+#ifdef GL_ARB_shader_viewport_layer_array
+	gl_ViewportIndex = viewportIndex;
+#endif
+}